@@ -3,8 +3,8 @@
 
 #include "GameSystem.h"
 #include "SpaceSystem.h"
-#include "BlockPack.h"
 
+#include "ChunkLock.h"
 #include "VoxelSpaceConversions.h"
 
 void AABBCollidableComponentUpdater::update(GameSystem* gameSystem, SpaceSystem* spaceSystem) {
@@ -26,72 +26,61 @@ void AABBCollidableComponentUpdater::collideWithVoxels(AabbCollidableComponent&
     
     i32v3 bounds(vmath::ceil(f64v3(cmp.box) + vmath::fract(vpos)));
     ChunkGrid& grid = sphericalVoxel.chunkGrids[position.gridPosition.face];
-    const BlockPack* bp = sphericalVoxel.blockPack;
 
-    std::map<ChunkID, std::vector<ui16>> boundedVoxels;
+    // Read lock every chunk that the box and its neighbor checks can touch
+    // up front, rather than swapping locks as the checks cross chunks
+    i32v3 minChunk = VoxelSpaceConversions::voxelToChunk(vp - i32v3(1));
+    i32v3 chunkDims = VoxelSpaceConversions::voxelToChunk(vp + bounds) - minChunk + i32v3(1);
+    std::vector<ChunkHandle> handles;
+    std::vector<Chunk*> chunks; ///< Null if not generated
+    handles.reserve(chunkDims.x * chunkDims.y * chunkDims.z);
+    chunks.reserve(handles.capacity());
+    MultiChunkLock lock;
+    for (int y = 0; y < chunkDims.y; y++) {
+        for (int z = 0; z < chunkDims.z; z++) {
+            for (int x = 0; x < chunkDims.x; x++) {
+                handles.push_back(grid.accessor.acquire(ChunkID(minChunk + i32v3(x, y, z))));
+                Chunk* chunk = handles.back();
+                if (chunk->genLevel == GEN_DONE) {
+                    lock.add(chunk, ChunkLockMode::READ);
+                    chunks.push_back(chunk);
+                } else {
+                    chunks.push_back(nullptr);
+                }
+            }
+        }
+    }
+    lock.lock();
+
+    auto getChunk = [&](const ChunkID& id) {
+        i32v3 offset((i32)id.x - minChunk.x, (i32)id.y - minChunk.y, (i32)id.z - minChunk.z);
+        return chunks[(offset.y * chunkDims.z + offset.z) * chunkDims.x + offset.x];
+    };
+    auto collides = [&](const ChunkID& id, int index) {
+        Chunk* chunk = getChunk(id);
+        return chunk && chunk->collidable.get((ui16)index);
+    };
 
-    // Get bounded voxels
+    // Find collidable voxels. Only hits read the block container.
     for (int yi = 0; yi < bounds.y; yi++) {
         for (int zi = 0; zi < bounds.z; zi++) {
             for (int xi = 0; xi < bounds.x; xi++) {
                 i32v3 p = vp + i32v3(xi, yi, zi);
                 i32v3 cpos = VoxelSpaceConversions::voxelToChunk(p);
-                // TODO(Ben): Negative numbers?
                 ChunkID chunkID(cpos);
+                Chunk* chunk = getChunk(chunkID);
+                if (!chunk || chunk->collidable.empty()) continue;
                 i32v3 cp = p - cpos * CHUNK_WIDTH;
-                boundedVoxels[chunkID].push_back(cp.y * CHUNK_LAYER + cp.z * CHUNK_WIDTH + cp.x);
-            }
-        }
-    }
-
-    // Find Collidable voxels
-    for (auto& it : boundedVoxels) {
-        ChunkHandle chunk = grid.accessor.acquire(it.first);
-        if (chunk->genLevel == GEN_DONE) {
-            std::lock_guard<std::mutex> l(chunk->dataMutex);
-            for (auto& i : it.second) {
-                BlockID id = chunk->blocks.get(i);
-                if (bp->operator[](id).collide) {
-                    // TODO(Ben): Don't need to look up every time.
-                    cmp.voxelCollisions[it.first].emplace_back(id, i);
+                ui16 i = (ui16)(cp.y * CHUNK_LAYER + cp.z * CHUNK_WIDTH + cp.x);
+                if (chunk->collidable.get(i)) {
+                    cmp.voxelCollisions[chunkID].emplace_back(chunk->blocks.get(i), i);
                 }
             }
         }
-        chunk.release();
-    }
-
-    // Helper macro for below code
-#define CHECK_CODE(dir) \
-    /* Acquire new chunk if needed */ \
-    if (id != currentID) { \
-        /* Release current chunk */ \
-        if (chunk.isAquired()) { \
-            chunk->dataMutex.unlock(); \
-            chunk.release(); \
-        } \
-        chunk = grid.accessor.acquire(id); \
-        if (chunk->genLevel != GEN_DONE) { \
-            chunk.release(); \
-            currentID = ChunkID(0xffffffffffffffffu); \
-        } else { \
-            chunk->dataMutex.lock(); \
-            currentID = id; \
-            /* Check the voxel */ \
-            if (chunk->genLevel == GEN_DONE && bp->operator[](chunk->blocks.get(index)).collide) { \
-                cd.##dir = true; \
-            } \
-        } \
-    } else {\
-        /* Check the voxel */ \
-        if (chunk->genLevel == GEN_DONE && bp->operator[](chunk->blocks.get(index)).collide) { \
-            cd.##dir = true; \
-        } \
     }
 
     // Set neighbor collide flags
     // TODO(Ben): More than top
-    ChunkID currentID(0xffffffffffffffffu);
-    ChunkHandle chunk;
     for (auto& it : cmp.voxelCollisions) {
         for (auto& cd : it.second) {
             { // Left
@@ -103,7 +92,7 @@ void AABBCollidableComponentUpdater::collideWithVoxels(AabbCollidableComponent&
                 } else {
                     index--;
                 }
-                CHECK_CODE(left);
+                if (collides(id, index)) cd.left = true;
             }
             { // Right
                 ChunkID id = it.first;
@@ -114,7 +103,7 @@ void AABBCollidableComponentUpdater::collideWithVoxels(AabbCollidableComponent&
                 } else {
                     index++;
                 }
-                CHECK_CODE(right);
+                if (collides(id, index)) cd.right = true;
             }
             { // Bottom
                 ChunkID id = it.first;
@@ -125,7 +114,7 @@ void AABBCollidableComponentUpdater::collideWithVoxels(AabbCollidableComponent&
                 } else {
                     index -= CHUNK_LAYER;
                 }
-                CHECK_CODE(bottom);
+                if (collides(id, index)) cd.bottom = true;
             }
             { // Top
                 ChunkID id = it.first;
@@ -136,7 +125,7 @@ void AABBCollidableComponentUpdater::collideWithVoxels(AabbCollidableComponent&
                 } else {
                     index += CHUNK_LAYER;
                 }
-                CHECK_CODE(top);
+                if (collides(id, index)) cd.top = true;
             }
             { // Back
                 ChunkID id = it.first;
@@ -147,7 +136,7 @@ void AABBCollidableComponentUpdater::collideWithVoxels(AabbCollidableComponent&
                 } else {
                     index -= CHUNK_WIDTH_M1;
                 }
-                CHECK_CODE(back);
+                if (collides(id, index)) cd.back = true;
             }
             { // Front
                 ChunkID id = it.first;
@@ -158,14 +147,12 @@ void AABBCollidableComponentUpdater::collideWithVoxels(AabbCollidableComponent&
                 } else {
                     index += CHUNK_WIDTH_M1;
                 }
-                CHECK_CODE(front);
+                if (collides(id, index)) cd.front = true;
             }
         }
     }
-    // Release chunk if needed
-    if (chunk.isAquired()) {
-        chunk->dataMutex.unlock();
-        chunk.release();
+    lock.unlock();
+    for (auto& h : handles) {
+        h.release();
     }
-#undef CHECK_CODE
-}
+}
\ No newline at end of file
@@ -19,6 +19,9 @@ KEG_TYPE_DEF_SAME_NAME(Block, kt) {
     kt.addValue("ID", keg::Value::basic(offsetof(Block, temp), keg::BasicType::I32));
     kt.addValue("name", keg::Value::basic(offsetof(Block, name), keg::BasicType::STRING));
     kt.addValue("burnTransformID", keg::Value::basic(offsetof(Block, burnTransformID), keg::BasicType::STRING));
+    kt.addValue("coveredTransformID", keg::Value::basic(offsetof(Block, coveredTransformID), keg::BasicType::STRING));
+    kt.addValue("spreadTargetID", keg::Value::basic(offsetof(Block, spreadTargetID), keg::BasicType::STRING));
+    kt.addValue("snowCoverID", keg::Value::basic(offsetof(Block, snowCoverID), keg::BasicType::STRING));
     kt.addValue("waveEffect", keg::Value::basic(offsetof(Block, waveEffect), keg::BasicType::I16));
     kt.addValue("lightColor", keg::Value::basic(offsetof(Block, lightColor), keg::BasicType::UI8_V3));
     kt.addValue("caPhysics", keg::Value::basic(offsetof(Block, caFilePath), keg::BasicType::STRING));
@@ -28,6 +31,7 @@ KEG_TYPE_DEF_SAME_NAME(Block, kt) {
     kt.addValue("spawnID", keg::Value::basic(offsetof(Block, spawnerID), keg::BasicType::STRING));
     kt.addValue("sinkID", keg::Value::basic(offsetof(Block, sinkID), keg::BasicType::STRING));
     kt.addValue("explosionRays", keg::Value::basic(offsetof(Block, explosionRays), keg::BasicType::UI16));
+    kt.addValue("floraHeight", keg::Value::basic(offsetof(Block, floraHeight), keg::BasicType::UI16));
     kt.addValue("meshType", keg::Value::custom(offsetof(Block, meshType), "MeshType", true));
     kt.addValue("moveMod", keg::Value::basic(offsetof(Block, moveMod), keg::BasicType::F32));
     kt.addValue("explosionResistance", keg::Value::basic(offsetof(Block, explosionResistance), keg::BasicType::F32));
@@ -44,6 +48,8 @@ KEG_TYPE_DEF_SAME_NAME(Block, kt) {
     kt.addValue("allowsLight", keg::Value::basic(offsetof(Block, allowLight), keg::BasicType::BOOL));
     kt.addValue("crushable", keg::Value::basic(offsetof(Block, isCrushable), keg::BasicType::BOOL));
     kt.addValue("supportive", keg::Value::basic(offsetof(Block, isSupportive), keg::BasicType::BOOL));
+    kt.addValue("randomTick", keg::Value::basic(offsetof(Block, randomTick), keg::BasicType::BOOL));
+    kt.addValue("fire", keg::Value::basic(offsetof(Block, isFire), keg::BasicType::BOOL));
 }
 
 // TODO(Ben): LOL
@@ -73,6 +79,7 @@ lightColor(0, 0, 0) {
     floatingAction = 1;
     flammability = 0.0f;
     isSupportive = true;
+    randomTick = false;
     explosivePower = 0.0;
     explosionPowerLoss = 0.0;
     explosionRays = 0;
@@ -67,7 +67,14 @@ class Block
     BlockIdentifier sID;
     nString name;
     BlockID ID;
-    nString burnTransformID;
+    nString burnTransformID; ///< Block this turns into when it burns. Fire turns into it when it goes out.
+    nString coveredTransformID; ///< Block this turns into when something opaque covers it
+    nString spreadTargetID; ///< Exposed blocks of this kind next to it are turned into it
+    nString snowCoverID; ///< Block that settles on top of this one when it is cold and open to the sky
+    BlockID burnTransform = 0; ///< Resolved burnTransformID, 0 for none. Burning blocks without one catch fire.
+    BlockID coveredTransform = 0; ///< Resolved coveredTransformID, 0 for none
+    BlockID spreadTarget = 0; ///< Resolved spreadTargetID, 0 for none
+    BlockID snowCover = 0; ///< Resolved snowCoverID, 0 for none
     i16 waveEffect;
     ui16 lightColorPacked; /// 5 bit RGB light color packed into a ui16
     i16 waterMeshLevel;
@@ -75,7 +82,7 @@ class Block
     nString spawnerID;
     nString sinkID;
     ui16 explosionRays;
-    ui16 floraHeight = 0;
+    ui16 floraHeight = 0; ///< Plants taller than 1 grow up to this many voxels
     ui16 liquidStartID = 0;
     ui16 liquidLevels = 0;
 
@@ -105,6 +112,9 @@ class Block
     bool isCrushable;
     bool isSupportive;
     bool active;
+    bool randomTick; ///< Gets random block ticks, see ChunkUpdater::randomBlockUpdates
+    bool isFire = false; ///< Burns flammable neighbors and goes out once none are left
+    bool isSnowCover = false; ///< Some block's snowCover, melts when its column warms up
 
     union {
         struct {
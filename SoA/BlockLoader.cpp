@@ -49,6 +49,7 @@ bool BlockLoader::loadBlocks(const vio::IOManager& iom, BlockPack* pack) {
         }
     }
     pack->onBlockAddition -= bpp.del;
+    resolveBlockReferences(pack);
 
     saveMapping(iom, BLOCK_MAPPING_PATH, pack);
     if (!useCache) {
@@ -97,7 +98,9 @@ bool BlockLoader::saveBlocks(const nString& filePath, BlockPack* pack) {
         COND_WRITE_KEG("explosionPowerLoss", explosionPowerLoss);
         COND_WRITE_KEG("explosionRays", explosionRays);
         COND_WRITE_KEG("explosionResistance", explosionResistance);
+        COND_WRITE_KEG("fire", isFire);
         COND_WRITE_KEG("flammability", flammability);
+        COND_WRITE_KEG("floraHeight", floraHeight);
         COND_WRITE_KEG("floatingAction", floatingAction);
         if (b.colorFilter != d.colorFilter) { writer.push(keg::WriterParam::KEY) << nString("lightColorFilter"); writer.push(keg::WriterParam::VALUE) << keg::kegf32v3(b.colorFilter); }
         if (b.meshType != d.meshType) {
@@ -128,6 +131,11 @@ bool BlockLoader::saveBlocks(const nString& filePath, BlockPack* pack) {
         }
         COND_WRITE_KEG("moveMod", moveMod);
         COND_WRITE_KEG("name", name);
+        COND_WRITE_KEG("randomTick", randomTick);
+        COND_WRITE_KEG("coveredTransformID", coveredTransformID);
+        COND_WRITE_KEG("spreadTargetID", spreadTargetID);
+        COND_WRITE_KEG("burnTransformID", burnTransformID);
+        COND_WRITE_KEG("snowCoverID", snowCoverID);
         switch (b.occlude) {
             case BlockOcclusion::NONE:
                 writer.push(keg::WriterParam::KEY) << nString("occlusion");
@@ -239,6 +247,41 @@ void GameBlockPostProcess::invoke(Sender s, ui16 id) {
     }
 }
 
+void BlockLoader::resolveBlockReferences(BlockPack* pack) {
+    for (size_t i = 0; i < pack->size(); i++) {
+        Block& block = pack->operator[](i);
+        if (block.coveredTransformID.length()) {
+            const Block* target = pack->hasBlock(block.coveredTransformID);
+            if (target) block.coveredTransform = target->ID;
+        }
+        if (block.spreadTargetID.length()) {
+            const Block* target = pack->hasBlock(block.spreadTargetID);
+            if (target) block.spreadTarget = target->ID;
+        }
+        if (block.burnTransformID.length()) {
+            const Block* target = pack->hasBlock(block.burnTransformID);
+            if (target) block.burnTransform = target->ID;
+        }
+        if (block.snowCoverID.length()) {
+            const Block* target = pack->hasBlock(block.snowCoverID);
+            if (target) block.snowCover = target->ID;
+        }
+        // These behaviors all run on random ticks
+        if (block.coveredTransform || block.spreadTarget || block.snowCover ||
+            block.isFire || block.floraHeight > 1) {
+            block.randomTick = true;
+        }
+    }
+    // Snow covers tick too so they can melt
+    for (size_t i = 0; i < pack->size(); i++) {
+        const Block& block = pack->operator[](i);
+        if (!block.snowCover) continue;
+        Block& cover = pack->operator[](block.snowCover);
+        cover.isSnowCover = true;
+        cover.randomTick = true;
+    }
+}
+
 bool BlockLoader::saveMapping(const vio::IOManager& iom, const cString filePath, BlockPack* pack) {    
     vio::FileStream fs = iom.openFile(filePath, vio::FileOpenFlags::WRITE_ONLY_CREATE);
     if (!fs.isOpened()) pError("Failed to open block mapping file for save");
@@ -47,6 +47,9 @@ class BlockLoader
     /// @param blocks: Output list for blocks
     static void SetWaterBlocks(std::vector<Block>& blocks);
 
+    /// Resolves blocks that refer to other blocks by name, once all are loaded
+    static void resolveBlockReferences(BlockPack* pack);
+
     /// Saves the block mapping scheme
     static bool saveMapping(const vio::IOManager& iom, const cString filePath, BlockPack* pack);
 
@@ -5,10 +5,15 @@
 
 #include "BlockPack.h"
 #include "Chunk.h"
-#include "ChunkUpdater.h"
-#include "GameManager.h"
+#include "VoxelLightEngine.h"
 #include "VoxelUtils.h"
 
+#define GETBLOCK(a) m_blocks->operator[](a)
+
+#define FACE_Y_NEG 2
+// -x, +x, -z, +z
+const int SIDE_FACES[4] = { 0, 1, 4, 5 };
+
 CaPhysicsTypeDict CaPhysicsType::typesCache;
 CaPhysicsTypeList CaPhysicsType::typesArray;
 
@@ -26,9 +31,8 @@ KEG_TYPE_DEF_SAME_NAME(CaPhysicsData, kt) {
 
 bool CaPhysicsType::update() {
     _ticks++;
-    if (_ticks == _data.updateRate * HALF_CA_TICK_RES) {
+    if (_ticks >= _data.updateRate) {
         _ticks = 0;
-        _isEven = !_isEven;
         return true;
     }
     return false;
@@ -61,577 +65,239 @@ void CaPhysicsType::clearTypes() {
     typesArray.clear();
 }
 
-CAEngine::CAEngine(ChunkManager* chunkManager, PhysicsEngine* physicsEngine) :
-    m_chunkManager(chunkManager),
-    m_physicsEngine(physicsEngine){
-    memset(_blockUpdateFlagList, 0, sizeof(_blockUpdateFlagList));
-    //temporary
-    _lowIndex = 0; // TODO(Ben): yeahhhhhh....
-    _range = 100;
-    _highIndex = _lowIndex + _range - 1;
+void CAEngine::activateVoxel(Chunk* chunk, int blockIndex, const BlockPack* blocks) {
+    if (blocks->operator[](chunk->blocks.get(blockIndex)).caIndex >= 0) {
+        chunk->caActive.insert((ui16)blockIndex);
+    }
 }
 
-void CAEngine::updateSpawnerBlocks(bool powders)
-{
-    //_lockedChunk = nullptr;
-    //int spawnerVal;
-    //int sinkVal;
-    //int c;
-    //f64v3 physicsBlockPos;
-    //std::vector <GLushort> &activeBlocks = _chunk->spawnerBlocks;
-
-    //Chunk *bottom = _chunk->bottom;
-
-    //for (size_t i = 0; i < activeBlocks.size();){
-    //    c = activeBlocks[i];
-
-    //    const Block &block = _chunk->getBlock(c);
-
-    //    spawnerVal = block.spawnerVal;
-    //    sinkVal = block.sinkVal;
-    //    if (spawnerVal == 0 && sinkVal == 0){
-    //        activeBlocks[i] = activeBlocks.back();
-    //        activeBlocks.pop_back();
-    //        continue;
-    //    }
-    //    if (spawnerVal){
-    //        if (vvox::getBottomBlockData(_chunk, _lockedChunk, c) == 0){
-    //            if (c >= CHUNK_LAYER){
-    //                c = c - CHUNK_LAYER;
-    //                if (spawnerVal >= LOWWATER) {
-    //                    ChunkUpdater::placeBlock(_chunk, _lockedChunk, c, spawnerVal);
-    //                } else if (powders){
-    //                    physicsBlockPos = f64v3((double)_chunk->voxelPosition.x + c%CHUNK_WIDTH + 0.5, (double)_chunk->voxelPosition.y + c / CHUNK_LAYER, (double)_chunk->voxelPosition.z + (c%CHUNK_LAYER) / CHUNK_WIDTH + 0.5);
-    //                    m_physicsEngine->addPhysicsBlock(physicsBlockPos, spawnerVal);
-    //                }
-    //            } else if (bottom && bottom->isAccessible){
-    //                c = c - CHUNK_LAYER + CHUNK_SIZE;
-    //                if (spawnerVal >= LOWWATER){
-    //                    ChunkUpdater::placeBlockSafe(bottom, _lockedChunk, c, spawnerVal);
-    //                } else if (powders){
-    //                    physicsBlockPos = f64v3((double)bottom->voxelPosition.x + c%CHUNK_WIDTH + 0.5, (double)bottom->voxelPosition.y + c / CHUNK_LAYER, (double)bottom->voxelPosition.z + (c%CHUNK_LAYER) / CHUNK_WIDTH + 0.5);
-    //                    m_physicsEngine->addPhysicsBlock(physicsBlockPos, spawnerVal);
-    //                }
-    //            }
-    //        }
-    //    }
-    //    if (sinkVal){
-    //        if (GETBLOCKID(vvox::getTopBlockData(_chunk, _lockedChunk, c)) == sinkVal){
-    //            if (c + CHUNK_LAYER < CHUNK_SIZE){
-    //                c = c + CHUNK_LAYER;
-    //                _chunk->setBlockDataSafe(_lockedChunk, c, NONE); //TODO: This is incorrect, should call RemoveBlock or something similar
-    //                ChunkUpdater::addBlockToUpdateList(_chunk, _lockedChunk, c);
-    //                _chunk->changeState(ChunkStates::MESH);
-    //            } else if (_chunk->top && _chunk->top->isAccessible){
-    //                c = c + CHUNK_LAYER - CHUNK_SIZE;
-    //                _chunk->top->setBlockDataSafe(_lockedChunk, c, NONE);
-    //                ChunkUpdater::addBlockToUpdateList(_chunk->top, _lockedChunk, c);
-    //                _chunk->top->changeState(ChunkStates::MESH);
-    //            }
-    //        }
-    //    }
-    //    i++;
-    //}
-    //if (_lockedChunk) {
-    //    _lockedChunk->unlock();
-    //    _lockedChunk = nullptr;
-    //}
+void CAEngine::activateVoxelAndNeighbors(Chunk* chunk, int blockIndex, const BlockPack* blocks) {
+    activateVoxel(chunk, blockIndex, blocks);
+    for (int face = 0; face < 6; face++) {
+        if (!isBlockIndexOnFace(blockIndex, face)) {
+            activateVoxel(chunk, blockIndex + VOXEL_FACE_OFFSETS[face], blocks);
+        }
+    }
 }
 
-void CAEngine::updateLiquidBlocks(int caIndex)
-{
-    //_lockedChunk = nullptr;
-    //vvox::swapLockedChunk(_chunk, _lockedChunk);
-    //std::vector<bool>& activeUpdateList = _chunk->activeUpdateList;
-    //std::vector <ui16> *blockUpdateList = &_chunk->blockUpdateList[caIndex << 1];
-    //int actv = activeUpdateList[caIndex];
-    //int size = blockUpdateList[actv].size(); 
-    //if (size == 0) {
-    //    _lockedChunk->unlock();
-    //    _lockedChunk = nullptr;
-    //    return;
-    //}
-    //activeUpdateList[caIndex] = !(activeUpdateList[caIndex]); //switch to other list
-    //int c, blockID;
-    //Uint32 i;
-
-    //for (i = 0; i < blockUpdateList[actv].size(); i++){
-    //    c = blockUpdateList[actv][i];
-    //    if (_blockUpdateFlagList[c] == 0){
-    //        _usedUpdateFlagList.push_back(c);
-    //        _blockUpdateFlagList[c] = 1;
-    //        blockID = _chunk->getBlockID(c);
-    //        if (blockID >= _lowIndex) liquidPhysics(c, blockID);
-    //    }
-    //}
-    //blockUpdateList[actv].clear();
+void CAEngine::update(ChunkHandle& chunk, ChunkHandle neighbors[], const BlockPack* blocks, const std::vector<bool>& dueTypes) {
+    m_blocks = blocks;
+    m_slots[0] = chunk;
+    for (int i = 0; i < 6; i++) {
+        m_slots[i + 1] = neighbors[i];
+    }
+    m_changedSlots = 0;
 
-    //for (Uint32 i = 0; i < _usedUpdateFlagList.size(); i++){
-    //    _blockUpdateFlagList[_usedUpdateFlagList[i]] = 0;
-    //}
-    //_usedUpdateFlagList.clear();
-    //if (_lockedChunk) {
-    //    _lockedChunk->unlock();
-    //    _lockedChunk = nullptr;
-    //}
+    {
+        ChunkWriteLock l(chunk->dataMutex);
+        // Anything activated while stepping waits for the next tick
+        chunk->caActive.swapOut(m_activeVoxels);
+    }
+    if (m_activeVoxels.empty()) return;
+
+    // A step reads and writes at most one voxel past the active voxel, and
+    // wakes the voxels next to those, so only neighbors within a voxel of
+    // an active voxel can be touched. Lock just those.
+    ui8 faces = 0;
+    for (ui16 blockIndex : m_activeVoxels) {
+        i32v3 pos = getPosFromBlockIndex((int)blockIndex);
+        if (pos.x <= 1) faces |= 1 << 0;
+        if (pos.x >= CHUNK_WIDTH - 2) faces |= 1 << 1;
+        if (pos.y <= 1) faces |= 1 << 2;
+        if (pos.y >= CHUNK_WIDTH - 2) faces |= 1 << 3;
+        if (pos.z <= 1) faces |= 1 << 4;
+        if (pos.z >= CHUNK_WIDTH - 2) faces |= 1 << 5;
+    }
+    m_lockedSlots = 1 | (faces << 1);
+    for (int i = 0; i < 7; i++) {
+        if (m_lockedSlots & (1 << i)) m_chunkLock.add(m_slots[i], ChunkLockMode::WRITE);
+    }
+    m_chunkLock.lock();
+    for (ui16 blockIndex : m_activeVoxels) {
+        // Don't step voxels that were just moved into
+        if (m_movedVoxels.contains(blockIndex)) {
+            chunk->caActive.insert(blockIndex);
+            continue;
+        }
+        ui16 blockID = chunk->blocks.get(blockIndex);
+        const Block& block = GETBLOCK(blockID);
+        if (block.caIndex < 0 || block.caIndex >= (int)dueTypes.size()) continue;
+        if (!dueTypes[block.caIndex]) {
+            chunk->caActive.insert(blockIndex);
+            continue;
+        }
+        switch (block.caAlg) {
+            case CAAlgorithm::LIQUID:
+                liquidPhysics(blockIndex, blockID);
+                break;
+            case CAAlgorithm::POWDER:
+                powderPhysics(blockIndex, blockID);
+                break;
+            default:
+                break;
+        }
+    }
+    m_movedVoxels.clear();
+    m_chunkLock.clear();
+
+    // One DataChange per modified chunk rather than per voxel
+    if ((m_changedSlots & 1) && chunk->genLevel == GEN_DONE) chunk->DataChange(chunk);
+    for (int i = 0; i < 6; i++) {
+        if ((m_changedSlots & (2 << i)) && neighbors[i]->genLevel == GEN_DONE) {
+            neighbors[i]->DataChange(neighbors[i]);
+        }
+    }
 }
 
-void CAEngine::updatePowderBlocks(int caIndex)
-{
- //   _lockedChunk = nullptr;
- //   std::vector<bool>& activeUpdateList = _chunk->activeUpdateList;
- //   std::vector <ui16> *blockUpdateList = &_chunk->blockUpdateList[caIndex << 1];
- //   int actv = activeUpdateList[caIndex];
-
- //   Uint32 size = blockUpdateList[actv].size();
- //   if (size != 0){
- //       activeUpdateList[caIndex] = !(activeUpdateList[caIndex]); //switch to other list
- //       int b;
- //       Uint32 i;
-
- //       for (i = 0; i < size; i++){ //powder
- //           b = blockUpdateList[actv][i];
- //           if (_blockUpdateFlagList[b] == 0){
- //               _usedUpdateFlagList.push_back(b);
- //               _blockUpdateFlagList[b] = 1;
- //               powderPhysics(b);
- //           }
- //       }
-
- //       blockUpdateList[actv].clear();
-
- //       for (i = 0; i < _usedUpdateFlagList.size(); i++){
- //           _blockUpdateFlagList[_usedUpdateFlagList[i]] = 0;
- //       }
- //       _usedUpdateFlagList.clear();
- //   }
-
- ////   blockUpdateList = _chunk->blockUpdateList[2];
- ////   actv = activeUpdateList[2];
- ////   size = blockUpdateList[actv].size();
-
- //   //if (size != 0){
- //   //    activeUpdateList[2] = !(activeUpdateList[2]);
- //   //    int b;
- //   //    Uint32 i;
-
- //   //    for (i = 0; i < size; i++){ //snow
- //   //        b = blockUpdateList[actv][i];
- //   //        if (_blockUpdateFlagList[b] == 0){
- //   //            _usedUpdateFlagList.push_back(b);
- //   //            _blockUpdateFlagList[b] = 1;
- //   //            if (_chunk->getBlock(b).physicsProperty == P_SNOW){ 
- //   //                powderPhysics(b);
- //   //            }
- //   //        }
- //   //    }
- //   //    blockUpdateList[actv].clear(); 
-
- //   //    for (i = 0; i < _usedUpdateFlagList.size(); i++){
- //   //        _blockUpdateFlagList[_usedUpdateFlagList[i]] = 0;
- //   //    }
- //   //    _usedUpdateFlagList.clear();
- //   //}
- //   if (_lockedChunk) {
- //       _lockedChunk->unlock();
- //       _lockedChunk = nullptr;
- //   }
+inline int getLiquidLevel(const Block& liquid, ui16 blockID) {
+    return liquid.liquidLevels ? blockID - liquid.liquidStartID + 1 : 1;
 }
 
-void CAEngine::liquidPhysics(i32 startBlockIndex, i32 startBlockID) {
-    //// Helper function
-    //#define IS_LIQUID(b) ((b) >= _lowIndex && (b) < _highIndex)
-
-    //i32v3 pos = getPosFromBlockIndex(startBlockIndex);
-    //Chunk* owner;
-    //i32 nextIndex;
-    //i32 nextCoord;
-    //i32 blockID;
-    //i32 diff;
-    //i32 index = 0;
-    //Chunk* adjOwners[4] = {nullptr, nullptr, nullptr, nullptr};
-    //Chunk* adjAdjOwners[4] = { nullptr, nullptr, nullptr, nullptr };
-    //i32 adjIndices[4];
-    //i32 adjAdjIndices[4];
-    //i32 diffs[4];
-
-    //bool hasChanged = false;
-    //bool inFrustum = (!_chunk->mesh || _chunk->mesh->inFrustum);
-    //const i32v3 &position = _chunk->voxelPosition;
-
-    //// Get the block index and owner for the bottom chunk
-    //if (pos.y > 0){
-    //    nextIndex = startBlockIndex - CHUNK_LAYER;
-    //    owner = _chunk;
-    //} else if (_chunk->bottom && _chunk->bottom->isAccessible){
-    //    nextIndex = startBlockIndex + CHUNK_SIZE - CHUNK_LAYER;
-    //    owner = _chunk->bottom;
-    //} else{
-    //    return;
-    //}
-
-    ////Get the block ID
-    //blockID = owner->getBlockIDSafe(_lockedChunk, nextIndex);
-
-    ////If we are falling on an air block
-    //if (blockID == NONE){ 
-    //    ChunkUpdater::placeBlockFromLiquidPhysics(owner, _lockedChunk, nextIndex, startBlockID);
-    //    ChunkUpdater::removeBlockFromLiquidPhysicsSafe(_chunk, _lockedChunk, startBlockIndex);
-
-    //    ChunkUpdater::updateNeighborStates(_chunk, pos, ChunkStates::WATERMESH);
-    //    if (owner != _chunk) ChunkUpdater::updateNeighborStates(owner, nextIndex, ChunkStates::WATERMESH);
-
-    //    if (startBlockID > _lowIndex + 10 && inFrustum) particleEngine.addParticles(m_chunkManager, 1, f64v3(position.x + pos.x, position.y + pos.y - 1.0, position.z + pos.z), 0, 0.1, 16665, 1111, f32v4(255.0f, 255.0f, 255.0f, 255.0f), Blocks[blockID].particleTex, 0.5f, 8);
-    //    return;
-    //} else if (IS_LIQUID(blockID)) { //If we are falling on the same liquid
-    //    //how much empty space there is
-    //    diff = _highIndex - blockID;
-
-    //    //if we cant completely fill in the empty space, fill it in as best we can
-    //    if (startBlockID - _lowIndex + 1 > diff){
-    //        startBlockID -= diff;
-    //        ChunkUpdater::placeBlockFromLiquidPhysics(owner, _lockedChunk, nextIndex, blockID + diff);
-
-    //        if (diff > 10 && inFrustum) particleEngine.addParticles(m_chunkManager, 1, f64v3(position.x + pos.x, position.y + pos.y - 1.0, position.z + pos.z), 0, 0.1, 16665, 1111, f32v4(255.0f, 255.0f, 255.0f, 255.0f), Blocks[blockID].particleTex, 0.5f, 8);
-    //        hasChanged = 1;
-    //        
-    //        if (owner != _chunk) {
-    //            owner->changeState(ChunkStates::WATERMESH);
-    //            ChunkUpdater::updateNeighborStates(owner, nextIndex, ChunkStates::WATERMESH);
-    //        }
-
-    //    } else { //otherwise ALL liquid falls and we are done
-    //        ChunkUpdater::placeBlockFromLiquidPhysics(owner, _lockedChunk, nextIndex, blockID + (startBlockID - _lowIndex + 1));
-    //        ChunkUpdater::removeBlockFromLiquidPhysicsSafe(_chunk, _lockedChunk, startBlockIndex);
-
-    //        ChunkUpdater::updateNeighborStates(_chunk, pos, ChunkStates::WATERMESH);
-    //        if (owner != _chunk) ChunkUpdater::updateNeighborStates(owner, nextIndex, ChunkStates::WATERMESH);
-
-    //        if (startBlockID > _lowIndex + 10 && inFrustum) particleEngine.addParticles(m_chunkManager, 1, f64v3(position.x + pos.x, position.y + pos.y - 1.0, position.z + pos.z), 0, 0.1, 16665, 1111, f32v4(255.0f, 255.0f, 255.0f, 255.0f), Blocks[blockID].particleTex, 0.5f, 8);
-    //        return;
-    //    }
-    //} else if (Blocks[blockID].waterBreak) { //destroy a waterBreak block, such as flora
-    //    ChunkUpdater::removeBlock(m_chunkManager, m_physicsEngine, owner, _lockedChunk, nextIndex, true);
-    //    ChunkUpdater::placeBlockFromLiquidPhysics(owner, _lockedChunk, nextIndex, startBlockID);
-    //    ChunkUpdater::removeBlockFromLiquidPhysicsSafe(_chunk, _lockedChunk, startBlockIndex);
-
-    //    ChunkUpdater::updateNeighborStates(_chunk, pos, ChunkStates::WATERMESH);
-    //    if (owner != _chunk) ChunkUpdater::updateNeighborStates(owner, nextIndex, ChunkStates::WATERMESH);
-
-    //    if (startBlockID > _lowIndex + 10 && inFrustum) particleEngine.addParticles(m_chunkManager, 1, f64v3(position.x + pos.x, position.y + pos.y - 1.0, position.z + pos.z), 0, 0.1, 16665, 1111, f32v4(255.0f, 255.0f, 255.0f, 255.0f), Blocks[blockID].particleTex, 0.5f, 8);
-    //    return;
-    //}
-
-    ////Left Direction
-    //if (pos.x > 0) {
-    //    nextIndex = startBlockIndex - 1;
-    //    owner = _chunk;
-    //    nextCoord = pos.x - 1;
-    //} else if (_chunk->left && _chunk->left->isAccessible) {
-    //    nextIndex = startBlockIndex - 1 + CHUNK_WIDTH;
-    //    owner = _chunk->left;
-    //    nextCoord = CHUNK_WIDTH - 1;
-    //} else {
-    //    return;
-    //}
-
-    //blockID = owner->getBlockIDSafe(_lockedChunk, nextIndex);
-
-    //if (blockID == NONE || Blocks[blockID].waterBreak){ //calculate diffs
-    //    diffs[index] = (startBlockID - (_lowIndex - 1));
-    //    adjOwners[index] = owner;
-    //    adjIndices[index++] = nextIndex;
-    //} else if (IS_LIQUID(blockID)){ //tmp CANT FLOW THOUGH FULL WATER
-    //    
-    //    if (nextCoord > 0){ //extra flow. its the secret!
-    //        adjAdjIndices[index] = nextIndex - 1;
-    //        adjAdjOwners[index] = owner;
-    //    } else if (owner->left && owner->left->isAccessible){
-    //        adjAdjIndices[index] = nextIndex + CHUNK_WIDTH - 1;
-    //        adjAdjOwners[index] = owner->left;
-    //    }
-    //    diffs[index] = (startBlockID - blockID);
-    //    adjOwners[index] = owner;
-    //    adjIndices[index++] = nextIndex;
-    //}
-
-    ////Back Direction
-    //if (pos.z > 0) {
-    //    nextIndex = startBlockIndex - CHUNK_WIDTH;
-    //    owner = _chunk;
-    //    nextCoord = pos.z - 1;
-    //} else if (_chunk->back && _chunk->back->isAccessible) {
-    //    nextIndex = startBlockIndex - CHUNK_WIDTH + CHUNK_LAYER;
-    //    owner = _chunk->back;
-    //    nextCoord = CHUNK_WIDTH - 1;
-    //} else {
-    //    return;
-    //}
-
-    //blockID = owner->getBlockIDSafe(_lockedChunk, nextIndex);
-
-    //if (blockID == NONE || Blocks[blockID].waterBreak){ //calculate diffs
-    //    diffs[index] = (startBlockID - (_lowIndex - 1));
-    //    adjOwners[index] = owner;
-    //    adjIndices[index++] = nextIndex;
-    //} else if (IS_LIQUID(blockID)){ //tmp CANT FLOW THOUGH FULL WATER
-
-    //    if (nextCoord > 0){ //extra flow. its the secret!
-    //        adjAdjIndices[index] = nextIndex - CHUNK_WIDTH;
-    //        adjAdjOwners[index] = owner;
-    //    } else if (owner->back && owner->back->isAccessible){
-    //        adjAdjIndices[index] = nextIndex - CHUNK_WIDTH + CHUNK_LAYER;
-    //        adjAdjOwners[index] = owner->back;
-    //    }
-    //    diffs[index] = (startBlockID - blockID);
-    //    adjOwners[index] = owner;
-    //    adjIndices[index++] = nextIndex;
-    //}
-
-    ////Right Direction
-    //if (pos.x < CHUNK_WIDTH - 1) {
-    //    nextIndex = startBlockIndex + 1;
-    //    owner = _chunk;
-    //    nextCoord = pos.x + 1;
-    //} else if (_chunk->right && _chunk->right->isAccessible) {
-    //    nextIndex = startBlockIndex + 1 - CHUNK_WIDTH;
-    //    owner = _chunk->right;
-    //    nextCoord = 0;
-    //} else {
-    //    return;
-    //}
-
-    //blockID = owner->getBlockIDSafe(_lockedChunk, nextIndex);
-
-    //if (blockID == NONE || Blocks[blockID].waterBreak){ //calculate diffs
-    //    diffs[index] = (startBlockID - (_lowIndex - 1));
-    //    adjOwners[index] = owner;
-    //    adjIndices[index++] = nextIndex;
-    //} else if (IS_LIQUID(blockID)){ //tmp CANT FLOW THOUGH FULL WATER
-
-    //    if (nextCoord < CHUNK_WIDTH - 1){ //extra flow. its the secret!
-    //        adjAdjIndices[index] = nextIndex + 1;
-    //        adjAdjOwners[index] = owner;
-    //    } else if (owner->right && owner->right->isAccessible){
-    //        adjAdjIndices[index] = nextIndex + 1 - CHUNK_WIDTH;
-    //        adjAdjOwners[index] = owner->right;
-    //    }
-    //    diffs[index] = (startBlockID - blockID);
-    //    adjOwners[index] = owner;
-    //    adjIndices[index++] = nextIndex;
-    //}
-
-    ////Front Direction
-    //if (pos.z < CHUNK_WIDTH - 1) {
-    //    nextIndex = startBlockIndex + CHUNK_WIDTH;
-    //    owner = _chunk;
-    //    nextCoord = pos.z + 1;
-    //} else if (_chunk->front && _chunk->front->isAccessible) {
-    //    nextIndex = startBlockIndex + CHUNK_WIDTH - CHUNK_LAYER;
-    //    owner = _chunk->front;
-    //    nextCoord = 0;
-    //} else {
-    //    return;
-    //}
-
-    //blockID = owner->getBlockIDSafe(_lockedChunk, nextIndex);
-
-    //if (blockID == NONE || Blocks[blockID].waterBreak){ //calculate diffs
-    //    diffs[index] = (startBlockID - (_lowIndex - 1));
-    //    adjOwners[index] = owner;
-    //    adjIndices[index++] = nextIndex;
-    //} else if (IS_LIQUID(blockID)){ //tmp CANT FLOW THOUGH FULL WATER
-
-    //    if (nextCoord < CHUNK_WIDTH - 1){ //extra flow. its the secret!
-    //        adjAdjIndices[index] = nextIndex + CHUNK_WIDTH;
-    //        adjAdjOwners[index] = owner;
-    //    } else if (owner->front && owner->front->isAccessible){
-    //        adjAdjIndices[index] = nextIndex + CHUNK_WIDTH - CHUNK_LAYER;
-    //        adjAdjOwners[index] = owner->front;
-    //    }
-    //    diffs[index] = (startBlockID - blockID);
-    //    adjOwners[index] = owner;
-    //    adjIndices[index++] = nextIndex;
-    //}
-
-  
-
-    ////Spread the liquid
-    //int numAdj = index + 1;
-    //for (int i = 0; i < index; i++){
-    //    nextIndex = adjIndices[i];
-    //    owner = adjOwners[i];
-    //    diff = diffs[i] / numAdj;
-    //    //TODO(Ben): cache this instead
-    //    blockID = owner->getBlockIDSafe(_lockedChunk, nextIndex);
-
-    //    if (diff > 0){
-    //        //diff /= num;
-    //        if (diff < (startBlockID - _lowIndex + 1)){
-    //            if (blockID == NONE){
-    //                ChunkUpdater::placeBlockFromLiquidPhysics(owner, _lockedChunk, nextIndex, _lowIndex - 1 + diff);
-    //            } else if (Blocks[blockID].waterBreak){
-    //                ChunkUpdater::removeBlock(m_chunkManager, m_physicsEngine, owner, _lockedChunk, nextIndex, true);
-    //                ChunkUpdater::placeBlockFromLiquidPhysics(owner, _lockedChunk, nextIndex, _lowIndex - 1 + diff);
-    //            } else{
-    //                ChunkUpdater::placeBlockFromLiquidPhysics(owner, _lockedChunk, nextIndex, blockID + diff);
-    //            }
-
-    //           
-    //            startBlockID -= diff;
-    //            if (diff > 10 && inFrustum) particleEngine.addParticles(m_chunkManager, 1, f64v3(position.x + pos.x, position.y + pos.y, position.z + pos.z), 0, 0.1, 16665, 1111, f32v4(255.0f, 255.0f, 255.0f, 255.0f), Blocks[blockID].particleTex, 0.5f, 8);
-    //           
-    //            if (owner != _chunk) {
-    //                owner->changeState(ChunkStates::WATERMESH);
-    //                ChunkUpdater::updateNeighborStates(owner, nextIndex, ChunkStates::WATERMESH);
-    //            }
-
-    //            hasChanged = 1;
-    //        }
-    //    }
-    //}
-    ////Extra movement for more realistic flow
-    //for (int i = 0; i < index; i++) {
-    //    if (adjAdjOwners[i]){
-    //        owner = adjAdjOwners[i];
-    //        nextIndex = adjAdjIndices[i];
-    //        blockID = owner->getBlockIDSafe(_lockedChunk, nextIndex);
-    //        if (blockID == NONE && startBlockID > _lowIndex){
-    //            diff = (startBlockID - _lowIndex + 1) / 2;
-    //            startBlockID -= diff;
+inline ui16 getLiquidID(const Block& liquid, int level) {
+    return liquid.liquidLevels ? (ui16)(liquid.liquidStartID + level - 1) : liquid.ID;
+}
 
-    //            ChunkUpdater::placeBlockFromLiquidPhysics(owner, _lockedChunk, nextIndex, _lowIndex - 1 + diff);
+void CAEngine::liquidPhysics(int blockIndex, ui16 blockID) {
+    const Block& block = GETBLOCK(blockID);
+    int maxLevel = block.liquidLevels ? block.liquidLevels : 1;
+    int level = getLiquidLevel(block, blockID);
+    int startLevel = level;
+    CAVoxel self(0, blockIndex);
+
+    // Fall first
+    CAVoxel below = getAdjacent(self, FACE_Y_NEG);
+    if (below.isValid()) {
+        ui16 belowID = getBlockID(below);
+        if (canLiquidReplace(belowID)) {
+            setBlockID(below, blockID);
+            setBlockID(self, 0);
+            return;
+        }
+        if (isSameLiquid(belowID, block)) {
+            int belowLevel = getLiquidLevel(block, belowID);
+            int transfer = vmath::min(level, maxLevel - belowLevel);
+            if (transfer > 0) {
+                setBlockID(below, getLiquidID(block, belowLevel + transfer));
+                level -= transfer;
+                if (level == 0) {
+                    setBlockID(self, 0);
+                    return;
+                }
+            }
+        }
+    }
 
-    //            if (owner != _chunk) {
-    //                owner->changeState(ChunkStates::WATERMESH);
-    //                ChunkUpdater::updateNeighborStates(owner, nextIndex, ChunkStates::WATERMESH);
-    //            }     
-    //            hasChanged = 1;
-    //        } else if (blockID >= _lowIndex && blockID < startBlockID - 1){
-    //            diff = (startBlockID - blockID) / 2;
+    // Then even out with lower neighbors
+    CAVoxel sides[4];
+    int sideLevels[4];
+    int numSides = 0;
+    for (int i = 0; i < 4; i++) {
+        CAVoxel side = getAdjacent(self, SIDE_FACES[(i + m_dirIndex) & 3]);
+        if (!side.isValid()) continue;
+        ui16 sideID = getBlockID(side);
+        int sideLevel;
+        if (canLiquidReplace(sideID)) {
+            sideLevel = 0;
+        } else if (isSameLiquid(sideID, block)) {
+            sideLevel = getLiquidLevel(block, sideID);
+        } else {
+            continue;
+        }
+        if (sideLevel >= level - 1) continue;
+        sides[numSides] = side;
+        sideLevels[numSides++] = sideLevel;
+    }
+    m_dirIndex++;
+    // Keep a share for ourselves so level never reaches 0
+    for (int i = 0; i < numSides; i++) {
+        int share = (level - sideLevels[i]) / (numSides + 1);
+        if (share <= 0) continue;
+        setBlockID(sides[i], getLiquidID(block, sideLevels[i] + share));
+        level -= share;
+    }
+    if (level != startLevel) setBlockID(self, getLiquidID(block, level));
+}
 
-    //            ChunkUpdater::placeBlockFromLiquidPhysics(owner, _lockedChunk, nextIndex, blockID + diff);
-    //            startBlockID -= diff;
-    //     
-    //            if (owner != _chunk) {
-    //                owner->changeState(ChunkStates::WATERMESH);
-    //                ChunkUpdater::updateNeighborStates(owner, nextIndex, ChunkStates::WATERMESH);
-    //            }
-    //            hasChanged = 1;
-    //        }
-    //    }
-    //}
+void CAEngine::powderPhysics(int blockIndex, ui16 blockID) {
+    CAVoxel self(0, blockIndex);
+    CAVoxel below = getAdjacent(self, FACE_Y_NEG);
+    if (!below.isValid()) return;
+
+    // Fall, sinking through liquids
+    ui16 belowID = getBlockID(below);
+    if (canLiquidReplace(belowID) || GETBLOCK(belowID).caAlg == CAAlgorithm::LIQUID) {
+        ui16 displaced = GETBLOCK(belowID).caAlg == CAAlgorithm::LIQUID ? belowID : 0;
+        setBlockID(below, blockID);
+        setBlockID(self, displaced);
+        return;
+    }
 
-    //if (hasChanged) {
-    //    ChunkUpdater::placeBlockFromLiquidPhysicsSafe(_chunk, _lockedChunk, startBlockIndex, startBlockID);
+    // Topple off the edge of a pile
+    for (int i = 0; i < 4; i++) {
+        CAVoxel side = getAdjacent(self, SIDE_FACES[(i + m_dirIndex) & 3]);
+        if (!side.isValid() || getBlockID(side) != 0) continue;
+        CAVoxel sideBelow = getAdjacent(side, FACE_Y_NEG);
+        if (!sideBelow.isValid() || !canLiquidReplace(getBlockID(sideBelow))) continue;
+        setBlockID(sideBelow, blockID);
+        setBlockID(self, 0);
+        break;
+    }
+    m_dirIndex++;
+}
 
-    //    _chunk->changeState(ChunkStates::WATERMESH);
-    //    ChunkUpdater::updateNeighborStates(_chunk, pos, ChunkStates::WATERMESH);
-    //}
+bool CAEngine::canLiquidReplace(ui16 blockID) const {
+    if (blockID == 0) return true;
+    const Block& block = GETBLOCK(blockID);
+    return block.waterBreak && block.caAlg == CAAlgorithm::NONE;
 }
 
-void CAEngine::powderPhysics(int blockIndex)
-{
-    //// Directional constants
-    //#define LEFT 0
-    //#define RIGHT 1
-    //#define FRONT 2
-    //#define BACK 3
-    //// Every permutation of 0-3 for random axis directions
-    //#define DIRS_SIZE 96
-    //static const int DIRS[DIRS_SIZE] = { 0, 1, 2, 3, 0, 1, 3, 2, 0, 2, 3, 1, 0, 2, 1, 3, 0, 3, 2, 1, 0, 3, 1, 2,
-    //    1, 0, 2, 3, 1, 0, 3, 2, 1, 2, 0, 3, 1, 2, 3, 0, 1, 3, 2, 0, 1, 3, 0, 2,
-    //    2, 0, 1, 3, 2, 0, 3, 1, 2, 1, 3, 0, 2, 1, 0, 3, 2, 3, 0, 1, 2, 3, 1, 0,
-    //    3, 0, 1, 2, 3, 0, 2, 1, 3, 1, 2, 0, 3, 1, 0, 2, 3, 2, 0, 1, 3, 2, 1, 0 };
+bool CAEngine::isSameLiquid(ui16 blockID, const Block& liquid) const {
+    const Block& block = GETBLOCK(blockID);
+    return block.caAlg == CAAlgorithm::LIQUID && block.caIndex == liquid.caIndex &&
+           block.liquidStartID == liquid.liquidStartID;
+}
 
-    //int blockData = _chunk->getBlockDataSafe(_lockedChunk, blockIndex);
-    //int nextBlockData, nextBlockIndex;
-    //// Make sure this is a powder block
-    //if (GETBLOCK(blockData).caAlg != CA_ALGORITHM::POWDER) return;
+CAEngine::CAVoxel CAEngine::getAdjacent(const CAVoxel& voxel, int face) const {
+    if (!isBlockIndexOnFace(voxel.blockIndex, face)) {
+        return CAVoxel(voxel.slot, voxel.blockIndex + VOXEL_FACE_OFFSETS[face]);
+    }
+    int blockIndex = voxel.blockIndex + VOXEL_WRAP_OFFSETS[face];
+    if (voxel.slot == 0) {
+        // Never touch a neighbor that isn't locked
+        if (!(m_lockedSlots & (2 << face))) return CAVoxel();
+        return CAVoxel(face + 1, blockIndex);
+    }
+    // Stepping from a neighbor back into the chunk being updated
+    if (voxel.slot == (face ^ 1) + 1) return CAVoxel(0, blockIndex);
+    return CAVoxel();
+}
 
-    //Chunk* nextChunk;
-    //i32v3 pos = getPosFromBlockIndex(blockIndex);
+ui16 CAEngine::getBlockID(const CAVoxel& voxel) {
+    return m_slots[voxel.slot]->blocks.get(voxel.blockIndex);
+}
 
-    //// *** Falling in Y direction ***
-    //// Get bottom block
-    //nextBlockData = vvox::getBottomBlockData(_chunk, _lockedChunk, blockIndex, pos.y, nextBlockIndex, nextChunk);
-    //// Check for edge
-    //if (nextBlockData == -1) return;
-    //// Since getXXXBlockData may lock a chunk, we need this
-    //_lockedChunk = nextChunk;
-    //// Get block info
-    //const Block& bottomBlock = GETBLOCK(nextBlockData);
-    //// Check if we can move down
-    //if (bottomBlock.isCrushable) {
-    //    // Move down and crush block
-    //    ChunkUpdater::placeBlock(nextChunk, _lockedChunk, nextBlockIndex, blockData);
-    //    ChunkUpdater::removeBlockSafe(m_chunkManager, m_physicsEngine, _chunk, _lockedChunk, blockIndex, false);
-    //    return;
-    //} else if (bottomBlock.powderMove) {
-    //    // Move down and swap places
-    //    ChunkUpdater::placeBlock(nextChunk, _lockedChunk, nextBlockIndex, blockData);
-    //    ChunkUpdater::placeBlockSafe(_chunk, _lockedChunk, blockIndex, nextBlockData);
-    //    return;
-    //} else if (bottomBlock.caAlg != CA_ALGORITHM::POWDER) {
-    //    // We can only slide on powder, so if its not powder, we return.
-    //    return;
-    //}
+void CAEngine::setBlockID(const CAVoxel& voxel, ui16 blockID) {
+    Chunk* chunk = m_slots[voxel.slot];
+    chunk->setBlock(voxel.blockIndex, blockID);
+    chunk->collidable.set((ui16)voxel.blockIndex, m_blocks->operator[](blockID).collide);
+    chunk->flagDirty();
+    VoxelLightEngine::updateSunHeight(chunk, voxel.blockIndex, m_blocks);
+    VoxelLightEngine::postMessage(chunk, LightMessage(LightMessageType::BLOCK_CHANGE, (ui16)voxel.blockIndex, 0));
+    m_changedSlots |= 1 << voxel.slot;
+    if (voxel.slot == 0) {
+        m_movedVoxels.insert((ui16)voxel.blockIndex);
+        // Neighbors mesh with our face voxels
+        for (int face = 0; face < 6; face++) {
+            if (isBlockIndexOnFace(voxel.blockIndex, face)) m_changedSlots |= 2 << face;
+        }
+    }
 
-    //// We use _dirIndex to avoid any calls to rand(). We dont get truly random direction but
-    //// it appears random.
-    //#define NUM_AXIS 4
-    //_dirIndex += NUM_AXIS;
-    //// Wrap back to zero
-    //if (_dirIndex == DIRS_SIZE) _dirIndex = 0;
-    //// Loop through our 4 "random" directions
-    //for (int i = _dirIndex; i < _dirIndex + NUM_AXIS; i++) {
-    //    // Get the neighbor block in the direction
-    //    switch (DIRS[i]) {
-    //        case LEFT:
-    //            // Only lock the chunk if we know we aren't about to go to a neighbor
-    //            if (pos.x != 0) vvox::swapLockedChunk(_chunk, _lockedChunk);
-    //            nextBlockData = vvox::getLeftBlockData(_chunk, _lockedChunk, blockIndex, pos.x,
-    //                                                     nextBlockIndex, nextChunk);
-    //            break;
-    //        case RIGHT:
-    //            if (pos.x != CHUNK_WIDTH - 1) vvox::swapLockedChunk(_chunk, _lockedChunk);
-    //            nextBlockData = vvox::getRightBlockData(_chunk, _lockedChunk, blockIndex, pos.x,
-    //                                                      nextBlockIndex, nextChunk);
-    //            break;
-    //        case BACK:
-    //            if (pos.z != 0) vvox::swapLockedChunk(_chunk, _lockedChunk);
-    //            nextBlockData = vvox::getBackBlockData(_chunk, _lockedChunk, blockIndex, pos.z,
-    //                                                     nextBlockIndex, nextChunk);
-    //            break;
-    //        case FRONT:
-    //            if (pos.z != CHUNK_WIDTH - 1) vvox::swapLockedChunk(_chunk, _lockedChunk);
-    //            nextBlockData = vvox::getFrontBlockData(_chunk, _lockedChunk, blockIndex, pos.z,
-    //                                                      nextBlockIndex, nextChunk);
-    //            break;
-    //    }
-    //    // Check for edge
-    //    if (nextBlockData == -1) return;
-    //    // Since getXXXBlockData may lock a chunk, we need this
-    //    _lockedChunk = nextChunk;
-    //    // Check bottom
-    //    const Block& diagonalBlock = GETBLOCK(vvox::getBottomBlockData(nextChunk, _lockedChunk, 
-    //                                          nextBlockIndex));
-    //    // We only move to the side if we can fall down the next update
-    //    if (diagonalBlock.powderMove || diagonalBlock.isCrushable) {
-    //        // Get block info
-    //        const Block& nextBlock = GETBLOCK(nextBlockData);
-    //        // Check if we can move
-    //        if (nextBlock.isCrushable) {
-    //            // Move and crush block
-    //            ChunkUpdater::placeBlockSafe(nextChunk, _lockedChunk, nextBlockIndex, blockData);
-    //            ChunkUpdater::removeBlockSafe(m_chunkManager, m_physicsEngine, _chunk, _lockedChunk, blockIndex, false);
-    //            return;
-    //        } else if (nextBlock.powderMove) {
-    //            // Move and swap places
-    //            ChunkUpdater::placeBlockSafe(nextChunk, _lockedChunk, nextBlockIndex, blockData);
-    //            ChunkUpdater::placeBlockSafe(_chunk, _lockedChunk, blockIndex, nextBlockData);
-    //            return;
-    //        }
-    //    }
-    //}
+    // Wake up the voxel and everything around it for the next tick
+    activateVoxel(chunk, voxel.blockIndex, m_blocks);
+    for (int face = 0; face < 6; face++) {
+        CAVoxel adjacent = getAdjacent(voxel, face);
+        if (adjacent.isValid()) {
+            activateVoxel(m_slots[adjacent.slot], adjacent.blockIndex, m_blocks);
+        }
+    }
 }
@@ -3,19 +3,20 @@
 #include <Vorb/VorbPreDecl.inl>
 
 #include "CellularAutomataTask.h"
+#include "ChunkHandle.h"
+#include "ChunkLock.h"
+#include "ChunkVoxelSet.h"
 #include "Constants.h"
 #include "LiquidData.h"
 
 DECL_VIO(class IOManager)
 
-class ChunkManager;
+class Block;
+class BlockPack;
 class Chunk;
-class PhysicsEngine;
 
 /// Resolution of CA updates in frames
 #define CA_TICK_RES 4
-/// Should be half of CA_TICK_RES
-#define HALF_CA_TICK_RES 2
 
 class CaPhysicsData {
 public:
@@ -31,7 +32,7 @@ typedef std::vector<CaPhysicsType*> CaPhysicsTypeList;
 class CaPhysicsType {
 public:
 
-    /// Updates the type.
+    /// Updates the type. Called once per CA tick.
     /// @return true if it this physics type should simulate
     bool update();
 
@@ -45,7 +46,6 @@ class CaPhysicsType {
     const int& getCaIndex() const { return _caIndex; }
     const ui32& getUpdateRate() const { return _data.updateRate; }
     const CAAlgorithm& getCaAlg() const { return _data.alg; }
-    const bool& getIsEven() const { return _isEven; }
 
     // Static functions
     /// Gets the number of CA types currently cached
@@ -59,31 +59,55 @@ class CaPhysicsType {
 
     CaPhysicsData _data; ///< The algorithm specific data
     int _caIndex; ///< index into typesArray
-    bool _isEven = false;  ///< Used for optimization, only update odd or even chunks at any time
 
     ui32 _ticks = 0; ///< Counts the ticks
 };
 
+/// Steps liquids and powders in one chunk. One per worker thread.
+/// Only the chunk's own active voxels are stepped, but voxels can move
+/// into face neighbors. The chunk and the neighbors its active voxels can
+/// reach are write locked in ChunkID order for the step, so chunks that
+/// share a neighbor can still run at the same time.
 class CAEngine {
 public:
-    CAEngine(ChunkManager* chunkManager, PhysicsEngine* physicsEngine);
-    void setChunk(Chunk* chunk) { _chunk = chunk; }
-    void updateSpawnerBlocks(bool powders);
-    void updateLiquidBlocks(int caIndex);
-    void updatePowderBlocks(int caIndex);
+    /// Adds the voxel to the chunk's active set if it has a CA type.
+    /// Chunk must be locked.
+    static void activateVoxel(Chunk* chunk, int blockIndex, const BlockPack* blocks);
+    /// Activates the voxel and its neighbors within the same chunk.
+    /// Chunk must be locked.
+    static void activateVoxelAndNeighbors(Chunk* chunk, int blockIndex, const BlockPack* blocks);
+
+    /// Steps every active voxel whose CA type is due.
+    /// @param neighbors: Acquired face neighbors, ordered -x, +x, -y, +y, -z, +z
+    /// @param dueTypes: Indexed by caIndex, true if the type steps this tick
+    void update(ChunkHandle& chunk, ChunkHandle neighbors[], const BlockPack* blocks, const std::vector<bool>& dueTypes);
 private:
-    
-    void liquidPhysics(i32 startBlockIndex, i32 b);
-    void powderPhysics(i32 c);
-
-    i32 _dirIndex = 0;
-    i32 _lowIndex;
-    i32 _range;
-    i32 _highIndex;
-    std::vector<ui16> _usedUpdateFlagList;
-    bool _blockUpdateFlagList[CHUNK_SIZE];
-    Chunk* _chunk = nullptr;
-    Chunk* _lockedChunk = nullptr;
-    ChunkManager* m_chunkManager = nullptr;
-    PhysicsEngine* m_physicsEngine = nullptr;
-};
\ No newline at end of file
+    // A voxel in the chunk being updated (slot 0) or a face neighbor (slot face + 1)
+    struct CAVoxel {
+        CAVoxel() {}
+        CAVoxel(int Slot, int BlockIndex) : slot(Slot), blockIndex(BlockIndex) {}
+        bool isValid() const { return slot >= 0; }
+        int slot = -1;
+        int blockIndex;
+    };
+
+    void liquidPhysics(int blockIndex, ui16 blockID);
+    void powderPhysics(int blockIndex, ui16 blockID);
+    /// True for air and blocks that liquid washes away
+    bool canLiquidReplace(ui16 blockID) const;
+    bool isSameLiquid(ui16 blockID, const Block& liquid) const;
+
+    /// Steps from a voxel across face. Invalid if that needs an edge or corner chunk.
+    CAVoxel getAdjacent(const CAVoxel& voxel, int face) const;
+    ui16 getBlockID(const CAVoxel& voxel);
+    void setBlockID(const CAVoxel& voxel, ui16 blockID);
+
+    const BlockPack* m_blocks = nullptr;
+    Chunk* m_slots[7]; ///< The chunk being updated, then its face neighbors
+    MultiChunkLock m_chunkLock; ///< Write locks the touched slots while stepping
+    ui8 m_lockedSlots = 0; ///< Bit per slot held by m_chunkLock
+    ui8 m_changedSlots = 0; ///< Bit per slot that needs a DataChange
+    ui32 m_dirIndex = 0; ///< Rotates the order sideways moves are tried in
+    std::vector<ui16> m_activeVoxels; ///< Snapshot of the chunk's active set
+    ChunkVoxelSet m_movedVoxels; ///< Voxels in the chunk written this step
+};
@@ -0,0 +1,128 @@
+#include "stdafx.h"
+#include "CAScheduler.h"
+
+#include "CAEngine.h"
+#include "CellularAutomataTask.h"
+#include "Chunk.h"
+#include "ChunkGrid.h"
+
+void CAScheduler::init(ChunkGrid* grid, vcore::ThreadPool<WorkerData>* threadPool) {
+    m_grid = grid;
+    m_threadPool = threadPool;
+    m_runningTasks = 0;
+    m_tickRunning = false;
+    m_isDisposing = false;
+}
+
+void CAScheduler::dispose() {
+    // Let the current phase finish so no task outlives us. The remaining
+    // colors are skipped and their handles released below.
+    m_isDisposing = true;
+    while (m_tickRunning) {
+        std::this_thread::yield();
+    }
+    for (int i = 0; i < CA_NUM_COLORS; i++) {
+        for (auto& task : m_colorTasks[i]) {
+            task->chunk.release();
+            for (int j = 0; j < 6; j++) {
+                task->neighbors[j].release();
+            }
+            delete task;
+        }
+        std::vector<CellularAutomataTask*>().swap(m_colorTasks[i]);
+    }
+    CellularAutomataTask* task;
+    while (m_freeTasks.try_dequeue(task)) {
+        delete task;
+    }
+    m_phase = -1;
+    m_isDisposing = false;
+}
+
+void CAScheduler::update() {
+    if (!m_threadPool) return;
+
+    // Counted while a tick runs so the cadence doesn't depend on its length
+    if (m_frame < CA_TICK_RES) m_frame++;
+    if (m_frame < CA_TICK_RES || m_tickRunning) return;
+    m_frame = 0;
+    startTick();
+}
+
+void CAScheduler::onTaskFinished(CellularAutomataTask* task) {
+    m_freeTasks.enqueue(task);
+    if (--m_runningTasks == 0) startNextPhase();
+}
+
+void CAScheduler::startTick() {
+    m_dueTypes.resize(CaPhysicsType::typesArray.size());
+    m_anyTypeDue = false;
+    for (size_t i = 0; i < m_dueTypes.size(); i++) {
+        m_dueTypes[i] = CaPhysicsType::typesArray[i]->update();
+        m_anyTypeDue |= m_dueTypes[i];
+    }
+    m_randomTickDue = ++m_randomTickCounter >= RANDOM_TICK_RES;
+    if (m_randomTickDue) m_randomTickCounter = 0;
+    if (!m_anyTypeDue && !m_randomTickDue) return;
+
+    m_numTickChunks = 0;
+    const std::vector<ChunkHandle>& chunks = m_grid->acquireActiveChunks();
+    for (auto& chunk : chunks) {
+        if (chunk->genLevel != GEN_DONE) continue;
+        // Unlocked peek, anything we miss is picked up next tick
+        bool hasWork = (m_anyTypeDue && !chunk->caActive.empty()) || (m_randomTickDue && !chunk->tickVoxels.empty());
+        if (!hasWork) continue;
+        // Voxels move into neighbors, so they have to be around
+        bool hasNeighbors = true;
+        for (int i = 0; i < 6; i++) {
+            if (!chunk->neighbors[i].isAquired() || chunk->neighbors[i]->genLevel != GEN_DONE) {
+                hasNeighbors = false;
+                break;
+            }
+        }
+        if (!hasNeighbors) continue;
+        const ChunkID& id = chunk->getID();
+        int color = (id.x & 1) | ((id.y & 1) << 1) | ((id.z & 1) << 2);
+        CellularAutomataTask* task;
+        if (!m_freeTasks.try_dequeue(task)) {
+            task = new CellularAutomataTask;
+        }
+        // The task releases all of these
+        task->chunk = chunk.acquire();
+        for (int i = 0; i < 6; i++) {
+            task->neighbors[i] = chunk->neighbors[i].acquire();
+        }
+        task->blockPack = m_grid->blockPack;
+        task->scheduler = this;
+        m_colorTasks[color].push_back(task);
+        m_numTickChunks++;
+    }
+    m_grid->releaseActiveChunks();
+
+    if (m_numTickChunks == 0) return;
+    m_tickRunning = true;
+    m_phase = -1;
+    startNextPhase();
+}
+
+void CAScheduler::startNextPhase() {
+    while (++m_phase < CA_NUM_COLORS) {
+        if (m_colorTasks[m_phase].size() && !m_isDisposing) {
+            startPhase(m_phase);
+            return;
+        }
+    }
+    m_phase = -1;
+    m_tickRunning = false;
+}
+
+void CAScheduler::startPhase(int color) {
+    // Taken up front, the last task can start the next phase, or end the
+    // tick and let the main thread refill the colors, before this returns
+    std::vector<CellularAutomataTask*> tasks;
+    tasks.swap(m_colorTasks[color]);
+    m_runningTasks += (ui32)tasks.size();
+    for (auto& task : tasks) {
+        m_threadPool->addTask(task);
+    }
+}
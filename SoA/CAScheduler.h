@@ -0,0 +1,85 @@
+///
+/// CAScheduler.h
+/// Seed of Andromeda
+///
+/// Copyright 2014 Regrowth Studios
+/// All Rights Reserved
+///
+/// Summary:
+/// Schedules cellular automata updates for the chunks of a grid
+/// in a checkerboard so neighboring chunks never update together.
+///
+
+#pragma once
+
+#ifndef CAScheduler_h__
+#define CAScheduler_h__
+
+#include <concurrentqueue.h>
+
+#include "ChunkHandle.h"
+#include "VoxPool.h"
+
+class BlockPack;
+class CellularAutomataTask;
+class ChunkGrid;
+
+// Chunks are colored by the parity of each axis
+#define CA_NUM_COLORS 8
+// Random block ticks run once every this many CA ticks
+#define RANDOM_TICK_RES 4
+
+/// Every CA_TICK_RES frames, collects the chunks with active CA voxels of a
+/// due type, or random tick voxels when those are due, and runs them in
+/// CA_NUM_COLORS phases. Chunks of the same color never share a face, so a
+/// chunk is never stepped while voxels are moving out of a neighbor into it.
+/// Same color chunks two apart can share a face neighbor, which the tasks
+/// lock as needed. The last task of a phase starts the next, so a tick
+/// doesn't wait a frame per color. Frames are counted while a tick runs,
+/// and a tick that is due while the last one runs starts once it is done.
+/// The main thread never blocks.
+class CAScheduler {
+public:
+    void init(ChunkGrid* grid, vcore::ThreadPool<WorkerData>* threadPool);
+    void dispose();
+
+    void update();
+
+    /// Called by tasks when they are done
+    void onTaskFinished(CellularAutomataTask* task);
+
+    /// Indexed by caIndex, true if the type steps this tick
+    const std::vector<bool>& getDueTypes() const { return m_dueTypes; }
+    /// True if any CA type steps this tick
+    bool isAnyTypeDue() const { return m_anyTypeDue; }
+    /// True if random block ticks run this tick
+    bool isRandomTickDue() const { return m_randomTickDue; }
+    /// Number of chunks stepped last tick
+    ui32 getNumTickChunks() const { return m_numTickChunks; }
+private:
+    void startTick();
+    /// Starts the next color with chunks, or ends the tick. Called on the
+    /// main thread by startTick, then by the last task of each phase.
+    void startNextPhase();
+    void startPhase(int color);
+
+    ChunkGrid* m_grid = nullptr;
+    vcore::ThreadPool<WorkerData>* m_threadPool = nullptr;
+
+    ui32 m_frame = 0;
+    int m_phase = -1; ///< Color being updated, only touched by whoever starts the next phase
+    std::atomic<bool> m_tickRunning;
+    std::atomic<bool> m_isDisposing;
+    std::vector<bool> m_dueTypes;
+    bool m_anyTypeDue = false;
+    ui32 m_randomTickCounter = 0;
+    bool m_randomTickDue = false;
+    /// Built on the main thread, where neighbor handles can be read safely
+    std::vector<CellularAutomataTask*> m_colorTasks[CA_NUM_COLORS];
+    ui32 m_numTickChunks = 0;
+
+    std::atomic<ui32> m_runningTasks;
+    moodycamel::ConcurrentQueue<CellularAutomataTask*> m_freeTasks;
+};
+
+#endif // CAScheduler_h__
@@ -2,50 +2,28 @@
 #include "CellularAutomataTask.h"
 
 #include "CAEngine.h"
+#include "CAScheduler.h"
 #include "Chunk.h"
-#include "ChunkMeshManager.h"
+#include "ChunkUpdater.h"
 #include "VoxPool.h"
 
-CellularAutomataTask::CellularAutomataTask(ChunkManager* chunkManager,
-                                           PhysicsEngine* physicsEngine,
-                                           Chunk* chunk,
-                                           OPT ChunkMeshManager* meshManager) :
-                                           IThreadPoolTask(CA_TASK_ID),
-                                           m_chunkManager(chunkManager),
-                                           m_physicsEngine(physicsEngine),
-                                           _chunk(chunk) {
-
-    //return;
-
-    //typesToUpdate.reserve(2);
+void CellularAutomataTask::execute(WorkerData* workerData) {
+    if (workerData->caEngine == nullptr) {
+        workerData->caEngine = new CAEngine;
+    }
+    if (scheduler->isAnyTypeDue()) {
+        workerData->caEngine->update(chunk, neighbors, blockPack, scheduler->getDueTypes());
+    }
+    if (scheduler->isRandomTickDue()) {
+        ChunkUpdater::randomBlockUpdates(chunk, neighbors, workerData->randomEngine);
+    }
 
-    //if (meshManager) {
-    //    chunk->queuedForMesh = true;
-    //    renderTask = new RenderTask();
-    //    renderTask->init(_chunk, RenderTaskType::DEFAULT, meshManager);
-    //}
+    chunk.release();
+    for (int i = 0; i < 6; i++) {
+        neighbors[i].release();
+    }
 }
 
-void CellularAutomataTask::execute(WorkerData* workerData) {
-   // if (workerData->caEngine == nullptr) {
-   //     workerData->caEngine = new CAEngine(m_chunkManager, m_physicsEngine);
-   // }
-   // workerData->caEngine->setChunk(_chunk);
-   // for (auto& type : typesToUpdate) {
-   //     switch (type->getCaAlg()) {
-   //         case CA_ALGORITHM::LIQUID:
-   ////             workerData->caEngine->updateLiquidBlocks(type->getCaIndex());
-   //             break;
-   //         case CA_ALGORITHM::POWDER:
-   ////             workerData->caEngine->updatePowderBlocks(type->getCaIndex());
-   //             break;
-   //         default:
-   //             break;
-   //     }
-   // }
-
-   // if (renderTask) {
-   //     renderTask->execute(workerData);
-   // }
-   //// updateSpawnerBlocks(frameCounter == 0);
+void CellularAutomataTask::cleanup() {
+    scheduler->onTaskFinished(this);
 }
@@ -17,14 +17,11 @@
 
 #include <Vorb/IThreadPoolTask.h>
 
+#include "ChunkHandle.h"
 #include "VoxPool.h"
 
-class CaPhysicsType;
-class Chunk;
-class ChunkManager;
-class ChunkMeshManager;
-class PhysicsEngine;
-class ChunkMeshTask;
+class BlockPack;
+class CAScheduler;
 
 #define CA_TASK_ID 3
 
@@ -34,32 +31,20 @@ enum class CAAlgorithm {
     POWDER = 2 
 };
 
+/// Steps the CA and random block ticks for one chunk. Created by CAScheduler.
 class CellularAutomataTask : public vcore::IThreadPoolTask<WorkerData> {
 public:
-    friend class ChunkManager;
-    friend class SphericalVoxelComponentUpdater;
-    /// Constructs the task
-    CellularAutomataTask(ChunkManager* chunkManager,
-                         PhysicsEngine* physicsEngine,
-                         Chunk* chunk,
-                         OPT ChunkMeshManager* meshManager);
-
-    /// Adds a caPhysicsType for update
-    void addCaTypeToUpdate(CaPhysicsType* caType) {
-        typesToUpdate.push_back(caType);
-    }
+    CellularAutomataTask() : vcore::IThreadPoolTask<WorkerData>(CA_TASK_ID) {}
 
     /// Executes the task
     void execute(WorkerData* workerData) override;
 
-    ChunkMeshTask* renderTask = nullptr; ///< A nested to force re-mesh
+    void cleanup() override;
 
-private:
-    std::vector<CaPhysicsType*> typesToUpdate; ///< All the CA types that will be updated by this task
-    Chunk* _chunk = nullptr; ///< The chunk we are updating
-    ChunkManager* m_chunkManager = nullptr;
-    PhysicsEngine* m_physicsEngine = nullptr;
-    ChunkMeshManager* meshManager = nullptr;
+    ChunkHandle chunk;
+    ChunkHandle neighbors[6]; ///< Ordered -x, +x, -y, +y, -z, +z
+    const BlockPack* blockPack = nullptr;
+    CAScheduler* scheduler = nullptr;
 };
 
-#endif // CellularAutomataTask_h__
\ No newline at end of file
+#endif // CellularAutomataTask_h__
@@ -20,14 +20,64 @@ void Chunk::initAndFillEmpty(WorldCubeFace face, vvox::VoxelStorageState /*= vvo
     tertiaryNode.set(0, CHUNK_SIZE, 0);
     blocks.initFromSortedArray(vvox::VoxelStorageState::INTERVAL_TREE, &blockNode, 1);
     tertiary.initFromSortedArray(vvox::VoxelStorageState::INTERVAL_TREE, &tertiaryNode, 1);
+    collidable.clear();
+    initLight();
 }
 
 void Chunk::setRecyclers(vcore::FixedSizeArrayRecycler<CHUNK_SIZE, ui16>* shortRecycler) {
     blocks.setArrayRecycler(shortRecycler);
     tertiary.setArrayRecycler(shortRecycler);
+    sunlight.setArrayRecycler(shortRecycler);
+    lamp.setArrayRecycler(shortRecycler);
 }
 
 void Chunk::updateContainers() {
     blocks.update(dataMutex);
     tertiary.update(dataMutex);
-}
\ No newline at end of file
+    sunlight.update(dataMutex);
+    lamp.update(dataMutex);
+}
+
+void Chunk::initLight() {
+    IntervalTree<ui16>::LNode lightNode;
+    lightNode.set(0, CHUNK_SIZE, 0);
+    sunlight.clear();
+    lamp.clear();
+    sunlight.initFromSortedArray(vvox::VoxelStorageState::INTERVAL_TREE, &lightNode, 1);
+    lamp.initFromSortedArray(vvox::VoxelStorageState::INTERVAL_TREE, &lightNode, 1);
+    {
+        std::lock_guard<std::mutex> l(lightInboxMutex);
+        std::vector<LightMessage>().swap(lightInbox);
+    }
+    isLit = false;
+}
+void ChunkGridData::initSunHeight() {
+    std::lock_guard<std::mutex> l(sunHeightMutex);
+    for (int i = 0; i < CHUNK_LAYER; i++) {
+        // Terrain is solid at and below the surface
+        i32 surface = (i32)floor(heightData[i].height);
+        if (surface > sunHeight[i]) {
+            sunHeight[i] = surface;
+            sunRescan[i] = false;
+        }
+    }
+}
+
+void ChunkGridData::raiseSunHeight(int xz, i32 worldY) {
+    if (worldY <= sunHeight[xz]) return;
+    std::lock_guard<std::mutex> l(sunHeightMutex);
+    if (worldY > sunHeight[xz]) {
+        sunHeight[xz] = worldY;
+        sunRescan[xz] = false;
+    }
+}
+
+void ChunkGridData::lowerSunHeight(int xz, i32 oldY, i32 newY, bool rescan) {
+    if (sunHeight[xz] != oldY) return;
+    std::lock_guard<std::mutex> l(sunHeightMutex);
+    // Something else may have raised it since
+    if (sunHeight[xz] == oldY) {
+        sunHeight[xz] = newY;
+        sunRescan[xz] = rescan;
+    }
+}
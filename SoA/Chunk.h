@@ -22,31 +22,62 @@
 #include "MetaSection.h"
 #include "ChunkGenerator.h"
 #include "ChunkID.h"
+#include "ChunkCollisionMask.h"
+#include "ChunkLock.h"
+#include "ChunkVoxelSet.h"
+#include "VoxelLightEngine.h"
 #include <Vorb/FixedSizeArrayRecycler.hpp>
+#include <atomic>
 
 class Chunk;
 typedef Chunk* ChunkPtr;
+struct VoxelNodeBatch;
+
+// No voxel in the column blocks the sun
+#define SUN_HEIGHT_NONE ((i32)0x80000000)
 
 // TODO(Ben): Move to file
 typedef ui16 BlockIndex;
 
 class ChunkGridData {
 public:
-    ChunkGridData() {};
-    ChunkGridData(const ChunkPosition3D& pos) {
+    ChunkGridData() {
+        for (int i = 0; i < CHUNK_LAYER; i++) {
+            sunHeight[i] = SUN_HEIGHT_NONE;
+            sunRescan[i] = false;
+        }
+    };
+    ChunkGridData(const ChunkPosition3D& pos) : ChunkGridData() {
         gridPosition.pos = i32v2(pos.pos.x, pos.pos.z);
         gridPosition.face = pos.face;
     }
 
+    /// True if nothing at or above worldY blocks the sun in this column. O(1).
+    bool isSkyExposed(int xz, i32 worldY) const { return worldY > sunHeight[xz]; }
+    /// Fills the column heights from the terrain surface in heightData
+    void initSunHeight();
+    /// Call when a sun blocking voxel is placed at worldY
+    void raiseSunHeight(int xz, i32 worldY);
+    /// Call when the sun blocker at oldY is removed. newY is the next
+    /// blocker below it, or the lowest voxel known to be clear minus one.
+    /// @param rescan: True if newY is only the top of an unscanned chunk
+    void lowerSunHeight(int xz, i32 oldY, i32 newY, bool rescan);
+    /// True if the column's height is pinned to worldY, the top of a chunk
+    /// whose column still has to be scanned for the next blocker down
+    bool needsSunRescan(int xz, i32 worldY) const { return sunRescan[xz] && sunHeight[xz] == worldY; }
+
     ChunkPosition2D gridPosition;
     PlanetHeightData heightData[CHUNK_LAYER];
+    /// World Y of the highest voxel in each column that stops the full
+    /// strength sun ray, or SUN_HEIGHT_NONE. Reads are lock free.
+    volatile i32 sunHeight[CHUNK_LAYER];
+    volatile bool sunRescan[CHUNK_LAYER]; ///< See needsSunRescan
+    std::mutex sunHeightMutex; ///< Held for writes to sunHeight and sunRescan
     bool isLoading = false;
     bool isLoaded = false;
     int refCount = 1;
 };
 
-// TODO(Ben): Can lock two chunks without deadlock worry with checkerboard pattern updates.
-
 class Chunk {
     friend class ChunkAccessor;
     friend class ChunkGenerator;
@@ -63,6 +94,8 @@ class Chunk {
     void initAndFillEmpty(WorldCubeFace face, vvox::VoxelStorageState = vvox::VoxelStorageState::INTERVAL_TREE);
     void setRecyclers(vcore::FixedSizeArrayRecycler<CHUNK_SIZE, ui16>* shortRecycler);
     void updateContainers();
+    // Sets all light to 0 and flags the chunk to be lit from scratch
+    void initLight();
 
     /************************************************************************/
     /* Getters                                                              */
@@ -78,7 +111,18 @@ class Chunk {
         return tertiary.get(c);
     }
     void setBlock(int x, int y, int z, ui16 id) {
-        blocks.set(x + y * CHUNK_LAYER + z * CHUNK_WIDTH, id);
+        setBlock(x + y * CHUNK_LAYER + z * CHUNK_WIDTH, id);
+    }
+    /// Writes a block and keeps numBlocks in step. Every write after
+    /// generation must go through here. Chunk must be locked.
+    void setBlock(int blockIndex, ui16 id) {
+        ui16 oldID = blocks.get(blockIndex);
+        if (oldID == 0 && id != 0) {
+            numBlocks++;
+        } else if (oldID != 0 && id == 0) {
+            numBlocks--;
+        }
+        blocks.set(blockIndex, id);
     }
 
     // Marks the chunks as dirty and flags for a re-mesh
@@ -103,15 +147,25 @@ class Chunk {
     ChunkGenLevel pendingGenLevel = ChunkGenLevel::GEN_NONE;
     bool isDirty;
     f32 distance2; //< Squared distance
-    int numBlocks;
-    // TODO(Ben): reader/writer lock
-    std::mutex dataMutex;
+    int numBlocks; ///< Non air voxels, see setBlock
+    // Take more than one chunk's lock with MultiChunkLock, never by hand
+    ChunkDataMutex dataMutex;
 
     volatile bool isAccessible = false;
 
     // TODO(Ben): Think about data locality.
     vvox::SmartVoxelContainer<ui16> blocks;
     vvox::SmartVoxelContainer<ui16> tertiary;
+    vvox::SmartVoxelContainer<ui16> sunlight; ///< 0 to MAX_LIGHT
+    vvox::SmartVoxelContainer<ui16> lamp; ///< Packed 5 bit RGB, see VoxelBits.h
+    // Light sent by neighbors and voxel edits, processed by VoxelLightEngine
+    std::mutex lightInboxMutex;
+    std::vector<LightMessage> lightInbox;
+    volatile bool isLit = false; ///< Set once VoxelLightEngine has seeded the light
+    ChunkVoxelSet caActive; ///< Voxels for CAEngine to step next tick. Guarded by dataMutex.
+    ChunkVoxelSet tickVoxels; ///< Voxels that get random ticks, may hold stale entries. Guarded by dataMutex.
+    ChunkCollisionMask collidable; ///< Voxels that collide. Guarded by dataMutex.
+    std::atomic<VoxelNodeBatch*> nodeInbox; ///< Nodes from neighbors waiting for our terrain, see VoxelNodeSetter
     // Block indexes where flora must be generated.
     std::vector<ui16> floraToGenerate;
     volatile ui32 updateVersion;
@@ -1,6 +1,7 @@
 #include "stdafx.h"
 #include "ChunkAllocator.h"
 #include "Chunk.h"
+#include "VoxelNodeSetter.h"
 
 #define MAX_VOXEL_ARRAYS_TO_CACHE 200
 #define NUM_SHORT_VOXEL_ARRAYS 3
@@ -49,6 +50,8 @@ Chunk* PagedChunkAllocator::alloc() {
     chunk->updateVersion = INITIAL_UPDATE_VERSION;
     memset(chunk->neighbors, 0, sizeof(chunk->neighbors));
     chunk->m_genQueryData.current = nullptr;
+    chunk->nodeInbox = nullptr;
+    chunk->collidable.clear();
     return chunk;
 }
 
@@ -60,5 +63,12 @@ void PagedChunkAllocator::free(Chunk* chunk) {
     // Free data
     chunk->blocks.clear();
     chunk->tertiary.clear();
+    chunk->sunlight.clear();
+    chunk->lamp.clear();
+    std::vector<LightMessage>().swap(chunk->lightInbox);
+    chunk->caActive.dispose();
+    chunk->tickVoxels.dispose();
+    VoxelNodeSetter::clearInbox(chunk);
+    chunk->isLit = false;
     std::vector<ChunkQuery*>().swap(chunk->m_genQueryData.pending);
 }
@@ -0,0 +1,60 @@
+#include "stdafx.h"
+#include "ChunkCollisionMask.h"
+
+#include "BlockPack.h"
+
+void ChunkCollisionMask::init(const vvox::SmartVoxelContainer<ui16>& blocks, const BlockPack& blockPack) {
+    clear();
+    if (blocks.getState() == vvox::VoxelStorageState::INTERVAL_TREE) {
+        // Only look up each run's block once
+        auto& dataTree = blocks.getTree();
+        for (size_t i = 0; i < dataTree.size(); i++) {
+            if (blockPack[dataTree[i].data].collide) setRange(dataTree[i].getStart(), dataTree[i].length);
+        }
+    } else {
+        const ui16* blockIDs = blocks.getDataArray();
+        for (int i = 0; i < CHUNK_SIZE; i++) {
+            if (blockPack[blockIDs[i]].collide) {
+                m_bits[i >> 6] |= 1ull << (i & 63);
+                m_count++;
+            }
+        }
+    }
+    countBricks();
+}
+
+inline ui32 popCount(ui64 v) {
+    v = v - ((v >> 1) & 0x5555555555555555ull);
+    v = (v & 0x3333333333333333ull) + ((v >> 2) & 0x3333333333333333ull);
+    v = (v + (v >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+    return (ui32)((v * 0x0101010101010101ull) >> 56);
+}
+
+void ChunkCollisionMask::countBricks() {
+    memset(m_brickCounts, 0, sizeof(m_brickCounts));
+    if (m_count == 0) return;
+    // Each word is two rows with the same y and brick z. Byte b of a row is brick x b.
+    const ui64 BRICK_X_MASK = 0x000000FF000000FFull;
+    for (int w = 0; w < CHUNK_SIZE / 64; w++) {
+        ui64 word = m_bits[w];
+        if (!word) continue;
+        int i = w << 6;
+        int brick = getBrickIndex((ui16)i);
+        for (int bx = 0; bx < 4; bx++) {
+            m_brickCounts[brick + bx] += (ui16)popCount(word & (BRICK_X_MASK << (bx * 8)));
+        }
+    }
+}
+
+void ChunkCollisionMask::setRange(int start, int length) {
+    // Assumes the range is clear, which it is during init
+    m_count += length;
+    int end = start + length;
+    while (start < end) {
+        int bit = start & 63;
+        int n = vmath::min(64 - bit, end - start);
+        ui64 mask = (n == 64) ? ~0ull : (((1ull << n) - 1) << bit);
+        m_bits[start >> 6] |= mask;
+        start += n;
+    }
+}
@@ -0,0 +1,84 @@
+///
+/// ChunkCollisionMask.h
+/// Seed of Andromeda
+///
+/// Copyright 2014 Regrowth Studios
+/// All Rights Reserved
+///
+/// Summary:
+/// One bit per voxel marking the voxels in a chunk that collide.
+///
+
+#pragma once
+
+#ifndef ChunkCollisionMask_h__
+#define ChunkCollisionMask_h__
+
+#include "Constants.h"
+#include "SmartVoxelContainer.hpp"
+
+class BlockPack;
+
+// Chunks are split into 4x4x4 bricks of 8^3 voxels for fast empty space skipping
+#define COLLISION_BRICK_WIDTH 8
+#define COLLISION_BRICKS_PER_CHUNK 64
+
+/// Mirrors Block::collide for every voxel, so collision and rays never
+/// have to read the block container or BlockPack. Whoever writes the
+/// chunk's blocks keeps it in sync. Guarded by the chunk's dataMutex.
+class ChunkCollisionMask {
+public:
+    ChunkCollisionMask() { clear(); }
+
+    bool get(ui16 blockIndex) const {
+        return ((m_bits[blockIndex >> 6] >> (blockIndex & 63)) & 1) != 0;
+    }
+    void set(ui16 blockIndex, bool collide) {
+        ui64& word = m_bits[blockIndex >> 6];
+        ui64 bit = 1ull << (blockIndex & 63);
+        if (((word & bit) != 0) == collide) return;
+        word ^= bit;
+        ui16& brickCount = m_brickCounts[getBrickIndex(blockIndex)];
+        if (collide) {
+            m_count++;
+            brickCount++;
+        } else {
+            m_count--;
+            brickCount--;
+        }
+    }
+    /// @return Bits for the row of voxels along x, bit i is x == i
+    ui32 getRow(int y, int z) const {
+        // Rows are 32 voxels long, so they never straddle a word
+        int start = y * CHUNK_LAYER + z * CHUNK_WIDTH;
+        return (ui32)(m_bits[start >> 6] >> (start & 63));
+    }
+    /// Rebuilds the mask from block data
+    void init(const vvox::SmartVoxelContainer<ui16>& blocks, const BlockPack& blockPack);
+    void clear() {
+        memset(m_bits, 0, sizeof(m_bits));
+        memset(m_brickCounts, 0, sizeof(m_brickCounts));
+        m_count = 0;
+    }
+    /// @return true if no voxel in the brick holding local position x, y, z collides
+    bool isBrickEmpty(int x, int y, int z) const {
+        return m_brickCounts[((y >> 3) << 4) | ((z >> 3) << 2) | (x >> 3)] == 0;
+    }
+
+    /// @return Number of voxels that collide
+    ui32 getCount() const { return m_count; }
+    bool empty() const { return m_count == 0; }
+private:
+    static int getBrickIndex(ui16 blockIndex) {
+        // x + z * 32 + y * 1024 to bx + bz * 4 + by * 16
+        return ((blockIndex >> 13) << 4) | (((blockIndex >> 8) & 0x3) << 2) | ((blockIndex >> 3) & 0x3);
+    }
+    void setRange(int start, int length);
+    void countBricks();
+
+    ui64 m_bits[CHUNK_SIZE / 64];
+    ui16 m_brickCounts[COLLISION_BRICKS_PER_CHUNK];
+    ui32 m_count;
+};
+
+#endif // ChunkCollisionMask_h__
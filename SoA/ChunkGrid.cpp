@@ -12,6 +12,7 @@ void ChunkGrid::init(WorldCubeFace face,
                       PlanetGenData* genData,
                       PagedChunkAllocator* allocator) {
     m_face = face;
+    m_threadPool = threadPool;
     generatorsPerRow = generatorsPerRow;
     numGenerators = generatorsPerRow * generatorsPerRow;
     generators = new ChunkGenerator[numGenerators];
@@ -22,10 +23,26 @@ void ChunkGrid::init(WorldCubeFace face,
     accessor.onAdd += makeDelegate(*this, &ChunkGrid::onAccessorAdd);
     accessor.onRemove += makeDelegate(*this, &ChunkGrid::onAccessorRemove);
     nodeSetter.grid = this;
-    nodeSetter.threadPool = threadPool;
+    caScheduler.init(this, threadPool);
+    interest.init(this);
 }
 
 void ChunkGrid::dispose() {
+    interest.dispose();
+
+    // Drop prefetches that never ran
+    LowPriorityRequest request;
+    while (m_lowPriorityRequests.try_dequeue(request)) {
+        if (request.query) dropQuery(request.query);
+    }
+    for (size_t i = m_waitingHead; i < m_waitingQueries.size(); i++) {
+        if (m_waitingQueries[i]) dropQuery(m_waitingQueries[i]);
+    }
+    std::vector<ChunkQuery*>().swap(m_waitingQueries);
+    m_waitingIndices.clear();
+    m_waitingHead = 0;
+
+    caScheduler.dispose();
     accessor.onAdd -= makeDelegate(*this, &ChunkGrid::onAccessorAdd);
     accessor.onRemove -= makeDelegate(*this, &ChunkGrid::onAccessorRemove);
     delete[] generators;
@@ -33,19 +50,7 @@ void ChunkGrid::dispose() {
 }
 
 ChunkQuery* ChunkGrid::submitQuery(const i32v3& chunkPos, ChunkGenLevel genLevel, bool shouldRelease) {
-    ChunkQuery* query;
-    {
-        std::lock_guard<std::mutex> l(m_lckQueryRecycler);
-        query = m_queryRecycler.create();
-    }
-    query->chunkPos = chunkPos;
-    query->genLevel = genLevel;
-    query->shouldRelease = shouldRelease;
-    query->grid = this;
-    query->m_isFinished = false;
-
-    ChunkID id(query->chunkPos);
-    query->chunk = accessor.acquire(id);
+    ChunkQuery* query = createQuery(chunkPos, genLevel, shouldRelease);
     m_queries.enqueue(query);
     // TODO(Ben): RACE CONDITION HERE: There is actually a very small chance that
     // chunk will get freed before the callee can acquire the chunk, if this runs
@@ -53,6 +58,22 @@ ChunkQuery* ChunkGrid::submitQuery(const i32v3& chunkPos, ChunkGenLevel genLevel
     return query;
 }
 
+ChunkQuery* ChunkGrid::submitLowPriorityQuery(const i32v3& chunkPos, ChunkGenLevel genLevel, bool shouldRelease) {
+    ChunkQuery* query = createQuery(chunkPos, genLevel, shouldRelease);
+    LowPriorityRequest request;
+    request.query = query;
+    request.id = query->chunk.getID();
+    m_lowPriorityRequests.enqueue(request);
+    return query;
+}
+
+void ChunkGrid::cancelLowPriorityQuery(const i32v3& chunkPos) {
+    LowPriorityRequest request;
+    request.query = nullptr;
+    request.id = ChunkID(chunkPos);
+    m_lowPriorityRequests.enqueue(request);
+}
+
 void ChunkGrid::releaseQuery(ChunkQuery* query) {
     assert(query->grid);
     query->grid = nullptr;
@@ -73,6 +94,9 @@ void ChunkGrid::update() {
     // TODO(Ben): Handle generator distribution
     generators[0].update();
 
+    // Apply the spheres' interest changes first so their queries go out this update
+    interest.update();
+
     /* Update Queries */
     // Needs to be big so we can flush it every frame.
 #define MAX_QUERIES 5000
@@ -80,13 +104,117 @@ void ChunkGrid::update() {
     size_t numQueries = m_queries.try_dequeue_bulk(queries, MAX_QUERIES);
     for (size_t i = 0; i < numQueries; i++) {
         ChunkQuery* q = queries[i];
-        // TODO(Ben): Handle generator distribution
-        q->genTask.init(q, q->chunk->gridData->heightData, &generators[0]);
-        generators[0].submitQuery(q);
+        // Promote any prefetch of this chunk that is still waiting
+        if (m_waitingIndices.size()) {
+            auto it = m_waitingIndices.find(q->chunk.getID());
+            if (it != m_waitingIndices.end()) {
+                dispatchQuery(m_waitingQueries[it->second.index]);
+                m_waitingQueries[it->second.index] = nullptr;
+                m_waitingIndices.erase(it);
+            }
+        }
+        dispatchQuery(q);
     }
-    
-    // Place any needed nodes
-    nodeSetter.update();
+    updateLowPriorityQueries();
+
+    // Liquids and powders
+    caScheduler.update();
+}
+
+ChunkQuery* ChunkGrid::createQuery(const i32v3& chunkPos, ChunkGenLevel genLevel, bool shouldRelease) {
+    ChunkQuery* query;
+    {
+        std::lock_guard<std::mutex> l(m_lckQueryRecycler);
+        query = m_queryRecycler.create();
+    }
+    query->chunkPos = chunkPos;
+    query->genLevel = genLevel;
+    query->shouldRelease = shouldRelease;
+    query->grid = this;
+    query->m_isFinished = false;
+
+    ChunkID id(query->chunkPos);
+    query->chunk = accessor.acquire(id);
+    return query;
+}
+
+void ChunkGrid::dispatchQuery(ChunkQuery* query) {
+    // TODO(Ben): Handle generator distribution
+    query->genTask.init(query, query->chunk->gridData->heightData, &generators[0]);
+    generators[0].submitQuery(query);
+}
+
+void ChunkGrid::updateLowPriorityQueries() {
+    // Low priority work only goes out while the workers are nearly idle
+#define LOW_PRIORITY_TASK_THRESHOLD 4
+#define MAX_LOW_PRIORITY_DISPATCHES 16
+#define MAX_WAITING_LOW_PRIORITY_QUERIES 4096
+    // Requests are applied in order so a cancel only affects earlier submits
+    LowPriorityRequest request;
+    while (m_lowPriorityRequests.try_dequeue(request)) {
+        auto it = m_waitingIndices.find(request.id);
+        if (request.query) {
+            if (it == m_waitingIndices.end()) {
+                WaitingQuery& waiting = m_waitingIndices[request.id];
+                waiting.index = m_waitingQueries.size();
+                waiting.refCount = 1;
+                m_waitingQueries.push_back(request.query);
+            } else {
+                // Already waiting, the new requester shares that query
+                it->second.refCount++;
+                dropQuery(request.query);
+            }
+        } else if (it != m_waitingIndices.end() && --it->second.refCount == 0) {
+            dropQuery(m_waitingQueries[it->second.index]);
+            m_waitingQueries[it->second.index] = nullptr;
+            m_waitingIndices.erase(it);
+        }
+    }
+
+    // The oldest prefetches are the least likely to still be on the path
+    ChunkQuery* query;
+    while (m_waitingIndices.size() > MAX_WAITING_LOW_PRIORITY_QUERIES) {
+        query = m_waitingQueries[m_waitingHead++];
+        if (!query) continue;
+        m_waitingIndices.erase(query->chunk.getID());
+        dropQuery(query);
+    }
+
+    int dispatches = 0;
+    while (m_waitingHead < m_waitingQueries.size() && dispatches < MAX_LOW_PRIORITY_DISPATCHES) {
+        if (m_threadPool && m_threadPool->getTasksSizeApprox() >= LOW_PRIORITY_TASK_THRESHOLD) break;
+        query = m_waitingQueries[m_waitingHead];
+        if (query) {
+            m_waitingIndices.erase(query->chunk.getID());
+            dispatchQuery(query);
+            dispatches++;
+        }
+        m_waitingHead++;
+    }
+
+    if (m_waitingHead == m_waitingQueries.size()) {
+        m_waitingQueries.clear();
+        m_waitingHead = 0;
+    } else if (m_waitingQueries.size() - m_waitingHead > m_waitingIndices.size() * 2) {
+        // Mostly holes from cancels, pack the live queries back to the front
+        size_t live = 0;
+        for (size_t i = m_waitingHead; i < m_waitingQueries.size(); i++) {
+            query = m_waitingQueries[i];
+            if (!query) continue;
+            m_waitingIndices.find(query->chunk.getID())->second.index = live;
+            m_waitingQueries[live++] = query;
+        }
+        m_waitingQueries.resize(live);
+        m_waitingHead = 0;
+    }
+#undef MAX_WAITING_LOW_PRIORITY_QUERIES
+#undef MAX_LOW_PRIORITY_DISPATCHES
+#undef LOW_PRIORITY_TASK_THRESHOLD
+}
+
+void ChunkGrid::dropQuery(ChunkQuery* query) {
+    query->chunk.release();
+    if (query->shouldRelease) query->release();
 }
 
 void ChunkGrid::onAccessorAdd(Sender s, ChunkHandle& chunk) {
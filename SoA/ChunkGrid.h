@@ -25,7 +25,9 @@
 #include "ChunkAllocator.h"
 #include "ChunkAccessor.h"
 #include "ChunkHandle.h"
+#include "ChunkInterestManager.h"
 
+#include "CAScheduler.h"
 #include "VoxelNodeSetter.h"
 
 class BlockPack;
@@ -45,6 +47,13 @@ class ChunkGrid {
     /// @param genLevel: The required generation level.
     /// @param shouldRelease: Will automatically release when true.
     ChunkQuery* submitQuery(const i32v3& chunkPos, ChunkGenLevel genLevel, bool shouldRelease);
+    /// Like submitQuery, but the query waits until the thread pool is nearly
+    /// idle before it is handed to the generator. A normal query for the same
+    /// chunk promotes it. Used to prefetch chunks before they are needed.
+    ChunkQuery* submitLowPriorityQuery(const i32v3& chunkPos, ChunkGenLevel genLevel, bool shouldRelease);
+    /// Drops the waiting low priority query for a chunk once every requester
+    /// of it has cancelled. Queries already handed to the generator still run.
+    void cancelLowPriorityQuery(const i32v3& chunkPos);
     /// Releases and recycles a query.
     void releaseQuery(ChunkQuery* query);
 
@@ -70,6 +79,8 @@ class ChunkGrid {
     BlockPack* blockPack = nullptr; ///< Handle to the block pack for this grid
 
     VoxelNodeSetter nodeSetter;
+    CAScheduler caScheduler;
+    ChunkInterestManager interest; ///< Shared by every chunk sphere on this grid
 
     Event<ChunkHandle&> onNeighborsAcquire;
     Event<ChunkHandle&> onNeighborsRelease;
@@ -80,7 +91,30 @@ class ChunkGrid {
     void onAccessorAdd(Sender s, ChunkHandle& chunk);
     void onAccessorRemove(Sender s, ChunkHandle& chunk);
 
+    ChunkQuery* createQuery(const i32v3& chunkPos, ChunkGenLevel genLevel, bool shouldRelease);
+    void dispatchQuery(ChunkQuery* query);
+    void updateLowPriorityQueries();
+    /// Releases a query that will never be dispatched
+    void dropQuery(ChunkQuery* query);
+
+    /// A low priority query, or a cancellation when query is null
+    struct LowPriorityRequest {
+        ChunkQuery* query;
+        ChunkID id;
+    };
+    struct WaitingQuery {
+        size_t index; ///< Index into m_waitingQueries
+        ui32 refCount; ///< Requesters that haven't cancelled
+    };
+
     moodycamel::ConcurrentQueue<ChunkQuery*> m_queries;
+    moodycamel::ConcurrentQueue<LowPriorityRequest> m_lowPriorityRequests;
+    // Low priority queries not yet dispatched, in submission order. Promoted,
+    // cancelled and dropped ones are null. Only one per chunk.
+    std::vector<ChunkQuery*> m_waitingQueries;
+    size_t m_waitingHead = 0;
+    std::unordered_map<ChunkID, WaitingQuery> m_waitingIndices;
+    vcore::ThreadPool<WorkerData>* m_threadPool = nullptr;
 
     std::mutex m_lckActiveChunks;
     std::vector<ChunkHandle> m_activeChunks;
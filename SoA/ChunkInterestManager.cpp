@@ -0,0 +1,107 @@
+#include "stdafx.h"
+#include "ChunkInterestManager.h"
+
+#include "ChunkGrid.h"
+
+void ChunkInterestManager::init(ChunkGrid* grid) {
+    m_grid = grid;
+}
+
+void ChunkInterestManager::dispose() {
+    for (auto& it : m_chunks) {
+        InterestEntry& entry = it.second;
+        if (entry.counts.meshed > 0) m_grid->onNeighborsRelease(entry.chunk);
+        releaseAndDisconnect(entry);
+    }
+    std::unordered_map<ChunkID, InterestEntry>().swap(m_chunks);
+    std::unordered_map<ChunkID, InterestCounts>().swap(m_changes);
+}
+
+void ChunkInterestManager::addInterest(const i32v3& chunkPos, bool meshed) {
+    InterestCounts& change = m_changes[ChunkID(chunkPos)];
+    change.loaded++;
+    if (meshed) change.meshed++;
+}
+
+void ChunkInterestManager::removeInterest(const i32v3& chunkPos, bool meshed) {
+    InterestCounts& change = m_changes[ChunkID(chunkPos)];
+    change.loaded--;
+    if (meshed) change.meshed--;
+}
+
+void ChunkInterestManager::update() {
+    for (auto& it : m_changes) {
+        const InterestCounts& change = it.second;
+        if (change.loaded == 0 && change.meshed == 0) continue;
+
+        InterestEntry& entry = m_chunks[it.first];
+        InterestCounts old = entry.counts;
+        entry.counts.loaded += change.loaded;
+        entry.counts.meshed += change.meshed;
+        assert(entry.counts.loaded >= 0 && entry.counts.meshed >= 0);
+
+        if (old.loaded <= 0 && entry.counts.loaded > 0) {
+            acquireAndConnect(entry, it.first);
+        }
+        // Call the events before releasing to prevent race condition
+        if (old.meshed <= 0 && entry.counts.meshed > 0) {
+            m_grid->onNeighborsAcquire(entry.chunk);
+        } else if (old.meshed > 0 && entry.counts.meshed <= 0) {
+            m_grid->onNeighborsRelease(entry.chunk);
+        }
+        if (entry.counts.loaded <= 0) {
+            if (old.loaded > 0) releaseAndDisconnect(entry);
+            m_chunks.erase(it.first);
+        }
+    }
+    m_changes.clear();
+}
+
+void ChunkInterestManager::acquireAndConnect(InterestEntry& entry, const ChunkID& id) {
+    ChunkHandle& h = entry.chunk;
+    h = m_grid->submitQuery(i32v3(id.x, id.y, id.z), GEN_DONE, true)->chunk.acquire();
+    // TODO(Ben): meshableNeighbors
+    // Acquire the 6 neighbors
+    ChunkAccessor& accessor = m_grid->accessor;
+    { // Left
+        ChunkID nid = id;
+        nid.x--;
+        h->left = accessor.acquire(nid);
+    }
+    { // Right
+        ChunkID nid = id;
+        nid.x++;
+        h->right = accessor.acquire(nid);
+    }
+    { // Bottom
+        ChunkID nid = id;
+        nid.y--;
+        h->bottom = accessor.acquire(nid);
+    }
+    { // Top
+        ChunkID nid = id;
+        nid.y++;
+        h->top = accessor.acquire(nid);
+    }
+    { // Back
+        ChunkID nid = id;
+        nid.z--;
+        h->back = accessor.acquire(nid);
+    }
+    { // Front
+        ChunkID nid = id;
+        nid.z++;
+        h->front = accessor.acquire(nid);
+    }
+}
+
+void ChunkInterestManager::releaseAndDisconnect(InterestEntry& entry) {
+    ChunkHandle& h = entry.chunk;
+    h->left.release();
+    h->right.release();
+    h->back.release();
+    h->front.release();
+    h->bottom.release();
+    h->top.release();
+    h.release();
+}
@@ -0,0 +1,63 @@
+///
+/// ChunkInterestManager.h
+/// Seed of Andromeda
+///
+/// Copyright 2014 Regrowth Studios
+/// All Rights Reserved
+///
+/// Summary:
+/// Reference counted interest in the chunks of a grid, shared by
+/// every chunk sphere on it.
+///
+
+#pragma once
+
+#ifndef ChunkInterestManager_h__
+#define ChunkInterestManager_h__
+
+#include "ChunkHandle.h"
+#include "ChunkID.h"
+
+class ChunkGrid;
+
+/// Observers add and remove interest in chunks, and the union of all
+/// interest decides which chunks are loaded. Changes are only diffed
+/// once per update, so interest that is removed and added again in the
+/// same update costs nothing. Not thread safe, use from the update thread.
+class ChunkInterestManager {
+public:
+    void init(ChunkGrid* grid);
+    /// Releases every chunk regardless of interest
+    void dispose();
+
+    /// @param meshed: True if the observer wants the chunk meshed as well as loaded
+    void addInterest(const i32v3& chunkPos, bool meshed);
+    /// Removes interest added with the same arguments
+    void removeInterest(const i32v3& chunkPos, bool meshed);
+
+    /// Applies the changes since the last update. Chunks that gained their
+    /// first interest are generated and connected to their neighbors, and
+    /// chunks that lost their last are released.
+    void update();
+
+    /// @return the number of chunks with interest
+    size_t getNumChunks() const { return m_chunks.size(); }
+private:
+    struct InterestCounts {
+        i32 loaded = 0;
+        i32 meshed = 0;
+    };
+    struct InterestEntry {
+        InterestCounts counts;
+        ChunkHandle chunk; ///< Connected to its neighbors
+    };
+
+    void acquireAndConnect(InterestEntry& entry, const ChunkID& id);
+    void releaseAndDisconnect(InterestEntry& entry);
+
+    ChunkGrid* m_grid = nullptr;
+    std::unordered_map<ChunkID, InterestCounts> m_changes; ///< Net change since the last update
+    std::unordered_map<ChunkID, InterestEntry> m_chunks;
+};
+
+#endif // ChunkInterestManager_h__
@@ -0,0 +1,97 @@
+#include "stdafx.h"
+#include "ChunkLock.h"
+
+#include "Chunk.h"
+
+void ChunkDataMutex::lock() {
+    std::unique_lock<std::mutex> l(m_mutex);
+    m_numWaitingWriters++;
+    m_writerCond.wait(l, [this] { return !m_hasWriter && m_numReaders == 0; });
+    m_numWaitingWriters--;
+    m_hasWriter = true;
+}
+
+void ChunkDataMutex::unlock() {
+    bool wakeWriter;
+    {
+        std::lock_guard<std::mutex> l(m_mutex);
+        m_hasWriter = false;
+        wakeWriter = m_numWaitingWriters != 0;
+    }
+    if (wakeWriter) {
+        m_writerCond.notify_one();
+    } else {
+        m_readerCond.notify_all();
+    }
+}
+
+void ChunkDataMutex::lock_shared() {
+    std::unique_lock<std::mutex> l(m_mutex);
+    m_readerCond.wait(l, [this] { return !m_hasWriter && m_numWaitingWriters == 0; });
+    m_numReaders++;
+}
+
+void ChunkDataMutex::unlock_shared() {
+    bool wakeWriter;
+    {
+        std::lock_guard<std::mutex> l(m_mutex);
+        m_numReaders--;
+        wakeWriter = m_numReaders == 0 && m_numWaitingWriters != 0;
+    }
+    if (wakeWriter) m_writerCond.notify_one();
+}
+
+void MultiChunkLock::add(Chunk* chunk, ChunkLockMode mode) {
+    if (m_chunks.size()) m_isSorted = false;
+    m_chunks.push_back({ chunk, mode });
+}
+
+void MultiChunkLock::lock() {
+    if (m_isLocked) return;
+    if (!m_isSorted) {
+        // Grids on different faces share IDs, so the pointer breaks ties
+        std::sort(m_chunks.begin(), m_chunks.end(), [](const LockEntry& a, const LockEntry& b) {
+            ui64 ida = a.chunk->getID().id;
+            ui64 idb = b.chunk->getID().id;
+            if (ida != idb) return ida < idb;
+            return a.chunk < b.chunk;
+        });
+        // Merge duplicates, the mutex isn't recursive
+        size_t n = 0;
+        for (size_t i = 0; i < m_chunks.size(); i++) {
+            if (n && m_chunks[n - 1].chunk == m_chunks[i].chunk) {
+                if (m_chunks[i].mode == ChunkLockMode::WRITE) m_chunks[n - 1].mode = ChunkLockMode::WRITE;
+            } else {
+                m_chunks[n++] = m_chunks[i];
+            }
+        }
+        m_chunks.resize(n);
+        m_isSorted = true;
+    }
+    for (auto& entry : m_chunks) {
+        if (entry.mode == ChunkLockMode::WRITE) {
+            entry.chunk->dataMutex.lock();
+        } else {
+            entry.chunk->dataMutex.lock_shared();
+        }
+    }
+    m_isLocked = true;
+}
+
+void MultiChunkLock::unlock() {
+    if (!m_isLocked) return;
+    for (auto& entry : m_chunks) {
+        if (entry.mode == ChunkLockMode::WRITE) {
+            entry.chunk->dataMutex.unlock();
+        } else {
+            entry.chunk->dataMutex.unlock_shared();
+        }
+    }
+    m_isLocked = false;
+}
+
+void MultiChunkLock::clear() {
+    unlock();
+    m_chunks.clear();
+    m_isSorted = true;
+}
@@ -0,0 +1,91 @@
+///
+/// ChunkLock.h
+/// Seed of Andromeda
+///
+/// Copyright 2014 Regrowth Studios
+/// All Rights Reserved
+///
+/// Summary:
+/// Reader/writer lock for chunk data, and a scoped lock that takes
+/// several chunks at once without risking deadlock.
+///
+
+#pragma once
+
+#ifndef ChunkLock_h__
+#define ChunkLock_h__
+
+#include <condition_variable>
+#include <mutex>
+
+class Chunk;
+
+/// Many readers or one writer. Waiting writers block new readers, so
+/// constant meshing and raycasts can't starve edits. Not recursive, a
+/// thread must not take the same chunk twice.
+/// Works with std::lock_guard and std::unique_lock for writing.
+class ChunkDataMutex {
+public:
+    void lock();
+    void unlock();
+    void lock_shared();
+    void unlock_shared();
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_readerCond;
+    std::condition_variable m_writerCond;
+    ui32 m_numReaders = 0;
+    ui32 m_numWaitingWriters = 0;
+    bool m_hasWriter = false;
+};
+
+typedef std::lock_guard<ChunkDataMutex> ChunkWriteLock;
+
+/// Scoped read lock on a single chunk
+class ChunkReadLock {
+public:
+    ChunkReadLock(ChunkDataMutex& mutex) : m_mutex(mutex) { m_mutex.lock_shared(); }
+    ~ChunkReadLock() { m_mutex.unlock_shared(); }
+    ChunkReadLock(const ChunkReadLock&) = delete;
+    ChunkReadLock& operator=(const ChunkReadLock&) = delete;
+private:
+    ChunkDataMutex& m_mutex;
+};
+
+enum class ChunkLockMode { READ, WRITE };
+
+/// Locks a set of chunks in ChunkID order. Any code that holds more than
+/// one chunk's dataMutex at a time must go through this, so that every
+/// thread takes chunks in the same order and none can wait on each other.
+/// Chunks must stay acquired while locked.
+class MultiChunkLock {
+public:
+    MultiChunkLock() {}
+    ~MultiChunkLock() { unlock(); }
+    MultiChunkLock(const MultiChunkLock&) = delete;
+    MultiChunkLock& operator=(const MultiChunkLock&) = delete;
+
+    /// Adds a chunk to the set. May only be called while unlocked. Adding a
+    /// chunk twice is fine, it is written if any add asked for WRITE.
+    void add(Chunk* chunk, ChunkLockMode mode);
+    /// Locks every chunk in the set
+    void lock();
+    /// Unlocks every chunk but keeps the set, so it can be locked again
+    void unlock();
+    /// Unlocks and empties the set
+    void clear();
+
+    bool isLocked() const { return m_isLocked; }
+    size_t size() const { return m_chunks.size(); }
+private:
+    struct LockEntry {
+        Chunk* chunk;
+        ChunkLockMode mode;
+    };
+
+    std::vector<LockEntry> m_chunks;
+    bool m_isSorted = true;
+    bool m_isLocked = false;
+};
+
+#endif // ChunkLock_h__
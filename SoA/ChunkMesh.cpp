@@ -23,6 +23,18 @@ ChunkMeshData::ChunkMeshData(MeshTaskType type) : type(type) {
     // Empty
 }
 
+void ChunkMeshData::clear(MeshTaskType type) {
+    this->type = type;
+    chunkMeshRenderData = ChunkMeshRenderData();
+    opaqueQuads.clear();
+    transQuads.clear();
+    cutoutQuads.clear();
+    waterVertices.clear();
+    transVertIndex = 0;
+    transQuadPositions.clear();
+    transQuadIndices.clear();
+}
+
 void ChunkMeshData::addTransQuad(const i8v3& pos) {
     transQuadPositions.push_back(pos);
 
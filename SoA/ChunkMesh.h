@@ -2,6 +2,7 @@
 #include "Vertex.h"
 #include "BlockTextureMethods.h"
 #include "ChunkHandle.h"
+#include "ChunkMeshBufferAllocator.h"
 #include <Vorb/io/Keg.h>
 #include <Vorb/graphics/gtypes.h>
 
@@ -24,6 +25,17 @@ class ChunkGridData;
 class ChunkMesh;
 class ChunkMeshTask;
 
+// Face connectivity for occlusion culling. Faces are ordered like the
+// opaque face groups: -x, +x, -y, +y, -z, +z. One bit per pair of faces.
+#define CHUNK_FACE_NONE 6
+#define CHUNK_FACE_CONNECTIVITY_ALL 0x7FFF
+
+inline ui16 getFacePairBit(int a, int b) {
+    if (a == b) return 0;
+    if (a > b) std::swap(a, b);
+    return (ui16)(1 << (a * (11 - a) / 2 + b - a - 1));
+}
+
 class ChunkMeshRenderData {
 public:
     // TODO(Ben): These can be ui16
@@ -49,6 +61,7 @@ class ChunkMeshRenderData {
     i32 lowestZ = INT_MAX;
     ui32 indexSize = 0;
     ui32 waterIndexSize = 0;
+    ui16 faceConnectivity = CHUNK_FACE_CONNECTIVITY_ALL; ///< Which faces can see each other through the chunk
 };
 
 struct VoxelQuad {
@@ -73,6 +86,8 @@ class ChunkMeshData
     ChunkMeshData::ChunkMeshData(MeshTaskType type);
 
     void addTransQuad(const i8v3& pos);
+    /// Resets for reuse without freeing vector capacity
+    void clear(MeshTaskType type);
 
     ChunkMeshRenderData chunkMeshRenderData;
 
@@ -119,9 +134,21 @@ class ChunkMesh
         VGVertexArray vaos[4];
     };
 
+    // Ranges in the ChunkMeshBufferPool, used instead of vboID and
+    // cutoutVboID when the mesh is owned by the ChunkMeshManager.
+    MeshBufferAllocation opaqueAlloc;
+    MeshBufferAllocation cutoutAlloc;
+
     f64 distance2 = 32.0;
-    f64v3 position;
+    f64v3 position; ///< Min corner in the render face's voxel space, see ChunkMeshManager::setRenderFace
+    // Chunks on a neighboring cube face are turned to line up with the render face
+    f64v3 origin; ///< Where the chunk's own voxel origin lands in the render face's space
+    i32v3 axisX = i32v3(1, 0, 0); ///< Render face direction of the chunk's +x
+    i32v3 axisZ = i32v3(0, 0, 1); ///< Render face direction of the chunk's +z
+    ChunkHandle chunk; ///< Held by the ChunkMeshManager so it can remesh when the LOD changes
+    ui8 lod = 0; ///< Level of detail of the most recent mesh task
     ui32 activeMeshesIndex = ACTIVE_MESH_INDEX_NONE; ///< Index into active meshes array
+    ui32 occlusionFrame = 0; ///< Equals ChunkMeshManager::getOcclusionFrame() when not occluded
     ui32 updateVersion;
     bool inFrustum = false;
     bool needsSort = true;
@@ -129,6 +156,14 @@ class ChunkMesh
 
     //*** Transparency info for sorting ***
     VGIndexBuffer transIndexID = 0;
+    i32v3 sortPosition; ///< Camera voxel position at the last sort
     std::vector<i8v3> transQuadPositions;
     std::vector<ui32> transQuadIndices;
+
+    /// Converts a render face position into the chunk's own voxel axes,
+    /// relative to its origin, so it can be compared with renderData bounds
+    f64v3 toChunkSpace(const f64v3& renderPosition) const {
+        f64v3 d = renderPosition - origin;
+        return f64v3(d.x * axisX.x + d.z * axisX.z, d.y, d.x * axisZ.x + d.z * axisZ.z);
+    }
 };
@@ -0,0 +1,120 @@
+#include "stdafx.h"
+#include "ChunkMeshBufferAllocator.h"
+
+void ChunkMeshBufferAllocator::init(ui32 pageSize) {
+    m_pageSize = pageSize;
+}
+
+void ChunkMeshBufferAllocator::dispose() {
+    for (auto& page : m_pages) {
+        for (auto& it : page.usedBlocks) {
+            *it.second = MeshBufferAllocation();
+        }
+    }
+    std::vector<Page>().swap(m_pages);
+}
+
+bool ChunkMeshBufferAllocator::alloc(MeshBufferAllocation& allocation, ui32 size) {
+    if (allocation.isValid()) free(allocation);
+    if (size == 0 || size > m_pageSize) return false;
+
+    for (ui32 i = 0; i < m_pages.size(); i++) {
+        // Skip pages that can't possibly fit it
+        if (m_pageSize - m_pages[i].usedSize < size) continue;
+        if (allocFromPage(i, allocation, size)) return true;
+    }
+
+    // Need a new page
+    m_pages.emplace_back();
+    m_pages.back().freeBlocks[0] = m_pageSize;
+    return allocFromPage(m_pages.size() - 1, allocation, size);
+}
+
+void ChunkMeshBufferAllocator::free(MeshBufferAllocation& allocation) {
+    if (!allocation.isValid()) return;
+    Page& page = m_pages[allocation.page];
+    page.usedBlocks.erase(allocation.offset);
+    page.usedSize -= allocation.size;
+
+    ui32 offset = allocation.offset;
+    ui32 size = allocation.size;
+    // Merge with the next free block
+    auto next = page.freeBlocks.find(offset + size);
+    if (next != page.freeBlocks.end()) {
+        size += next->second;
+        page.freeBlocks.erase(next);
+    }
+    // Merge with the previous free block
+    auto it = page.freeBlocks.lower_bound(offset);
+    if (it != page.freeBlocks.begin()) {
+        --it;
+        if (it->first + it->second == offset) {
+            it->second += size;
+            allocation = MeshBufferAllocation();
+            return;
+        }
+    }
+    page.freeBlocks[offset] = size;
+    allocation = MeshBufferAllocation();
+}
+
+void ChunkMeshBufferAllocator::compact(ui32 pageIndex, std::vector<MeshBufferMove>& moves) {
+    Page& page = m_pages[pageIndex];
+    if (page.freeBlocks.size() <= 1 && (page.freeBlocks.empty() ||
+        page.freeBlocks.begin()->first == page.usedSize)) return; // Already compact
+
+    std::map<ui32, MeshBufferAllocation*> usedBlocks;
+    ui32 dst = 0;
+    // std::map iterates in offset order so every move goes to a lower offset
+    for (auto& it : page.usedBlocks) {
+        MeshBufferAllocation* owner = it.second;
+        if (owner->offset != dst) {
+            MeshBufferMove move;
+            move.page = pageIndex;
+            move.srcOffset = owner->offset;
+            move.dstOffset = dst;
+            move.size = owner->size;
+            moves.push_back(move);
+            owner->offset = dst;
+        }
+        usedBlocks.emplace_hint(usedBlocks.end(), dst, owner);
+        dst += owner->size;
+    }
+    page.usedBlocks.swap(usedBlocks);
+    page.freeBlocks.clear();
+    if (dst < m_pageSize) page.freeBlocks[dst] = m_pageSize - dst;
+}
+
+f32 ChunkMeshBufferAllocator::getFragmentation(ui32 page) const {
+    ui32 freeSize = getFreeSize(page);
+    if (freeSize == 0) return 0.0f;
+    return 1.0f - (f32)getLargestFreeBlock(page) / (f32)freeSize;
+}
+
+ui32 ChunkMeshBufferAllocator::getLargestFreeBlock(ui32 page) const {
+    ui32 largest = 0;
+    for (auto& it : m_pages[page].freeBlocks) {
+        if (it.second > largest) largest = it.second;
+    }
+    return largest;
+}
+
+bool ChunkMeshBufferAllocator::allocFromPage(ui32 pageIndex, MeshBufferAllocation& allocation, ui32 size) {
+    Page& page = m_pages[pageIndex];
+    for (auto it = page.freeBlocks.begin(); it != page.freeBlocks.end(); ++it) {
+        if (it->second < size) continue;
+        // Carve from the front of the block
+        ui32 offset = it->first;
+        ui32 remaining = it->second - size;
+        page.freeBlocks.erase(it);
+        if (remaining) page.freeBlocks[offset + size] = remaining;
+
+        allocation.page = pageIndex;
+        allocation.offset = offset;
+        allocation.size = size;
+        page.usedBlocks[offset] = &allocation;
+        page.usedSize += size;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,82 @@
+///
+/// ChunkMeshBufferAllocator.h
+/// Seed of Andromeda
+///
+/// Copyright 2014 Regrowth Studios
+/// All Rights Reserved
+///
+/// Summary:
+/// Free-list suballocator that packs chunk mesh geometry into
+/// a few large fixed size pages. Has no GL dependencies.
+///
+
+#pragma once
+
+#ifndef ChunkMeshBufferAllocator_h__
+#define ChunkMeshBufferAllocator_h__
+
+#include <map>
+
+#define MESH_BUFFER_PAGE_NONE UINT_MAX
+
+/// A contiguous range inside one page. Units are whatever the owner
+/// chooses (ChunkMeshBufferPool uses quads).
+/// The allocator keeps a pointer to this object so it can patch the
+/// offset during compaction, so it must not move while allocated.
+struct MeshBufferAllocation {
+    bool isValid() const { return page != MESH_BUFFER_PAGE_NONE; }
+
+    ui32 page = MESH_BUFFER_PAGE_NONE;
+    ui32 offset = 0;
+    ui32 size = 0;
+};
+
+/// A copy that must be applied to page memory after compact().
+/// Moves always go towards the front of the page and must be applied in order.
+struct MeshBufferMove {
+    ui32 page;
+    ui32 srcOffset;
+    ui32 dstOffset;
+    ui32 size;
+};
+
+class ChunkMeshBufferAllocator {
+public:
+    /// @param pageSize: Capacity of each page
+    void init(ui32 pageSize);
+    /// Frees all pages and allocations
+    void dispose();
+
+    /// Allocates size units using first fit, adding a page if needed.
+    /// @return false if size is zero or larger than a page
+    bool alloc(MeshBufferAllocation& allocation, ui32 size);
+    /// Returns a range to the free list, merging it with its neighbors
+    void free(MeshBufferAllocation& allocation);
+
+    /// Slides every live range in a page to the front so that all of
+    /// the free space becomes a single block. Owner offsets are updated.
+    /// @param moves: Copies the caller must apply, appended in order
+    void compact(ui32 page, std::vector<MeshBufferMove>& moves);
+
+    /// 0 when the free space of a page is one block, approaches 1 as it splinters
+    f32 getFragmentation(ui32 page) const;
+    ui32 getLargestFreeBlock(ui32 page) const;
+    ui32 getUsedSize(ui32 page) const { return m_pages[page].usedSize; }
+    ui32 getNumAllocations(ui32 page) const { return (ui32)m_pages[page].usedBlocks.size(); }
+    ui32 getFreeSize(ui32 page) const { return m_pageSize - m_pages[page].usedSize; }
+    ui32 getNumPages() const { return (ui32)m_pages.size(); }
+    ui32 getPageSize() const { return m_pageSize; }
+private:
+    struct Page {
+        std::map<ui32, ui32> freeBlocks; ///< Offset -> size, always coalesced
+        std::map<ui32, MeshBufferAllocation*> usedBlocks; ///< Offset -> owner
+        ui32 usedSize = 0;
+    };
+
+    bool allocFromPage(ui32 pageIndex, MeshBufferAllocation& allocation, ui32 size);
+
+    std::vector<Page> m_pages;
+    ui32 m_pageSize = 0;
+};
+
+#endif // ChunkMeshBufferAllocator_h__
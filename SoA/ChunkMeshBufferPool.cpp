@@ -0,0 +1,111 @@
+#include "stdafx.h"
+#include "ChunkMeshBufferPool.h"
+
+#include "ChunkMesh.h"
+#include "ChunkRenderer.h"
+
+void ChunkMeshBufferPool::init() {
+    m_allocator.init(CHUNK_MESH_BUFFER_PAGE_QUADS);
+}
+
+void ChunkMeshBufferPool::dispose() {
+    for (auto& page : m_pages) {
+        if (page.vbo) glDeleteBuffers(1, &page.vbo);
+        if (page.vao) glDeleteVertexArrays(1, &page.vao);
+    }
+    std::vector<BufferPage>().swap(m_pages);
+    std::vector<MeshBufferMove>().swap(m_moves);
+    m_allocator.dispose();
+    m_nextCompactPage = 0;
+}
+
+bool ChunkMeshBufferPool::upload(MeshBufferAllocation& allocation, const std::vector<VoxelQuad>& quads) {
+    if (quads.empty()) {
+        free(allocation);
+        return false;
+    }
+    // Reuse the old range in place if the size didn't change
+    if (!allocation.isValid() || allocation.size != quads.size()) {
+        if (!m_allocator.alloc(allocation, quads.size())) return false;
+    }
+    while (m_pages.size() < m_allocator.getNumPages()) {
+        m_pages.emplace_back();
+        createPage(m_pages.back());
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_pages[allocation.page].vbo);
+    glBufferSubData(GL_ARRAY_BUFFER, allocation.offset * sizeof(VoxelQuad), quads.size() * sizeof(VoxelQuad), quads.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    return true;
+}
+
+void ChunkMeshBufferPool::free(MeshBufferAllocation& allocation) {
+    m_allocator.free(allocation);
+}
+
+void ChunkMeshBufferPool::update() {
+    if (m_pages.empty()) return;
+    // Round robin so one busy page can't starve the others
+    ui32 page = m_nextCompactPage++ % m_pages.size();
+    if (m_allocator.getFragmentation(page) < CHUNK_MESH_BUFFER_COMPACT_THRESHOLD) return;
+
+    m_moves.clear();
+    m_allocator.compact(page, m_moves);
+    for (auto& move : m_moves) {
+        applyMove(move);
+    }
+}
+
+void ChunkMeshBufferPool::createPage(BufferPage& page) {
+    glGenBuffers(1, &page.vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, page.vbo);
+    glBufferData(GL_ARRAY_BUFFER, CHUNK_MESH_BUFFER_PAGE_QUADS * sizeof(VoxelQuad), nullptr, GL_STATIC_DRAW);
+
+    // Same layout as ChunkMesher::buildVao
+    glGenVertexArrays(1, &page.vao);
+    glBindVertexArray(page.vao);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ChunkRenderer::sharedIBO);
+
+    for (int i = 0; i < 8; i++) {
+        glEnableVertexAttribArray(i);
+    }
+
+    // vPosition_Face
+    glVertexAttribPointer(0, 4, GL_UNSIGNED_BYTE, GL_FALSE, sizeof(BlockVertex), offsetptr(BlockVertex, position));
+    // vTex_Animation_BlendMode
+    glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_FALSE, sizeof(BlockVertex), offsetptr(BlockVertex, tex));
+    // vTexturePos
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_FALSE, sizeof(BlockVertex), offsetptr(BlockVertex, texturePosition));
+    // vNormTexturePos
+    glVertexAttribPointer(3, 4, GL_UNSIGNED_BYTE, GL_FALSE, sizeof(BlockVertex), offsetptr(BlockVertex, normTexturePosition));
+    // vDispTexturePos
+    glVertexAttribPointer(4, 4, GL_UNSIGNED_BYTE, GL_FALSE, sizeof(BlockVertex), offsetptr(BlockVertex, dispTexturePosition));
+    // vTexDims
+    glVertexAttribPointer(5, 4, GL_UNSIGNED_BYTE, GL_FALSE, sizeof(BlockVertex), offsetptr(BlockVertex, textureDims));
+    // vColor
+    glVertexAttribPointer(6, 3, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(BlockVertex), offsetptr(BlockVertex, color));
+    // vOverlayColor
+    glVertexAttribPointer(7, 3, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(BlockVertex), offsetptr(BlockVertex, overlayColor));
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void ChunkMeshBufferPool::applyMove(const MeshBufferMove& move) {
+    VGVertexBuffer vbo = m_pages[move.page].vbo;
+    glBindBuffer(GL_COPY_READ_BUFFER, vbo);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, vbo);
+    // Overlapping copies within one buffer are illegal, so copy in
+    // steps of the move distance. Each step only overwrites data
+    // that has already been copied.
+    ui32 step = move.srcOffset - move.dstOffset;
+    for (ui32 copied = 0; copied < move.size; copied += step) {
+        ui32 size = vmath::min(step, move.size - copied);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                            (move.srcOffset + copied) * sizeof(VoxelQuad),
+                            (move.dstOffset + copied) * sizeof(VoxelQuad),
+                            size * sizeof(VoxelQuad));
+    }
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
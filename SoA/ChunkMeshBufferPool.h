@@ -0,0 +1,62 @@
+///
+/// ChunkMeshBufferPool.h
+/// Seed of Andromeda
+///
+/// Copyright 2014 Regrowth Studios
+/// All Rights Reserved
+///
+/// Summary:
+/// Owns the shared vertex buffers that all managed chunk meshes
+/// draw their opaque and cutout quads from.
+///
+
+#pragma once
+
+#ifndef ChunkMeshBufferPool_h__
+#define ChunkMeshBufferPool_h__
+
+#include <Vorb/graphics/gtypes.h>
+
+#include "ChunkMeshBufferAllocator.h"
+
+struct VoxelQuad;
+
+// Must fit the largest possible mesh, 32^3 / 2 voxels with 6 faces each.
+#define CHUNK_MESH_BUFFER_PAGE_QUADS 131072
+// Fragmented pages with this much free space get compacted
+#define CHUNK_MESH_BUFFER_COMPACT_THRESHOLD 0.5f
+
+/// One GL buffer and VAO per allocator page. All calls must be made on
+/// the render thread.
+class ChunkMeshBufferPool {
+public:
+    void init();
+    void dispose();
+
+    /// Allocates space for the quads and uploads them. Frees the allocation if quads is empty.
+    /// @return true if the quads were uploaded
+    bool upload(MeshBufferAllocation& allocation, const std::vector<VoxelQuad>& quads);
+    void free(MeshBufferAllocation& allocation);
+
+    /// Compacts at most one fragmented page, copying its data on the GPU
+    void update();
+
+    VGVertexArray getPageVao(ui32 page) const { return m_pages[page].vao; }
+    ui32 getNumPages() const { return (ui32)m_pages.size(); }
+    const ChunkMeshBufferAllocator& getAllocator() const { return m_allocator; }
+private:
+    struct BufferPage {
+        VGVertexBuffer vbo = 0;
+        VGVertexArray vao = 0;
+    };
+
+    void createPage(BufferPage& page);
+    void applyMove(const MeshBufferMove& move);
+
+    ChunkMeshBufferAllocator m_allocator;
+    std::vector<BufferPage> m_pages;
+    std::vector<MeshBufferMove> m_moves; ///< Scratch for compaction
+    ui32 m_nextCompactPage = 0;
+};
+
+#endif // ChunkMeshBufferPool_h__
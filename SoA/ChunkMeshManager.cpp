@@ -1,23 +1,39 @@
 #include "stdafx.h"
 #include "ChunkMeshManager.h"
 
+#include "Camera.h"
 #include "ChunkMesh.h"
 #include "ChunkMeshTask.h"
 #include "ChunkMesher.h"
 #include "ChunkRenderer.h"
 #include "SpaceSystemComponents.h"
+#include "VoxelSpaceConversions.h"
 #include "soaUtils.h"
 
 #define MAX_UPDATES_PER_FRAME 300
+// Beyond this, recycled mesh data is freed instead of pooled
+#define MAX_CACHED_MESH_DATA 512
+// Fraction of an LOD distance a mesh can stray past it before switching
+#define LOD_HYSTERESIS 0.1
+
+// Distance in voxels at which meshes switch to each coarser LOD
+const f64 LOD_DISTANCES[CHUNK_LOD_MAX] = { 128.0, 256.0, 384.0 };
 
 ChunkMeshManager::ChunkMeshManager(vcore::ThreadPool<WorkerData>* threadPool, BlockPack* blockPack) {
     m_threadPool = threadPool;
     m_blockPack = blockPack;
+    m_bufferPool.init();
+    m_meshDataAllocs = 0;
+    m_meshDataReuses = 0;
+    m_meshTaskAllocs = 0;
+    m_meshTaskReuses = 0;
     SpaceSystemAssemblages::onAddSphericalVoxelComponent += makeDelegate(*this, &ChunkMeshManager::onAddSphericalVoxelComponent);
     SpaceSystemAssemblages::onRemoveSphericalVoxelComponent += makeDelegate(*this, &ChunkMeshManager::onRemoveSphericalVoxelComponent);
 }
 
 void ChunkMeshManager::update(const f64v3& cameraPosition, bool shouldSort) {
+    m_cameraPosition = cameraPosition;
+
     ChunkMeshUpdateMessage updateBuffer[MAX_UPDATES_PER_FRAME];
     size_t numUpdates;
     if (numUpdates = m_messages.try_dequeue_bulk(updateBuffer, MAX_UPDATES_PER_FRAME)) {
@@ -30,12 +46,27 @@ void ChunkMeshManager::update(const f64v3& cameraPosition, bool shouldSort) {
     {
         std::lock_guard<std::mutex> l(m_lckPendingMesh);
         for (auto it = m_pendingMesh.begin(); it != m_pendingMesh.end();) {
-            ChunkMeshTask* task = createMeshTask(it->second);
+            ChunkMesh* mesh;
+            {
+                std::lock_guard<std::mutex> l(m_lckActiveChunks);
+                auto mit = m_activeChunks.find(it->first);
+                mesh = (mit == m_activeChunks.end()) ? nullptr : mit->second;
+            }
+            if (!mesh) {
+                // Mesh was released while pending
+                it->second.release();
+                m_pendingMesh.erase(it++);
+                continue;
+            }
+
+            static const f64v3 CHUNK_DIMS(CHUNK_WIDTH);
+            f64v3 closestPoint = getClosestPointOnAABB(m_cameraPosition, mesh->position, CHUNK_DIMS);
+            ui32 lod = getDesiredLod(mesh, selfDot(closestPoint - m_cameraPosition));
+
+            ChunkMeshTask* task = createMeshTask(it->second, lod);
             if (task) {
-                {
-                    std::lock_guard<std::mutex> l(m_lckActiveChunks);
-                    m_activeChunks[it->first]->updateVersion = it->second->updateVersion;
-                }
+                mesh->updateVersion = it->second->updateVersion;
+                mesh->lod = (ui8)lod;
                 m_threadPool->addTask(task);
                 it->second.release();
                 m_pendingMesh.erase(it++);
@@ -45,6 +76,9 @@ void ChunkMeshManager::update(const f64v3& cameraPosition, bool shouldSort) {
         }
     }
 
+    // Defragment the shared mesh buffers
+    m_bufferPool.update();
+
     // TODO(Ben): This is redundant with the chunk manager! Find a way to share! (Pointer?)
     updateMeshDistances(cameraPosition);
     if (shouldSort) {
@@ -52,10 +86,132 @@ void ChunkMeshManager::update(const f64v3& cameraPosition, bool shouldSort) {
     }
 }
 
+void ChunkMeshManager::setRenderFace(WorldCubeFace face, i32 faceChunkRadius) {
+    if (face == m_renderFace && faceChunkRadius == m_faceChunkRadius) return;
+    m_renderFace = face;
+    m_faceChunkRadius = faceChunkRadius;
+
+    // Every mesh moves into the new face's space
+    std::lock_guard<std::mutex> l(m_lckActiveChunks);
+    for (auto& it : m_activeChunks) placeMesh(it.second);
+}
+
 void ChunkMeshManager::destroy() {
+    // Messages that were never applied own their mesh data
+    ChunkMeshUpdateMessage message;
+    while (m_messages.try_dequeue(message)) delete message.meshData;
+
     std::vector <ChunkMesh*>().swap(m_activeChunkMeshes);
-    moodycamel::ConcurrentQueue<ChunkMeshUpdateMessage>().swap(m_messages);
-    std::unordered_map<ChunkID, ChunkMesh*>().swap(m_activeChunks);
+    std::unordered_map<ui64, ChunkMesh*>().swap(m_activeChunks);
+    m_bufferPool.dispose();
+
+    // Free pooled objects
+    ChunkMeshData* meshData;
+    while (m_freeMeshData.try_dequeue(meshData)) delete meshData;
+    ChunkMeshTask* task;
+    while (m_freeMeshTasks.try_dequeue(task)) delete task;
+}
+
+ChunkMeshData* ChunkMeshManager::acquireMeshData() {
+    ChunkMeshData* meshData;
+    if (m_freeMeshData.try_dequeue(meshData)) {
+        m_meshDataReuses++;
+        return meshData;
+    }
+    m_meshDataAllocs++;
+    return new ChunkMeshData(MeshTaskType::DEFAULT);
+}
+
+void ChunkMeshManager::recycleMeshData(ChunkMeshData* meshData) {
+    if (m_freeMeshData.size_approx() >= MAX_CACHED_MESH_DATA) {
+        delete meshData;
+        return;
+    }
+    m_freeMeshData.enqueue(meshData);
+}
+
+void ChunkMeshManager::recycleMeshTask(ChunkMeshTask* task) {
+    m_freeMeshTasks.enqueue(task);
+}
+
+ChunkMeshAllocStats ChunkMeshManager::getAllocStats() const {
+    ChunkMeshAllocStats stats;
+    stats.meshDataAllocs = m_meshDataAllocs;
+    stats.meshDataReuses = m_meshDataReuses;
+    stats.meshTaskAllocs = m_meshTaskAllocs;
+    stats.meshTaskReuses = m_meshTaskReuses;
+    return stats;
+}
+
+void ChunkMeshManager::updateOcclusion(const f64v3& cameraPosition, const Camera* camera) {
+    static const f64v3 boxDims_2(CHUNK_WIDTH / 2);
+    static const i32v3 FACE_OFFSETS[6] = {
+        i32v3(-1, 0, 0), i32v3(1, 0, 0),
+        i32v3(0, -1, 0), i32v3(0, 1, 0),
+        i32v3(0, 0, -1), i32v3(0, 0, 1)
+    };
+
+    std::lock_guard<std::mutex> l(m_lckActiveChunks);
+    m_occlusionFrame++;
+
+    ChunkID cameraChunk(VoxelSpaceConversions::voxelToChunk(cameraPosition));
+    auto it = m_activeChunks.find(getMeshKey(cameraChunk, m_renderFace));
+    if (it == m_activeChunks.end()) {
+        // Camera isn't in a meshed chunk, so only frustum culling applies
+        for (auto& it2 : m_activeChunks) {
+            ChunkMesh* mesh = it2.second;
+            if (camera->sphereInFrustum(f32v3(mesh->position + boxDims_2 - cameraPosition), CHUNK_DIAGONAL_LENGTH)) {
+                mesh->occlusionFrame = m_occlusionFrame;
+            }
+        }
+        return;
+    }
+
+    m_occlusionQueue.clear();
+    it->second->occlusionFrame = m_occlusionFrame;
+    OcclusionNode start;
+    start.id = cameraChunk;
+    start.mesh = it->second;
+    start.entryFace = CHUNK_FACE_NONE;
+    start.directions = 0;
+    m_occlusionQueue.push_back(start);
+
+    // Breadth first so the directions bitmask stays monotonic
+    for (size_t i = 0; i < m_occlusionQueue.size(); i++) {
+        OcclusionNode node = m_occlusionQueue[i];
+        ui16 connectivity = node.mesh->renderData.faceConnectivity;
+        for (int face = 0; face < 6; face++) {
+            // Never travel back towards the camera
+            if (node.directions & (1 << (face ^ 1))) continue;
+            // Must be able to see through the chunk from where we came in
+            if (node.entryFace != CHUNK_FACE_NONE && !(connectivity & getFacePairBit(node.entryFace, face))) continue;
+
+            ChunkID nid(node.id.x + FACE_OFFSETS[face].x, node.id.y + FACE_OFFSETS[face].y, node.id.z + FACE_OFFSETS[face].z);
+            auto nit = m_activeChunks.find(getMeshKey(nid, m_renderFace));
+            if (nit == m_activeChunks.end()) continue;
+            ChunkMesh* mesh = nit->second;
+            if (mesh->occlusionFrame == m_occlusionFrame) continue;
+            if (!camera->sphereInFrustum(f32v3(mesh->position + boxDims_2 - cameraPosition), CHUNK_DIAGONAL_LENGTH)) continue;
+
+            mesh->occlusionFrame = m_occlusionFrame;
+            OcclusionNode next;
+            next.id = nid;
+            next.mesh = mesh;
+            next.entryFace = (ui8)(face ^ 1);
+            next.directions = node.directions | (1 << face);
+            m_occlusionQueue.push_back(next);
+        }
+    }
+
+    // The flood stays on the render face, so meshes past its edges are only frustum culled
+    for (auto& it2 : m_activeChunks) {
+        ChunkMesh* mesh = it2.second;
+        if (mesh->occlusionFrame == m_occlusionFrame) continue;
+        if (mesh->chunk->getChunkPosition().face == m_renderFace) continue;
+        if (camera->sphereInFrustum(f32v3(mesh->position + boxDims_2 - cameraPosition), CHUNK_DIAGONAL_LENGTH)) {
+            mesh->occlusionFrame = m_occlusionFrame;
+        }
+    }
 }
 
 ChunkMesh* ChunkMeshManager::createMesh(ChunkHandle& h) {
@@ -65,25 +221,60 @@ ChunkMesh* ChunkMeshManager::createMesh(ChunkHandle& h) {
         mesh = m_meshRecycler.create();
     }
     mesh->id = h.getID();
-
-    // Set the position
-    mesh->position = h->m_voxelPosition;
+    mesh->chunk = h.acquire();
+    mesh->lod = 0;
+    placeMesh(mesh);
 
     // Zero buffers
     memset(mesh->vbos, 0, sizeof(mesh->vbos));
     memset(mesh->vaos, 0, sizeof(mesh->vaos));
     mesh->transIndexID = 0;
+    mesh->renderData = ChunkMeshRenderData();
+    mesh->opaqueAlloc = MeshBufferAllocation();
+    mesh->cutoutAlloc = MeshBufferAllocation();
     mesh->activeMeshesIndex = ACTIVE_MESH_INDEX_NONE;
 
     { // Register chunk as active and give it a mesh
         std::lock_guard<std::mutex> l(m_lckActiveChunks);
-        m_activeChunks[h.getID()] = mesh;
+        m_activeChunks[getMeshKey(h)] = mesh;
     }
 
     return mesh;
 }
 
-ChunkMeshTask* ChunkMeshManager::createMeshTask(ChunkHandle& chunk) {
+void ChunkMeshManager::placeMesh(ChunkMesh* mesh) const {
+    const ChunkPosition3D& chunkPos = mesh->chunk->getChunkPosition();
+    i32v3 pos;
+    if (m_faceChunkRadius == 0 || chunkPos.face == m_renderFace ||
+        !VoxelSpaceConversions::unwrapChunkPosition(chunkPos, m_renderFace, m_faceChunkRadius, pos)) {
+        mesh->position = mesh->chunk->getVoxelPosition().pos;
+        mesh->origin = mesh->position;
+        mesh->axisX = i32v3(1, 0, 0);
+        mesh->axisZ = i32v3(0, 0, 1);
+        return;
+    }
+
+    // The fold is a turn about y, so stepping along the chunk's own x and z
+    // gives the directions they point in on the render face
+    ChunkPosition3D step = chunkPos;
+    i32v3 stepPos;
+    step.pos.x++;
+    VoxelSpaceConversions::unwrapChunkPosition(step, m_renderFace, m_faceChunkRadius, stepPos);
+    mesh->axisX = stepPos - pos;
+    step.pos = chunkPos.pos;
+    step.pos.z++;
+    VoxelSpaceConversions::unwrapChunkPosition(step, m_renderFace, m_faceChunkRadius, stepPos);
+    mesh->axisZ = stepPos - pos;
+
+    // Axes that point backwards start from the far side of the chunk
+    mesh->position = f64v3(pos * CHUNK_WIDTH);
+    mesh->origin = mesh->position;
+    for (int i = 0; i < 3; i += 2) {
+        if (mesh->axisX[i] < 0 || mesh->axisZ[i] < 0) mesh->origin[i] += CHUNK_WIDTH;
+    }
+}
+
+ChunkMeshTask* ChunkMeshManager::createMeshTask(ChunkHandle& chunk, ui32 lod) {
     ChunkHandle& left = chunk->left;
     ChunkHandle& right = chunk->right;
     ChunkHandle& bottom = chunk->bottom;
@@ -100,9 +291,15 @@ ChunkMeshTask* ChunkMeshManager::createMeshTask(ChunkHandle& chunk) {
         back->genLevel != GEN_DONE || front->genLevel != GEN_DONE ||
         bottom->genLevel != GEN_DONE || top->genLevel != GEN_DONE) return nullptr;
 
-    // TODO(Ben): Recycler
-    ChunkMeshTask* meshTask = new ChunkMeshTask;
+    ChunkMeshTask* meshTask;
+    if (m_freeMeshTasks.try_dequeue(meshTask)) {
+        m_meshTaskReuses++;
+    } else {
+        m_meshTaskAllocs++;
+        meshTask = new ChunkMeshTask;
+    }
     meshTask->init(chunk, MeshTaskType::DEFAULT, m_blockPack, this);
+    meshTask->lod = lod;
 
     // Set dependencies
     meshTask->neighborHandles[NEIGHBOR_HANDLE_LEFT] = left.acquire();
@@ -114,11 +311,27 @@ ChunkMeshTask* ChunkMeshManager::createMeshTask(ChunkHandle& chunk) {
     return meshTask;
 }
 
+ui32 ChunkMeshManager::getDesiredLod(const ChunkMesh* mesh, f64 distance2) const {
+    // Range of LODs that are acceptable at this distance
+    ui32 finest = 0;
+    ui32 coarsest = 0;
+    for (ui32 i = 0; i < CHUNK_LOD_MAX; i++) {
+        f64 nearDist = LOD_DISTANCES[i] * (1.0 - LOD_HYSTERESIS);
+        f64 farDist = LOD_DISTANCES[i] * (1.0 + LOD_HYSTERESIS);
+        if (distance2 > farDist * farDist) finest = i + 1;
+        if (distance2 > nearDist * nearDist) coarsest = i + 1;
+    }
+    return vmath::clamp((ui32)mesh->lod, finest, coarsest);
+}
+
 void ChunkMeshManager::disposeMesh(ChunkMesh* mesh) {
     // De-allocate buffer objects
     glDeleteBuffers(4, mesh->vbos);
     glDeleteVertexArrays(4, mesh->vaos);
     if (mesh->transIndexID) glDeleteBuffers(1, &mesh->transIndexID);
+    m_bufferPool.free(mesh->opaqueAlloc);
+    m_bufferPool.free(mesh->cutoutAlloc);
+    mesh->chunk.release();
 
     { // Remove from mesh list
         std::lock_guard<std::mutex> l(lckActiveChunkMeshes);
@@ -140,15 +353,15 @@ void ChunkMeshManager::updateMesh(ChunkMeshUpdateMessage& message) {
     ChunkMesh *mesh;
     { // Get the mesh object
         std::lock_guard<std::mutex> l(m_lckActiveChunks);
-        auto& it = m_activeChunks.find(message.chunkID);
+        auto& it = m_activeChunks.find(message.meshKey);
         if (it == m_activeChunks.end()) {
-            delete message.meshData;
+            recycleMeshData(message.meshData);
             return; /// The mesh was already released, so ignore!
         }
         mesh = it->second;
     }
     
-    if (ChunkMesher::uploadMeshData(*mesh, message.meshData)) {
+    if (ChunkMesher::uploadMeshData(*mesh, message.meshData, &m_bufferPool)) {
         // Add to active list if its not there
         std::lock_guard<std::mutex> l(lckActiveChunkMeshes);
         if (mesh->activeMeshesIndex == ACTIVE_MESH_INDEX_NONE) {
@@ -167,19 +380,37 @@ void ChunkMeshManager::updateMesh(ChunkMeshUpdateMessage& message) {
         }
     }
 
-    // TODO(Ben): come on...
-    delete message.meshData;
+    recycleMeshData(message.meshData);
 }
 
 void ChunkMeshManager::updateMeshDistances(const f64v3& cameraPosition) {
     static const f64v3 CHUNK_DIMS(CHUNK_WIDTH);
     // TODO(Ben): Spherical instead?
-    std::lock_guard<std::mutex> l(lckActiveChunkMeshes);
-    for (auto& mesh : m_activeChunkMeshes) { //update distances for all chunk meshes
-        //calculate distance
-        f64v3 closestPoint = getClosestPointOnAABB(cameraPosition, mesh->position, CHUNK_DIMS);
-        // Omit sqrt for faster calculation
-        mesh->distance2 = selfDot(closestPoint - cameraPosition);
+    {
+        std::lock_guard<std::mutex> l(lckActiveChunkMeshes);
+        for (auto& mesh : m_activeChunkMeshes) { //update distances for all chunk meshes
+            //calculate distance
+            f64v3 closestPoint = getClosestPointOnAABB(cameraPosition, mesh->position, CHUNK_DIMS);
+            // Omit sqrt for faster calculation
+            mesh->distance2 = selfDot(closestPoint - cameraPosition);
+            if (getDesiredLod(mesh, mesh->distance2) != mesh->lod) {
+                m_lodChanges.push_back(mesh->chunk.acquire());
+            }
+        }
+    }
+
+    // Remesh at the new LOD. Queued after unlocking so we never hold both locks.
+    if (m_lodChanges.size()) {
+        std::lock_guard<std::mutex> l(m_lckPendingMesh);
+        for (auto& h : m_lodChanges) {
+            ui64 key = getMeshKey(h);
+            if (m_pendingMesh.find(key) == m_pendingMesh.end()) {
+                m_pendingMesh.emplace(key, std::move(h));
+            } else {
+                h.release();
+            }
+        }
+        m_lodChanges.clear();
     }
 }
 
@@ -209,7 +440,7 @@ void ChunkMeshManager::onGenFinish(Sender s, ChunkHandle& chunk, ChunkGenLevel g
     // Check if can be meshed.
     if (chunk->genLevel == GEN_DONE && chunk->left.isAquired() && chunk->numBlocks) {
         std::lock_guard<std::mutex> l(m_lckPendingMesh);
-        m_pendingMesh.emplace(chunk.getID(), chunk.acquire());
+        m_pendingMesh.emplace(getMeshKey(chunk), chunk.acquire());
     }
 }
 
@@ -218,7 +449,7 @@ void ChunkMeshManager::onNeighborsAcquire(Sender s, ChunkHandle& chunk) {
     // Check if can be meshed.
     if (chunk->genLevel == GEN_DONE && chunk->numBlocks) {
         std::lock_guard<std::mutex> l(m_lckPendingMesh);
-        m_pendingMesh.emplace(chunk.getID(), chunk.acquire());
+        m_pendingMesh.emplace(getMeshKey(chunk), chunk.acquire());
     }
 }
 
@@ -227,7 +458,7 @@ void ChunkMeshManager::onNeighborsRelease(Sender s, ChunkHandle& chunk) {
     ChunkMesh* mesh;
     {
         std::lock_guard<std::mutex> l(m_lckActiveChunks);
-        auto& it = m_activeChunks.find(chunk.getID());
+        auto& it = m_activeChunks.find(getMeshKey(chunk));
         if (it == m_activeChunks.end()) {
             return;
         } else {
@@ -237,7 +468,7 @@ void ChunkMeshManager::onNeighborsRelease(Sender s, ChunkHandle& chunk) {
     }
     {
         std::lock_guard<std::mutex> l(m_lckPendingMesh);
-        auto& it = m_pendingMesh.find(chunk.getID());
+        auto& it = m_pendingMesh.find(getMeshKey(chunk));
         if (it != m_pendingMesh.end()) {
             it->second.release();
             m_pendingMesh.erase(it);
@@ -252,6 +483,6 @@ void ChunkMeshManager::onDataChange(Sender s, ChunkHandle& chunk) {
     // TODO(Ben): Race condition with neighbor removal here.
     if (chunk->left.isAquired()) {
         std::lock_guard<std::mutex> l(m_lckPendingMesh);
-        m_pendingMesh.emplace(chunk.getID(), chunk.acquire());
+        m_pendingMesh.emplace(getMeshKey(chunk), chunk.acquire());
     }
 }
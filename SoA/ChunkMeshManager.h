@@ -19,39 +19,85 @@
 #include "concurrentqueue.h"
 #include "Chunk.h"
 #include "ChunkMesh.h"
+#include "ChunkMeshBufferPool.h"
 #include "SpaceSystemAssemblages.h"
+#include <atomic>
 #include <mutex>
 
+class Camera;
+
 struct ChunkMeshUpdateMessage {
-    ChunkID chunkID;
+    ui64 meshKey; ///< See ChunkMeshManager::getMeshKey
     ChunkMeshData* meshData = nullptr;
 };
 
+/// Counters for the mesh data and task pools, shown on the dev HUD
+struct ChunkMeshAllocStats {
+    ui32 meshDataAllocs; ///< Times a ChunkMeshData had to be newed
+    ui32 meshDataReuses; ///< Times a ChunkMeshData came from the pool
+    ui32 meshTaskAllocs;
+    ui32 meshTaskReuses;
+};
+
 class ChunkMeshManager {
 public:
     ChunkMeshManager(vcore::ThreadPool<WorkerData>* threadPool, BlockPack* blockPack);
     /// Updates the meshManager, uploading any needed meshes
     void update(const f64v3& cameraPosition, bool shouldSort);
+    /// Sets the cube face whose voxel space meshes are placed and drawn in.
+    /// Meshes of chunks on neighboring faces are turned to line up with it.
+    /// @param faceChunkRadius: Half the width of a face in chunks
+    void setRenderFace(WorldCubeFace face, i32 faceChunkRadius);
+    /// Meshes of every face grid share the manager, so keys include the face
+    static ui64 getMeshKey(const ChunkID& id, WorldCubeFace face) { return id.id ^ ((ui64)face << 61); }
+    static ui64 getMeshKey(ChunkHandle& chunk) { return getMeshKey(chunk.getID(), chunk->getChunkPosition().face); }
     /// Adds a mesh for updating
     void sendMessage(const ChunkMeshUpdateMessage& message) { m_messages.enqueue(message); }
-    /// Destroys all meshes
+    /// Destroys all meshes and frees the pools. Every mesh task must have
+    /// finished first, since tasks recycle themselves into the pools.
     void destroy();
 
+    /// Gets pooled mesh data for a worker to fill. Thread safe.
+    ChunkMeshData* acquireMeshData();
+    /// Returns mesh data to the pool, keeping its capacity. Thread safe.
+    void recycleMeshData(ChunkMeshData* meshData);
+    /// Called by a task once it has finished executing. Thread safe.
+    void recycleMeshTask(ChunkMeshTask* task);
+
+    ChunkMeshAllocStats getAllocStats() const;
+
+    /// Flood fills outwards from the camera chunk through the face connectivity
+    /// of each mesh. Meshes that are reached and in the frustum get their
+    /// occlusionFrame set to the new occlusion frame. Meshes on other faces,
+    /// or all of them if the camera chunk has no mesh, are only frustum
+    /// culled. Render thread only.
+    void updateOcclusion(const f64v3& cameraPosition, const Camera* camera);
+    ui32 getOcclusionFrame() const { return m_occlusionFrame; }
+
     // Be sure to lock lckActiveChunkMeshes
     const std::vector <ChunkMesh*>& getChunkMeshes() { return m_activeChunkMeshes; }
+    // Opaque and cutout geometry of all active meshes. Render thread only.
+    const ChunkMeshBufferPool& getBufferPool() const { return m_bufferPool; }
     std::mutex lckActiveChunkMeshes;
 private:
     VORB_NON_COPYABLE(ChunkMeshManager);
 
     ChunkMesh* createMesh(ChunkHandle& h);
+    /// Sets the mesh's position and axes in the render face's space. Hold m_lckActiveChunks.
+    void placeMesh(ChunkMesh* mesh) const;
 
-    ChunkMeshTask* createMeshTask(ChunkHandle& chunk);
+    ChunkMeshTask* createMeshTask(ChunkHandle& chunk, ui32 lod);
+
+    /// Picks the LOD for a mesh at distance2, sticking with its current
+    /// LOD near the thresholds so meshes don't flicker between levels
+    ui32 getDesiredLod(const ChunkMesh* mesh, f64 distance2) const;
 
     void disposeMesh(ChunkMesh* mesh);
 
     /// Uploads a mesh and adds to list if needed
     void updateMesh(ChunkMeshUpdateMessage& message);
 
+    /// Also queues remeshes for meshes whose LOD should change
     void updateMeshDistances(const f64v3& cameraPosition);
 
     /************************************************************************/
@@ -69,17 +115,39 @@ class ChunkMeshManager {
     /************************************************************************/
     std::vector<ChunkMesh*> m_activeChunkMeshes; ///< Meshes that should be drawn
     moodycamel::ConcurrentQueue<ChunkMeshUpdateMessage> m_messages; ///< Lock-free queue of messages
+    moodycamel::ConcurrentQueue<ChunkMeshData*> m_freeMeshData; ///< Recycled mesh data
+    moodycamel::ConcurrentQueue<ChunkMeshTask*> m_freeMeshTasks; ///< Recycled mesh tasks
+    std::atomic<ui32> m_meshDataAllocs;
+    std::atomic<ui32> m_meshDataReuses;
+    std::atomic<ui32> m_meshTaskAllocs;
+    std::atomic<ui32> m_meshTaskReuses;
    
+    ChunkMeshBufferPool m_bufferPool;
+
+    struct OcclusionNode {
+        ChunkID id;
+        const ChunkMesh* mesh;
+        ui8 entryFace; ///< Face we came in through, or CHUNK_FACE_NONE
+        ui8 directions; ///< Bitmask of directions traveled so far
+    };
+    std::vector<OcclusionNode> m_occlusionQueue;
+    ui32 m_occlusionFrame = 0;
+
+    f64v3 m_cameraPosition = f64v3(0.0);
+    WorldCubeFace m_renderFace = FACE_TOP;
+    i32 m_faceChunkRadius = 0;
+    std::vector<ChunkHandle> m_lodChanges; ///< Scratch for updateMeshDistances
+
     BlockPack* m_blockPack = nullptr;
     vcore::ThreadPool<WorkerData>* m_threadPool = nullptr;
 
     std::mutex m_lckPendingMesh;
-    std::map<ChunkID, ChunkHandle> m_pendingMesh;
+    std::map<ui64, ChunkHandle> m_pendingMesh; ///< Keyed by getMeshKey
 
     std::mutex m_lckMeshRecycler;
     PtrRecycler<ChunkMesh> m_meshRecycler;
     std::mutex m_lckActiveChunks;
-    std::unordered_map<ChunkID, ChunkMesh*> m_activeChunks; ///< Stores chunk IDs that have meshes
+    std::unordered_map<ui64, ChunkMesh*> m_activeChunks; ///< Chunks that have meshes, keyed by getMeshKey
 };
 
 #endif // ChunkMeshManager_h__
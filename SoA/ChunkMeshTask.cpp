@@ -18,9 +18,8 @@ void ChunkMeshTask::execute(WorkerData* workerData) {
         workerData->voxelLightEngine = new VoxelLightEngine();
     }
     
-    // TODO(Ben): Lighting
-    // updateLight(workerData->voxelLightEngine);
-    
+    updateLight(workerData->voxelLightEngine);
+
     // Lazily allocate chunkMesher // TODO(Ben): Seems wasteful.
     if (workerData->chunkMesher == nullptr) {
         workerData->chunkMesher = new ChunkMesher;
@@ -28,32 +27,31 @@ void ChunkMeshTask::execute(WorkerData* workerData) {
     }
     // Prepare message
     ChunkMeshUpdateMessage msg;
-    msg.chunkID = chunk.getID();
+    msg.meshKey = ChunkMeshManager::getMeshKey(chunk);
 
     // Pre-processing
     workerData->chunkMesher->prepareDataAsync(chunk, neighborHandles);
 
     // Create the actual mesh
-    msg.meshData = workerData->chunkMesher->createChunkMeshData(type);
+    msg.meshData = workerData->chunkMesher->createChunkMeshData(type, meshManager->acquireMeshData(), lod);
 
     // Send it for update
     meshManager->sendMessage(msg);
 }
 
+void ChunkMeshTask::cleanup() {
+    meshManager->recycleMeshTask(this);
+}
+
 void ChunkMeshTask::init(ChunkHandle& ch, MeshTaskType cType, const BlockPack* blockPack, ChunkMeshManager* meshManager) {
     type = cType;
+    lod = 0;
     chunk = ch.acquire();
     this->blockPack = blockPack;
     this->meshManager = meshManager;
 }
 
-// TODO(Ben): uhh
 void ChunkMeshTask::updateLight(VoxelLightEngine* voxelLightEngine) {
-    /* if (chunk->sunRemovalList.size()) {
-         voxelLightEngine->calculateSunlightRemoval(chunk);
-         }
-         if (chunk->sunExtendList.size()) {
-         voxelLightEngine->calculateSunlightExtend(chunk);
-         }
-         voxelLightEngine->calculateLight(chunk);*/
+    // Must happen before prepareDataAsync releases the neighbors
+    voxelLightEngine->calculateLight(chunk, neighborHandles, blockPack);
 }
@@ -51,10 +51,14 @@ class ChunkMeshTask : public vcore::IThreadPoolTask<WorkerData> {
     // Executes the task
     void execute(WorkerData* workerData) override;
 
+    // Returns the task to the mesh manager's pool
+    void cleanup() override;
+
     // Initializes the task
     void init(ChunkHandle& ch, MeshTaskType cType, const BlockPack* blockPack, ChunkMeshManager* meshManager);
 
     MeshTaskType type; 
+    ui32 lod = 0; ///< 0 is full detail, each level halves the resolution
     ChunkHandle chunk;
     ChunkMeshManager* meshManager = nullptr;
     const BlockPack* blockPack = nullptr;
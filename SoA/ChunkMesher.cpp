@@ -12,6 +12,7 @@
 
 #include "BlockPack.h"
 #include "Chunk.h"
+#include "ChunkMeshBufferPool.h"
 #include "ChunkMeshTask.h"
 #include "ChunkRenderer.h"
 #include "Errors.h"
@@ -25,7 +26,8 @@
 
 const float LIGHT_MULT = 0.95f, LIGHT_OFFSET = -0.2f;
 
-const int MAXLIGHT = 31;
+// Brightness of voxels with no light, so caves aren't pitch black
+const f32 MIN_LIGHT = 0.1f;
 
 // Shorter aliases
 #define PADDED_WIDTH PADDED_CHUNK_WIDTH
@@ -60,8 +62,38 @@ const int FACE_AXIS[6][2] = { { 2, 1 }, { 2, 1 }, { 0, 2 }, { 0, 2 }, { 0, 1 },
 
 const int FACE_AXIS_SIGN[6][2] = { { 1, 1 }, { -1, 1 }, { 1, 1 }, { -1, 1 }, { -1, 1 }, { 1, 1 } };
 
+// Offsets to the voxel each face looks into, indexed by face
+const int FACE_LIGHT_OFFSETS[6] = { -1, 1, -PADDED_LAYER, PADDED_LAYER, -PADDED_WIDTH, PADDED_WIDTH };
+
 PlanetHeightData ChunkMesher::defaultChunkHeightData[CHUNK_LAYER] = {};
 
+// Copies a voxel container into the interior of a padded buffer
+static void copyToPaddedBuffer(vvox::SmartVoxelContainer<ui16>& container, ui16* dest) {
+    int wc;
+    i32v3 pos;
+    if (container.getState() == vvox::VoxelStorageState::INTERVAL_TREE) {
+        auto& dataTree = container.getTree();
+        for (size_t i = 0; i < dataTree.size(); i++) {
+            for (size_t j = 0; j < dataTree[i].length; j++) {
+                int c = dataTree[i].getStart() + j;
+                getPosFromBlockIndex(c, pos);
+                wc = (pos.y + 1)*PADDED_LAYER + (pos.z + 1)*PADDED_WIDTH + (pos.x + 1);
+                dest[wc] = dataTree[i].data;
+            }
+        }
+    } else {
+        const ui16* src = container.getDataArray();
+        int c = 0;
+        for (int y = 0; y < CHUNK_WIDTH; y++) {
+            for (int z = 0; z < CHUNK_WIDTH; z++) {
+                wc = (y + 1)*PADDED_LAYER + (z + 1)*PADDED_WIDTH + 1;
+                memcpy(&dest[wc], &src[c], CHUNK_WIDTH * sizeof(ui16));
+                c += CHUNK_WIDTH;
+            }
+        }
+    }
+}
+
 void ChunkMesher::init(const BlockPack* blocks) {
     this->blocks = blocks;
 
@@ -112,6 +144,9 @@ void ChunkMesher::prepareData(const Chunk* chunk) {
 
     memset(blockData, 0, sizeof(blockData));
     memset(tertiaryData, 0, sizeof(tertiaryData));
+    // No light engine for synchronous meshes, so light everything
+    std::fill(sunlightData, sunlightData + PADDED_SIZE, MAX_LIGHT);
+    memset(lampData, 0, sizeof(lampData));
  
     if (chunk->blocks.getState() == vvox::VoxelStorageState::INTERVAL_TREE) {
 
@@ -250,7 +285,7 @@ void ChunkMesher::prepareData(const Chunk* chunk) {
 
 #define GET_EDGE_X(ch, sy, sz, dy, dz) \
     { \
-      std::lock_guard<std::mutex> l(ch->dataMutex); \
+      ChunkReadLock l(ch->dataMutex); \
       for (int x = 0; x < CHUNK_WIDTH; x++) { \
           srcIndex = (sy) * CHUNK_LAYER + (sz) * CHUNK_WIDTH + x; \
           destIndex = (dy) * PADDED_LAYER + (dz) * PADDED_WIDTH + (x + 1); \
@@ -262,7 +297,7 @@ void ChunkMesher::prepareData(const Chunk* chunk) {
 
 #define GET_EDGE_Y(ch, sx, sz, dx, dz) \
     { \
-      std::lock_guard<std::mutex> l(ch->dataMutex); \
+      ChunkReadLock l(ch->dataMutex); \
       for (int y = 0; y < CHUNK_WIDTH; y++) { \
         srcIndex = y * CHUNK_LAYER + (sz) * CHUNK_WIDTH + (sx); \
         destIndex = (y + 1) * PADDED_LAYER + (dz) * PADDED_WIDTH + (dx); \
@@ -274,7 +309,7 @@ void ChunkMesher::prepareData(const Chunk* chunk) {
 
 #define GET_EDGE_Z(ch, sx, sy, dx, dy) \
     { \
-      std::lock_guard<std::mutex> l(ch->dataMutex); \
+      ChunkReadLock l(ch->dataMutex); \
       for (int z = 0; z < CHUNK_WIDTH; z++) { \
         srcIndex = z * CHUNK_WIDTH + (sy) * CHUNK_LAYER + (sx); \
         destIndex = (z + 1) * PADDED_WIDTH + (dy) * PADDED_LAYER + (dx); \
@@ -288,7 +323,7 @@ void ChunkMesher::prepareData(const Chunk* chunk) {
     srcIndex = (sy) * CHUNK_LAYER + (sz) * CHUNK_WIDTH + (sx); \
     destIndex = (dy) * PADDED_LAYER + (dz) * PADDED_WIDTH + (dx); \
     { \
-      std::lock_guard<std::mutex> l(ch->dataMutex); \
+      ChunkReadLock l(ch->dataMutex); \
       blockData[destIndex] = ch->getBlockData(srcIndex); \
       tertiaryData[destIndex] = ch->getTertiaryData(srcIndex); \
     } \
@@ -315,7 +350,7 @@ void ChunkMesher::prepareDataAsync(ChunkHandle& chunk, ChunkHandle neighbors[NUM
     // TODO(Ben): Do this last so we can be queued for mesh longer?
     // TODO(Ben): Dude macro this or something.
     { // Main chunk
-        std::lock_guard<std::mutex> l(chunk->dataMutex);
+        ChunkReadLock l(chunk->dataMutex);
         if (chunk->blocks.getState() == vvox::VoxelStorageState::INTERVAL_TREE) {
 
             int s = 0;
@@ -376,12 +411,19 @@ void ChunkMesher::prepareDataAsync(ChunkHandle& chunk, ChunkHandle neighbors[NUM
                 }
             }
         }
+        if (chunk->isLit) {
+            copyToPaddedBuffer(chunk->sunlight, sunlightData);
+            copyToPaddedBuffer(chunk->lamp, lampData);
+        } else {
+            std::fill(sunlightData, sunlightData + PADDED_SIZE, MAX_LIGHT);
+            memset(lampData, 0, sizeof(lampData));
+        }
     }
     chunk.release();
 
     ChunkHandle& left = neighbors[NEIGHBOR_HANDLE_LEFT];
     { // Left
-        std::lock_guard<std::mutex> l(left->dataMutex);
+        ChunkReadLock l(left->dataMutex);
         for (y = 1; y < PADDED_WIDTH - 1; y++) {
             for (z = 1; z < PADDED_WIDTH - 1; z++) {
                 srcIndex = (z - 1)*CHUNK_WIDTH + (y - 1)*CHUNK_LAYER;
@@ -389,6 +431,7 @@ void ChunkMesher::prepareDataAsync(ChunkHandle& chunk, ChunkHandle neighbors[NUM
 
                 blockData[destIndex] = left->getBlockData(srcIndex + CHUNK_WIDTH - 1);
                 tertiaryData[destIndex] = left->getTertiaryData(srcIndex + CHUNK_WIDTH - 1);
+                copyNeighborLight(left, srcIndex + CHUNK_WIDTH - 1, destIndex);
             }
         }
     }
@@ -396,7 +439,7 @@ void ChunkMesher::prepareDataAsync(ChunkHandle& chunk, ChunkHandle neighbors[NUM
 
     ChunkHandle& right = neighbors[NEIGHBOR_HANDLE_RIGHT];
     { // Right
-        std::lock_guard<std::mutex> l(right->dataMutex);
+        ChunkReadLock l(right->dataMutex);
         for (y = 1; y < PADDED_WIDTH - 1; y++) {
             for (z = 1; z < PADDED_WIDTH - 1; z++) {
                 srcIndex = (z - 1)*CHUNK_WIDTH + (y - 1)*CHUNK_LAYER;
@@ -404,6 +447,7 @@ void ChunkMesher::prepareDataAsync(ChunkHandle& chunk, ChunkHandle neighbors[NUM
 
                 blockData[destIndex] = (right->getBlockData(srcIndex));
                 tertiaryData[destIndex] = right->getTertiaryData(srcIndex);
+                copyNeighborLight(right, srcIndex, destIndex);
             }
         }
     }
@@ -411,7 +455,7 @@ void ChunkMesher::prepareDataAsync(ChunkHandle& chunk, ChunkHandle neighbors[NUM
 
     ChunkHandle& bottom = neighbors[NEIGHBOR_HANDLE_BOT];
     { // Bottom
-        std::lock_guard<std::mutex> l(bottom->dataMutex);
+        ChunkReadLock l(bottom->dataMutex);
         for (z = 1; z < PADDED_WIDTH - 1; z++) {
             for (x = 1; x < PADDED_WIDTH - 1; x++) {
                 srcIndex = (z - 1)*CHUNK_WIDTH + x - 1 + CHUNK_SIZE - CHUNK_LAYER;
@@ -419,6 +463,7 @@ void ChunkMesher::prepareDataAsync(ChunkHandle& chunk, ChunkHandle neighbors[NUM
                 //data
                 blockData[destIndex] = (bottom->getBlockData(srcIndex)); //bottom
                 tertiaryData[destIndex] = bottom->getTertiaryData(srcIndex);
+                copyNeighborLight(bottom, srcIndex, destIndex);
             }
         }
     }
@@ -426,7 +471,7 @@ void ChunkMesher::prepareDataAsync(ChunkHandle& chunk, ChunkHandle neighbors[NUM
 
     ChunkHandle& top = neighbors[NEIGHBOR_HANDLE_TOP];
     { // Top
-        std::lock_guard<std::mutex> l(top->dataMutex);
+        ChunkReadLock l(top->dataMutex);
         for (z = 1; z < PADDED_WIDTH - 1; z++) {
             for (x = 1; x < PADDED_WIDTH - 1; x++) {
                 srcIndex = (z - 1)*CHUNK_WIDTH + x - 1;
@@ -434,6 +479,7 @@ void ChunkMesher::prepareDataAsync(ChunkHandle& chunk, ChunkHandle neighbors[NUM
 
                 blockData[destIndex] = (top->getBlockData(srcIndex)); //top
                 tertiaryData[destIndex] = top->getTertiaryData(srcIndex);
+                copyNeighborLight(top, srcIndex, destIndex);
             }
         }
     }
@@ -441,7 +487,7 @@ void ChunkMesher::prepareDataAsync(ChunkHandle& chunk, ChunkHandle neighbors[NUM
 
     ChunkHandle& back = neighbors[NEIGHBOR_HANDLE_BACK];
     { // Back
-        std::lock_guard<std::mutex> l(back->dataMutex);
+        ChunkReadLock l(back->dataMutex);
         for (y = 1; y < PADDED_WIDTH - 1; y++) {
             for (x = 1; x < PADDED_WIDTH - 1; x++) {
                 srcIndex = (x - 1) + (y - 1)*CHUNK_LAYER + CHUNK_LAYER - CHUNK_WIDTH;
@@ -449,6 +495,7 @@ void ChunkMesher::prepareDataAsync(ChunkHandle& chunk, ChunkHandle neighbors[NUM
 
                 blockData[destIndex] = back->getBlockData(srcIndex);
                 tertiaryData[destIndex] = back->getTertiaryData(srcIndex);
+                copyNeighborLight(back, srcIndex, destIndex);
             }
         }
     }
@@ -456,7 +503,7 @@ void ChunkMesher::prepareDataAsync(ChunkHandle& chunk, ChunkHandle neighbors[NUM
 
     ChunkHandle& front = neighbors[NEIGHBOR_HANDLE_FRONT];
     { // Front
-        std::lock_guard<std::mutex> l(front->dataMutex);
+        ChunkReadLock l(front->dataMutex);
         for (y = 1; y < PADDED_WIDTH - 1; y++) {
             for (x = 1; x < PADDED_WIDTH - 1; x++) {
                 srcIndex = (x - 1) + (y - 1)*CHUNK_LAYER;
@@ -464,6 +511,7 @@ void ChunkMesher::prepareDataAsync(ChunkHandle& chunk, ChunkHandle neighbors[NUM
 
                 blockData[destIndex] = front->getBlockData(srcIndex);
                 tertiaryData[destIndex] = front->getTertiaryData(srcIndex);
+                copyNeighborLight(front, srcIndex, destIndex);
             }
         }
     }
@@ -543,7 +591,7 @@ void ChunkMesher::prepareDataAsync(ChunkHandle& chunk, ChunkHandle neighbors[NUM
     }
 }
 
-CALLER_DELETE ChunkMeshData* ChunkMesher::createChunkMeshData(MeshTaskType type) {
+CALLER_DELETE ChunkMeshData* ChunkMesher::createChunkMeshData(MeshTaskType type, ChunkMeshData* meshData /*= nullptr*/, ui32 lod /*= 0*/) {
     m_numQuads = 0;
     m_highestY = 0;
     m_lowestY = 256;
@@ -558,13 +606,23 @@ CALLER_DELETE ChunkMeshData* ChunkMesher::createChunkMeshData(MeshTaskType type)
     for (int i = 0; i < 6; i++) {
         m_quads[i].clear();
     }
+    m_floraQuads.clear();
 
     // TODO(Ben): Here?
     _waterVboVerts.clear();
 
     // Stores the data for a chunk mesh
-    // TODO(Ben): new is bad mkay
-    m_chunkMeshData = new ChunkMeshData(MeshTaskType::DEFAULT);
+    if (meshData) {
+        m_chunkMeshData = meshData;
+        m_chunkMeshData->clear(MeshTaskType::DEFAULT);
+    } else {
+        m_chunkMeshData = new ChunkMeshData(MeshTaskType::DEFAULT);
+    }
+
+    ChunkMeshRenderData& renderData = m_chunkMeshData->chunkMeshRenderData;
+    // Use full resolution data so merged LOD cells can't hide openings
+    renderData.faceConnectivity = computeFaceConnectivity();
+    if (lod) downsampleData(vmath::min(lod, (ui32)CHUNK_LOD_MAX));
 
     // Loop through blocks
     for (by = 0; by < CHUNK_WIDTH; by++) {
@@ -597,8 +655,6 @@ CALLER_DELETE ChunkMeshData* ChunkMesher::createChunkMeshData(MeshTaskType type)
         }
     }
 
-    ChunkMeshRenderData& renderData = m_chunkMeshData->chunkMeshRenderData;
-
     // Get quad buffer to fill
     std::vector<VoxelQuad>& finalQuads = m_chunkMeshData->opaqueQuads;
 
@@ -677,7 +733,7 @@ inline bool mapBufferData(GLuint& vboID, GLsizeiptr size, void* src, GLenum usag
     return true;
 }
 
-bool ChunkMesher::uploadMeshData(ChunkMesh& mesh, ChunkMeshData* meshData) {
+bool ChunkMesher::uploadMeshData(ChunkMesh& mesh, ChunkMeshData* meshData, ChunkMeshBufferPool* bufferPool /*= nullptr*/) {
     bool canRender = false;
 
     //store the index data for sorting in the chunk mesh
@@ -686,7 +742,9 @@ bool ChunkMesher::uploadMeshData(ChunkMesh& mesh, ChunkMeshData* meshData) {
 
     switch (meshData->type) {
         case MeshTaskType::DEFAULT:
-            if (meshData->opaqueQuads.size()) {
+            if (bufferPool) {
+                if (bufferPool->upload(mesh.opaqueAlloc, meshData->opaqueQuads)) canRender = true;
+            } else if (meshData->opaqueQuads.size()) {
 
                 mapBufferData(mesh.vboID, meshData->opaqueQuads.size() * sizeof(VoxelQuad), &(meshData->opaqueQuads[0]), GL_STATIC_DRAW);
                 canRender = true;
@@ -729,7 +787,9 @@ bool ChunkMesher::uploadMeshData(ChunkMesh& mesh, ChunkMeshData* meshData) {
                 }
             }
 
-            if (meshData->cutoutQuads.size()) {
+            if (bufferPool) {
+                if (bufferPool->upload(mesh.cutoutAlloc, meshData->cutoutQuads)) canRender = true;
+            } else if (meshData->cutoutQuads.size()) {
 
                 mapBufferData(mesh.cutoutVboID, meshData->cutoutQuads.size() * sizeof(VoxelQuad), &(meshData->cutoutQuads[0]), GL_STATIC_DRAW);
                 canRender = true;
@@ -957,6 +1017,10 @@ void ChunkMesher::addQuad(int face, int rightAxis, int frontAxis, int leftOffset
         atlasIndices[i] = (ui8)(methodDatas[i].index / ATLAS_SIZE);
         methodDatas[i].index &= ATLAS_MODULUS_BITS;
     }
+
+    // Lit by the voxel the face looks into
+    applyLight(blockIndex + FACE_LIGHT_OFFSETS[face], blockColor[B_INDEX]);
+    applyLight(blockIndex + FACE_LIGHT_OFFSETS[face], blockColor[O_INDEX]);
     
     i32v3 pos(bx, by, bz);
     ui8 uOffset = (ui8)(pos[FACE_AXIS[face][0]] * FACE_AXIS_SIGN[face][0]);
@@ -1062,6 +1126,10 @@ void ChunkMesher::addFlora() {
         data.methodDatas[i].index &= ATLAS_MODULUS_BITS;
     }
 
+    // Flora is lit by its own voxel
+    applyLight(blockIndex, data.blockColor[B_INDEX]);
+    applyLight(blockIndex, data.blockColor[O_INDEX]);
+
     i32v3 pos(bx, by, bz);
     data.uOffset = (ui8)(pos[FACE_AXIS[0][0]] * FACE_AXIS_SIGN[0][0]);
     data.vOffset = (ui8)(pos[FACE_AXIS[0][1]] * FACE_AXIS_SIGN[0][1]);
@@ -1505,6 +1573,143 @@ int ChunkMesher::getLiquidLevel(int blockIndex, const Block& block) {
     return val;
 }
 
+ui16 ChunkMesher::computeFaceConnectivity() {
+    memset(m_floodVisited, 0, sizeof(m_floodVisited));
+    ui16 connectivity = 0;
+
+    for (int start = 0; start < CHUNK_SIZE; start++) {
+        if (m_floodVisited[start]) continue;
+        m_floodVisited[start] = 1;
+        int x = start % CHUNK_WIDTH;
+        int z = (start / CHUNK_WIDTH) % CHUNK_WIDTH;
+        int y = start / CHUNK_LAYER;
+        int padded = (y + 1) * PADDED_CHUNK_LAYER + (z + 1) * PADDED_CHUNK_WIDTH + (x + 1);
+        if (blocks->operator[](blockData[padded]).occlude == BlockOcclusion::ALL) continue;
+
+        // Fill this region and collect the faces it touches
+        ui8 faces = 0;
+        int stackSize = 0;
+        m_floodStack[stackSize++] = (ui16)start;
+        while (stackSize) {
+            int c = m_floodStack[--stackSize];
+            x = c % CHUNK_WIDTH;
+            z = (c / CHUNK_WIDTH) % CHUNK_WIDTH;
+            y = c / CHUNK_LAYER;
+            padded = (y + 1) * PADDED_CHUNK_LAYER + (z + 1) * PADDED_CHUNK_WIDTH + (x + 1);
+            if (blocks->operator[](blockData[padded]).occlude == BlockOcclusion::ALL) continue;
+
+#define TRY_FLOOD(cond, face, off) \
+    if (cond) { \
+        if (!m_floodVisited[c + (off)]) { m_floodVisited[c + (off)] = 1; m_floodStack[stackSize++] = (ui16)(c + (off)); } \
+    } else { faces |= 1 << (face); }
+
+            TRY_FLOOD(x > 0, 0, -1);
+            TRY_FLOOD(x < CHUNK_WIDTH - 1, 1, 1);
+            TRY_FLOOD(y > 0, 2, -CHUNK_LAYER);
+            TRY_FLOOD(y < CHUNK_WIDTH - 1, 3, CHUNK_LAYER);
+            TRY_FLOOD(z > 0, 4, -CHUNK_WIDTH);
+            TRY_FLOOD(z < CHUNK_WIDTH - 1, 5, CHUNK_WIDTH);
+#undef TRY_FLOOD
+        }
+
+        for (int a = 0; a < 6; a++) {
+            if (!(faces & (1 << a))) continue;
+            for (int b = a + 1; b < 6; b++) {
+                if (faces & (1 << b)) connectivity |= getFacePairBit(a, b);
+            }
+        }
+        if (connectivity == CHUNK_FACE_CONNECTIVITY_ALL) break;
+    }
+    return connectivity;
+}
+
+void ChunkMesher::downsampleData(ui32 lod) {
+    const int cellWidth = 1 << lod;
+    for (int cy = 0; cy < CHUNK_WIDTH; cy += cellWidth) {
+        for (int cz = 0; cz < CHUNK_WIDTH; cz += cellWidth) {
+            for (int cx = 0; cx < CHUNK_WIDTH; cx += cellWidth) {
+                // Tally the blocks in the cell. Cells rarely hold more than a few
+                // distinct blocks so a linear search is fine.
+                int numIDs = 0;
+                ui16 sunlight = 0;
+                ui16 lamp = 0;
+                for (int y = cy; y < cy + cellWidth; y++) {
+                    for (int z = cz; z < cz + cellWidth; z++) {
+                        int index = (y + 1) * PADDED_CHUNK_LAYER + (z + 1) * PADDED_CHUNK_WIDTH + cx + 1;
+                        for (int x = 0; x < cellWidth; x++, index++) {
+                            ui16 id = blockData[index];
+                            sunlight = vmath::max(sunlight, sunlightData[index]);
+                            lamp = vmath::max(lamp, lampData[index]);
+                            int i = 0;
+                            while (i < numIDs && m_lodIDs[i] != id) i++;
+                            if (i == numIDs) {
+                                m_lodIDs[numIDs] = id;
+                                m_lodCounts[numIDs] = 0;
+                                m_lodTertiary[numIDs] = tertiaryData[index];
+                                numIDs++;
+                            }
+                            m_lodCounts[i]++;
+                        }
+                    }
+                }
+                if (numIDs == 1) continue; // Already uniform
+
+                // Ties go to solid blocks so thin features don't vanish
+                int best = 0;
+                for (int i = 1; i < numIDs; i++) {
+                    if (m_lodCounts[i] > m_lodCounts[best] ||
+                        (m_lodCounts[i] == m_lodCounts[best] && m_lodIDs[best] == 0)) {
+                        best = i;
+                    }
+                }
+
+                // Write back, skipping the full resolution shell
+                for (int y = cy; y < cy + cellWidth; y++) {
+                    if (y == 0 || y == CHUNK_WIDTH - 1) continue;
+                    for (int z = cz; z < cz + cellWidth; z++) {
+                        if (z == 0 || z == CHUNK_WIDTH - 1) continue;
+                        for (int x = cx; x < cx + cellWidth; x++) {
+                            if (x == 0 || x == CHUNK_WIDTH - 1) continue;
+                            int index = (y + 1) * PADDED_CHUNK_LAYER + (z + 1) * PADDED_CHUNK_WIDTH + (x + 1);
+                            blockData[index] = m_lodIDs[best];
+                            tertiaryData[index] = m_lodTertiary[best];
+                            // Brightest light in the cell, so merged air isn't dark
+                            sunlightData[index] = sunlight;
+                            lampData[index] = lamp;
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+void ChunkMesher::copyNeighborLight(const Chunk* neighbor, int srcIndex, int destIndex) {
+    if (neighbor->isLit) {
+        sunlightData[destIndex] = neighbor->sunlight.get(srcIndex);
+        lampData[destIndex] = neighbor->lamp.get(srcIndex);
+    } else {
+        // Unlit chunks haven't been seeded yet, guess from the column sun height
+        i32 worldY = (i32)neighbor->getVoxelPosition().pos.y + (srcIndex >> 10);
+        bool exposed = !neighbor->gridData || neighbor->gridData->isSkyExposed(srcIndex & (CHUNK_LAYER - 1), worldY);
+        sunlightData[destIndex] = exposed ? MAX_LIGHT : 0;
+        lampData[destIndex] = 0;
+    }
+}
+
+void ChunkMesher::applyLight(int lightIndex, color3& color) {
+    // Brightest of sunlight and each lamp channel
+    ui16 lamp = lampData[lightIndex];
+    f32 sun = (f32)sunlightData[lightIndex];
+    f32v3 light(vmath::max(sun, (f32)VoxelBits::getLampRedFromHex(lamp)),
+                vmath::max(sun, (f32)VoxelBits::getLampGreenFromHex(lamp)),
+                vmath::max(sun, (f32)VoxelBits::getLampBlueFromHex(lamp)));
+    light = MIN_LIGHT + light * ((1.0f - MIN_LIGHT) / MAX_LIGHT);
+    color.r = (ui8)(color.r * light.r);
+    color.g = (ui8)(color.g * light.g);
+    color.b = (ui8)(color.b * light.b);
+}
+
 bool ChunkMesher::shouldRenderFace(int offset) {
     const Block& neighbor = blocks->operator[](blockData[blockIndex + offset]);
     if (neighbor.occlude == BlockOcclusion::ALL) return false;
@@ -7,6 +7,7 @@
 
 class BlockPack;
 class BlockTextureLayer;
+class ChunkMeshBufferPool;
 class ChunkMeshData;
 struct BlockTexture;
 struct PlanetHeightData;
@@ -17,6 +18,10 @@ const int PADDED_CHUNK_WIDTH = (CHUNK_WIDTH + 2);
 const int PADDED_CHUNK_LAYER = (PADDED_CHUNK_WIDTH * PADDED_CHUNK_WIDTH);
 const int PADDED_CHUNK_SIZE = (PADDED_CHUNK_LAYER * PADDED_CHUNK_WIDTH);
 
+// Coarsest mesh LOD, 8x8x8 voxel cells
+#define CHUNK_LOD_MAX 3
+#define CHUNK_LOD_MAX_CELL_SIZE (1 << (CHUNK_LOD_MAX * 3))
+
 // !!! IMPORTANT !!!
 // TODO(BEN): Make a class for complex Chunk Mesh Splicing. Store plenty of metadata in RAM about the regions in each mesh and just do a CPU copy to align them all and mix them around. Then meshes can be remeshed, rendered, recombined, at will.
 // Requirements: Each chunk is only meshed when it needs to, as they do now.
@@ -35,6 +40,7 @@ class ChunkMesher {
         prepareData(chunk);
         ChunkMesh* mesh = new ChunkMesh;
         mesh->position = chunk->getVoxelPosition().pos;
+        mesh->origin = mesh->position;
         uploadMeshData(*mesh, createChunkMeshData(type));
         return mesh;
     }
@@ -46,10 +52,13 @@ class ChunkMesher {
 
     // TODO(Ben): Unique ptr?
     // Must call prepareData or prepareDataAsync first
-    CALLER_DELETE ChunkMeshData* createChunkMeshData(MeshTaskType type);
+    // If meshData is null a new one is allocated, otherwise it is cleared and filled.
+    // lod > 0 meshes the interior at 2^lod voxel resolution, see downsampleData.
+    CALLER_DELETE ChunkMeshData* createChunkMeshData(MeshTaskType type, ChunkMeshData* meshData = nullptr, ui32 lod = 0);
 
     // Returns true if the mesh is renderable
-    static bool uploadMeshData(ChunkMesh& mesh, ChunkMeshData* meshData);
+    // If bufferPool is set, opaque and cutout quads are packed into it instead of their own VBOs
+    static bool uploadMeshData(ChunkMesh& mesh, ChunkMeshData* meshData, ChunkMeshBufferPool* bufferPool = nullptr);
 
     // Frees buffers AND deletes memory. mesh Pointer is invalid after calling.
     static void freeChunkMesh(CALLEE_DELETE ChunkMesh* mesh);
@@ -68,6 +77,8 @@ class ChunkMesher {
     // Voxel data arrays
     ui16 blockData[PADDED_CHUNK_SIZE];
     ui16 tertiaryData[PADDED_CHUNK_SIZE];
+    ui16 sunlightData[PADDED_CHUNK_SIZE];
+    ui16 lampData[PADDED_CHUNK_SIZE]; ///< Packed 5 bit RGB
 
     const BlockPack* blocks = nullptr;
 
@@ -83,6 +94,20 @@ class ChunkMesher {
 
     int getLiquidLevel(int blockIndex, const Block& block);
 
+    // Flood fills the non-occluding voxels to find which faces connect
+    ui16 computeFaceConnectivity();
+
+    // Replaces each 2^lod cube of interior voxels with its most common block.
+    // The outer voxel shell of the chunk is left at full resolution so seams
+    // with neighbors of any LOD stay watertight.
+    void downsampleData(ui32 lod);
+
+    // Light for padded boundary voxels. Only face neighbors are needed since
+    // faces sample the single voxel they look into.
+    void copyNeighborLight(const Chunk* neighbor, int srcIndex, int destIndex);
+    // Scales color by the light at a padded index
+    void applyLight(int lightIndex, color3& color);
+
     bool shouldRenderFace(int offset);
     int getOcclusion(const Block& block);
 
@@ -124,6 +149,15 @@ class ChunkMesher {
 
     ui32 m_finalQuads[7000];
 
+    // Flood fill buffers for computeFaceConnectivity
+    ui16 m_floodStack[CHUNK_SIZE];
+    ui8 m_floodVisited[CHUNK_SIZE];
+
+    // Scratch for downsampleData, one entry per voxel in a cell
+    ui16 m_lodIDs[CHUNK_LOD_MAX_CELL_SIZE];
+    ui16 m_lodCounts[CHUNK_LOD_MAX_CELL_SIZE];
+    ui16 m_lodTertiary[CHUNK_LOD_MAX_CELL_SIZE];
+
     BlockVertex m_topVerts[4100];
 
 };
\ No newline at end of file
@@ -3,6 +3,7 @@
 
 #include "Camera.h"
 #include "Chunk.h"
+#include "ChunkMeshBufferPool.h"
 #include "ChunkMeshManager.h"
 #include "Frustum.h"
 #include "GameManager.h"
@@ -18,6 +19,77 @@ f32m4 ChunkRenderer::worldMatrix = f32m4(1.0f);
 
 VGIndexBuffer ChunkRenderer::sharedIBO = 0;
 
+void ChunkRenderer::setWorldMatrix(const ChunkMesh* cm, const f64v3& playerPos) {
+    worldMatrix[0] = f32v4(f32v3(cm->axisX), 0.0f);
+    worldMatrix[2] = f32v4(f32v3(cm->axisZ), 0.0f);
+    setMatrixTranslation(worldMatrix, cm->origin, playerPos);
+}
+
+void ChunkDrawPage::clear() {
+    counts.clear();
+    indices.clear();
+    baseVertices.clear();
+    runs.clear();
+}
+
+void ChunkDrawList::clear() {
+    for (auto& page : pages) page.clear();
+    meshes.clear();
+    m_numDrawCalls = 0;
+}
+
+void ChunkDrawList::addOpaqueFaces(const ChunkMesh* cm, const f64v3& playerPos) {
+    if (!cm->opaqueAlloc.isValid()) return;
+    const ChunkMeshRenderData& rd = cm->renderData;
+    // Ordered by offset, matching the layout from ChunkMesher::createChunkMeshData
+    const i32 offsets[6] = { rd.nxVboOff, rd.pxVboOff, rd.nyVboOff, rd.pyVboOff, rd.nzVboOff, rd.pzVboOff };
+    const i32 sizes[6] = { rd.nxVboSize, rd.pxVboSize, rd.nyVboSize, rd.pyVboSize, rd.nzVboSize, rd.pzVboSize };
+    // Face groups are in the chunk's own axes
+    const f64v3 eye = cm->toChunkSpace(playerPos);
+    const bool visible[6] = {
+        eye.x < rd.highestX,
+        eye.x > rd.lowestX,
+        eye.y < rd.highestY,
+        eye.y > rd.lowestY,
+        eye.z < rd.highestZ,
+        eye.z > rd.lowestZ
+    };
+    for (int i = 0; i < 6; i++) {
+        if (sizes[i] && visible[i]) addRange(cm, cm->opaqueAlloc, offsets[i], sizes[i]);
+    }
+}
+
+void ChunkDrawList::addRange(const ChunkMesh* cm, const MeshBufferAllocation& allocation, ui32 firstIndex, ui32 count) {
+    if (!allocation.isValid() || count == 0) return;
+    if (meshes.empty() || meshes.back() != cm) meshes.push_back(cm);
+    if (pages.size() <= allocation.page) pages.resize(allocation.page + 1);
+    ChunkDrawPage& page = pages[allocation.page];
+
+    GLint baseVertex = (GLint)(allocation.offset * 4);
+    const GLvoid* start = (const GLvoid*)(firstIndex * sizeof(GLuint));
+    ui32 mesh = (ui32)meshes.size() - 1;
+    if (page.runs.size() && page.runs.back().mesh == mesh) {
+        // Merge with the previous range if it ends where this one starts
+        size_t last = page.counts.size() - 1;
+        if (page.baseVertices[last] == baseVertex &&
+            (const GLuint*)page.indices[last] + page.counts[last] == (const GLuint*)start) {
+            page.counts[last] += (GLsizei)count;
+            return;
+        }
+        page.runs.back().count++;
+    } else {
+        ChunkDrawRun run;
+        run.mesh = mesh;
+        run.first = (ui32)page.counts.size();
+        run.count = 1;
+        page.runs.push_back(run);
+        m_numDrawCalls++;
+    }
+    page.counts.push_back((GLsizei)count);
+    page.indices.push_back(start);
+    page.baseVertices.push_back(baseVertex);
+}
+
 void ChunkRenderer::init() {
     // Not thread safe
     if (!sharedIBO) { // Create shared IBO if needed
@@ -95,7 +167,7 @@ void ChunkRenderer::beginOpaque(VGTexture textureAtlas, const f32v3& sunDir, con
 void ChunkRenderer::drawOpaque(const ChunkMesh *cm, const f64v3 &PlayerPos, const f32m4 &VP) const {
     if (cm->vaoID == 0) return;
     
-    setMatrixTranslation(worldMatrix, f64v3(cm->position), PlayerPos);
+    setWorldMatrix(cm, PlayerPos);
 
     f32m4 MVP = VP * worldMatrix;
     glUniformMatrix4fv(m_opaqueProgram.getUniform("unWVP"), 1, GL_FALSE, &MVP[0][0]);
@@ -104,28 +176,29 @@ void ChunkRenderer::drawOpaque(const ChunkMesh *cm, const f64v3 &PlayerPos, cons
     glBindVertexArray(cm->vaoID);
 
     const ChunkMeshRenderData& chunkMeshInfo = cm->renderData;
+    const f64v3 eye = cm->toChunkSpace(PlayerPos);
     //top
-    if (chunkMeshInfo.pyVboSize && PlayerPos.y > cm->position.y + chunkMeshInfo.lowestY) {
+    if (chunkMeshInfo.pyVboSize && eye.y > chunkMeshInfo.lowestY) {
         glDrawElements(GL_TRIANGLES, chunkMeshInfo.pyVboSize, GL_UNSIGNED_INT, (void*)(chunkMeshInfo.pyVboOff * sizeof(GLuint)));
     }
     //front
-    if (chunkMeshInfo.pzVboSize && PlayerPos.z > cm->position.z + chunkMeshInfo.lowestZ){
+    if (chunkMeshInfo.pzVboSize && eye.z > chunkMeshInfo.lowestZ){
         glDrawElements(GL_TRIANGLES, chunkMeshInfo.pzVboSize, GL_UNSIGNED_INT, (void*)(chunkMeshInfo.pzVboOff * sizeof(GLuint)));
     }
     //back
-    if (chunkMeshInfo.nzVboSize && PlayerPos.z < cm->position.z + chunkMeshInfo.highestZ){
+    if (chunkMeshInfo.nzVboSize && eye.z < chunkMeshInfo.highestZ){
         glDrawElements(GL_TRIANGLES, chunkMeshInfo.nzVboSize, GL_UNSIGNED_INT, (void*)(chunkMeshInfo.nzVboOff * sizeof(GLuint)));
     }
     //left
-    if (chunkMeshInfo.nxVboSize && PlayerPos.x < cm->position.x + chunkMeshInfo.highestX){
+    if (chunkMeshInfo.nxVboSize && eye.x < chunkMeshInfo.highestX){
         glDrawElements(GL_TRIANGLES, chunkMeshInfo.nxVboSize, GL_UNSIGNED_INT, (void*)(chunkMeshInfo.nxVboOff * sizeof(GLuint)));
     }
     //right
-    if (chunkMeshInfo.pxVboSize && PlayerPos.x > cm->position.x + chunkMeshInfo.lowestX){
+    if (chunkMeshInfo.pxVboSize && eye.x > chunkMeshInfo.lowestX){
         glDrawElements(GL_TRIANGLES, chunkMeshInfo.pxVboSize, GL_UNSIGNED_INT, (void*)(chunkMeshInfo.pxVboOff * sizeof(GLuint)));
     }
     //bottom
-    if (chunkMeshInfo.nyVboSize && PlayerPos.y < cm->position.y + chunkMeshInfo.highestY){
+    if (chunkMeshInfo.nyVboSize && eye.y < chunkMeshInfo.highestY){
         glDrawElements(GL_TRIANGLES, chunkMeshInfo.nyVboSize, GL_UNSIGNED_INT, (void*)(chunkMeshInfo.nyVboOff * sizeof(GLuint)));
     }
 
@@ -135,7 +208,7 @@ void ChunkRenderer::drawOpaque(const ChunkMesh *cm, const f64v3 &PlayerPos, cons
 void ChunkRenderer::drawOpaqueCustom(const ChunkMesh* cm, vg::GLProgram& m_program, const f64v3& PlayerPos, const f32m4& VP) {
     if (cm->vaoID == 0) return;
     
-    setMatrixTranslation(worldMatrix, f64v3(cm->position), PlayerPos);
+    setWorldMatrix(cm, PlayerPos);
 
     f32m4 MVP = VP * worldMatrix;
 
@@ -145,28 +218,29 @@ void ChunkRenderer::drawOpaqueCustom(const ChunkMesh* cm, vg::GLProgram& m_progr
     glBindVertexArray(cm->vaoID);
 
     const ChunkMeshRenderData& chunkMeshInfo = cm->renderData;
+    const f64v3 eye = cm->toChunkSpace(PlayerPos);
     //top
-    if (chunkMeshInfo.pyVboSize && PlayerPos.y > cm->position.y + chunkMeshInfo.lowestY) {
+    if (chunkMeshInfo.pyVboSize && eye.y > chunkMeshInfo.lowestY) {
         glDrawElements(GL_TRIANGLES, chunkMeshInfo.pyVboSize, GL_UNSIGNED_INT, (void*)(chunkMeshInfo.pyVboOff * sizeof(GLuint)));
     }
     //front
-    if (chunkMeshInfo.pzVboSize && PlayerPos.z > cm->position.z + chunkMeshInfo.lowestZ) {
+    if (chunkMeshInfo.pzVboSize && eye.z > chunkMeshInfo.lowestZ) {
         glDrawElements(GL_TRIANGLES, chunkMeshInfo.pzVboSize, GL_UNSIGNED_INT, (void*)(chunkMeshInfo.pzVboOff * sizeof(GLuint)));
     }
     //back
-    if (chunkMeshInfo.nzVboSize && PlayerPos.z < cm->position.z + chunkMeshInfo.highestZ) {
+    if (chunkMeshInfo.nzVboSize && eye.z < chunkMeshInfo.highestZ) {
         glDrawElements(GL_TRIANGLES, chunkMeshInfo.nzVboSize, GL_UNSIGNED_INT, (void*)(chunkMeshInfo.nzVboOff * sizeof(GLuint)));
     }
     //left
-    if (chunkMeshInfo.nxVboSize && PlayerPos.x < cm->position.x + chunkMeshInfo.highestX) {
+    if (chunkMeshInfo.nxVboSize && eye.x < chunkMeshInfo.highestX) {
         glDrawElements(GL_TRIANGLES, chunkMeshInfo.nxVboSize, GL_UNSIGNED_INT, (void*)(chunkMeshInfo.nxVboOff * sizeof(GLuint)));
     }
     //right
-    if (chunkMeshInfo.pxVboSize && PlayerPos.x > cm->position.x + chunkMeshInfo.lowestX) {
+    if (chunkMeshInfo.pxVboSize && eye.x > chunkMeshInfo.lowestX) {
         glDrawElements(GL_TRIANGLES, chunkMeshInfo.pxVboSize, GL_UNSIGNED_INT, (void*)(chunkMeshInfo.pxVboOff * sizeof(GLuint)));
     }
     //bottom
-    if (chunkMeshInfo.nyVboSize && PlayerPos.y < cm->position.y + chunkMeshInfo.highestY) {
+    if (chunkMeshInfo.nyVboSize && eye.y < chunkMeshInfo.highestY) {
         glDrawElements(GL_TRIANGLES, chunkMeshInfo.nyVboSize, GL_UNSIGNED_INT, (void*)(chunkMeshInfo.nyVboOff * sizeof(GLuint)));
     }
 
@@ -174,6 +248,35 @@ void ChunkRenderer::drawOpaqueCustom(const ChunkMesh* cm, vg::GLProgram& m_progr
 }
 
 
+void ChunkRenderer::drawOpaque(const ChunkDrawList& list, const ChunkMeshBufferPool& pool, const f64v3& playerPos, const f32m4& VP) const {
+    drawListCustom(list, pool, m_opaqueProgram, playerPos, VP);
+}
+
+void ChunkRenderer::drawCutout(const ChunkDrawList& list, const ChunkMeshBufferPool& pool, const f64v3& playerPos, const f32m4& VP) const {
+    drawListCustom(list, pool, m_cutoutProgram, playerPos, VP);
+}
+
+void ChunkRenderer::drawListCustom(const ChunkDrawList& list, const ChunkMeshBufferPool& pool, const vg::GLProgram& program, const f64v3& playerPos, const f32m4& VP) {
+    VGUniform unWVP = program.getUniform("unWVP");
+    VGUniform unW = program.getUniform("unW");
+    for (size_t p = 0; p < list.pages.size(); p++) {
+        const ChunkDrawPage& page = list.pages[p];
+        if (page.runs.empty()) continue;
+        glBindVertexArray(pool.getPageVao(p));
+
+        // Each mesh needs its own translation, so its face ranges go in one call
+        for (auto& run : page.runs) {
+            setWorldMatrix(list.meshes[run.mesh], playerPos);
+            f32m4 MVP = VP * worldMatrix;
+            glUniformMatrix4fv(unWVP, 1, GL_FALSE, &MVP[0][0]);
+            glUniformMatrix4fv(unW, 1, GL_FALSE, &worldMatrix[0][0]);
+            glMultiDrawElementsBaseVertex(GL_TRIANGLES, &page.counts[run.first], GL_UNSIGNED_INT,
+                                          &page.indices[run.first], (GLsizei)run.count, &page.baseVertices[run.first]);
+        }
+    }
+    glBindVertexArray(0);
+}
+
 void ChunkRenderer::beginTransparent(VGTexture textureAtlas, const f32v3& sunDir, const f32v3& lightColor /*= f32v3(1.0f)*/, const f32v3& ambient /*= f32v3(0.0f)*/) {
     m_transparentProgram.use();
     
@@ -197,7 +300,7 @@ void ChunkRenderer::beginTransparent(VGTexture textureAtlas, const f32v3& sunDir
 void ChunkRenderer::drawTransparent(const ChunkMesh *cm, const f64v3 &playerPos, const f32m4 &VP) const {
     if (cm->transVaoID == 0) return;
 
-    setMatrixTranslation(worldMatrix, f64v3(cm->position), playerPos);
+    setWorldMatrix(cm, playerPos);
 
     f32m4 MVP = VP * worldMatrix;
 
@@ -233,7 +336,7 @@ void ChunkRenderer::beginCutout(VGTexture textureAtlas, const f32v3& sunDir, con
 void ChunkRenderer::drawCutout(const ChunkMesh *cm, const f64v3 &playerPos, const f32m4 &VP) const {
     if (cm->cutoutVaoID == 0) return;
 
-    setMatrixTranslation(worldMatrix, f64v3(cm->position), playerPos);
+    setWorldMatrix(cm, playerPos);
 
     f32m4 MVP = VP * worldMatrix;
 
@@ -270,7 +373,7 @@ void ChunkRenderer::drawLiquid(const ChunkMesh *cm, const f64v3 &PlayerPos, cons
     //use drawWater bool to avoid checking frustum twice
     if (cm->inFrustum && cm->waterVboID){
 
-        setMatrixTranslation(worldMatrix, f64v3(cm->position), PlayerPos);
+        setWorldMatrix(cm, PlayerPos);
 
         f32m4 MVP = VP * worldMatrix;
 
@@ -7,11 +7,49 @@
 
 #include "ChunkMesh.h"
 
+class ChunkMeshBufferPool;
 class GameRenderParams;
 class PhysicsBlockMesh;
 
 #define CHUNK_DIAGONAL_LENGTH 28.0f
 
+/// Consecutive ranges of one mesh, drawn with a single multi-draw
+struct ChunkDrawRun {
+    ui32 mesh; ///< Index into ChunkDrawList::meshes
+    ui32 first; ///< First range in the page arrays
+    ui32 count; ///< Number of ranges
+};
+
+/// Ranges in one buffer page, in the layout glMultiDrawElementsBaseVertex takes
+struct ChunkDrawPage {
+    void clear();
+
+    std::vector<GLsizei> counts;
+    std::vector<const GLvoid*> indices;
+    std::vector<GLint> baseVertices;
+    std::vector<ChunkDrawRun> runs;
+};
+
+/// Per-frame draw ranges for meshes in a ChunkMeshBufferPool,
+/// bucketed by buffer page so each page only binds its VAO once.
+class ChunkDrawList {
+public:
+    void clear();
+    /// Adds the opaque face groups that can face the camera. Adjacent
+    /// groups are merged into a single range.
+    void addOpaqueFaces(const ChunkMesh* cm, const f64v3& playerPos);
+    /// Adds a range of indices from an allocation
+    void addRange(const ChunkMesh* cm, const MeshBufferAllocation& allocation, ui32 firstIndex, ui32 count);
+
+    /// @return Number of draw calls the list takes, one per mesh per page
+    ui32 getNumDrawCalls() const { return m_numDrawCalls; }
+
+    std::vector<ChunkDrawPage> pages;
+    std::vector<const ChunkMesh*> meshes;
+private:
+    ui32 m_numDrawCalls = 0;
+};
+
 class ChunkRenderer {
 public:
     // Loads the shaders. Call on render thread.
@@ -22,6 +60,11 @@ class ChunkRenderer {
     void drawOpaque(const ChunkMesh* cm, const f64v3& PlayerPos, const f32m4& VP) const;
     static void drawOpaqueCustom(const ChunkMesh* cm, vg::GLProgram& m_program, const f64v3& PlayerPos, const f32m4& VP);
 
+    /// Draws pooled meshes
+    void drawOpaque(const ChunkDrawList& list, const ChunkMeshBufferPool& pool, const f64v3& playerPos, const f32m4& VP) const;
+    void drawCutout(const ChunkDrawList& list, const ChunkMeshBufferPool& pool, const f64v3& playerPos, const f32m4& VP) const;
+    static void drawListCustom(const ChunkDrawList& list, const ChunkMeshBufferPool& pool, const vg::GLProgram& program, const f64v3& playerPos, const f32m4& VP);
+
     void beginTransparent(VGTexture textureAtlas, const f32v3& sunDir, const f32v3& lightColor = f32v3(1.0f), const f32v3& ambient = f32v3(0.0f));
     void drawTransparent(const ChunkMesh* cm, const f64v3& playerPos, const f32m4& VP) const;
     
@@ -37,6 +80,9 @@ class ChunkRenderer {
     static volatile f32 fadeDist;
     static VGIndexBuffer sharedIBO;
 private:
+    /// Points worldMatrix at the mesh in the render face's space, relative to playerPos
+    static void setWorldMatrix(const ChunkMesh* cm, const f64v3& playerPos);
+
     static f32m4 worldMatrix; ///< Reusable world matrix for chunks
     vg::GLProgram m_opaqueProgram;
     vg::GLProgram m_transparentProgram;
@@ -20,12 +20,20 @@ void ChunkSphereComponentUpdater::update(GameSystem* gameSystem, SpaceSystem* sp
 
         // Check for grid shift or init
         if (cmp.currentCubeFace != chunkPos.face) {
-            releaseHandles(cmp);
-            cmp.centerPosition = chunkPos;
-            cmp.currentCubeFace = chunkPos.face;
             auto& sphericalVoxel = spaceSystem->sphericalVoxel.get(voxelPos.parentVoxel);
-            cmp.chunkGrid = &sphericalVoxel.chunkGrids[chunkPos.face];
-            initSphere(cmp);
+            if (cmp.currentCubeFace == FACE_NONE || cmp.chunkGrids != sphericalVoxel.chunkGrids) {
+                releaseSlots(cmp);
+                releasePrefetches(cmp, false);
+                cmp.centerPosition = chunkPos;
+                cmp.currentCubeFace = chunkPos.face;
+                cmp.chunkGrids = sphericalVoxel.chunkGrids;
+                cmp.chunkGrid = &cmp.chunkGrids[chunkPos.face];
+                cmp.faceChunkRadius = (i32)(sphericalVoxel.voxelRadius / CHUNK_WIDTH);
+                initSphere(cmp);
+            } else {
+                // Crossed a face edge, only the new shell needs loading
+                rebaseSphere(cmp, chunkPos);
+            }
         }
 
         // Check for shift
@@ -45,8 +53,11 @@ void ChunkSphereComponentUpdater::update(GameSystem* gameSystem, SpaceSystem* sp
                     shiftDirection(cmp, Y_AXIS, X_AXIS, Z_AXIS, offset.y);
                 }
                 cmp.centerPosition = chunkPos.pos;
+                // Anything the sphere was still missing has moved
+                if (cmp.fillIndex < cmp.shellOffsets.size()) cmp.fillIndex = 0;
             } else {
                 // Slow version. Multi-chunk shift.
+                i32v3 oldCenter = cmp.centerPosition;
                 cmp.offset += chunkPos.pos - cmp.centerPosition;
                 // Scale back to the range
                 for (int i = 0; i < 3; i++) {
@@ -56,40 +67,35 @@ void ChunkSphereComponentUpdater::update(GameSystem* gameSystem, SpaceSystem* sp
                 cmp.centerPosition = chunkPos.pos;
                 int radius2 = cmp.radius * cmp.radius;
 
-                // Get all in range slots
-                for (int y = -cmp.radius; y <= cmp.radius; y++) {
-                    for (int z = -cmp.radius; z <= cmp.radius; z++) {
-                        for (int x = -cmp.radius; x <= cmp.radius; x++) {
-                            i32v3 p = cmp.offset + i32v3(x, y, z);
-                            // Wrap (I hope this gets optimized)
-                            for (int i = 0; i < 3; i++) {
-                                if (p[i] < -cmp.radius) {
-                                    p[i] += cmp.width;
-                                } else if (p[i] > cmp.radius) {
-                                    p[i] -= cmp.width;
-                                }
-                            }
-
-                            int index = (p.y + cmp.radius) * cmp.layer + (p.z + cmp.radius) * cmp.width + (p.x + cmp.radius);
-                            if (cmp.handleGrid[index].isAquired()) {
-                                i32v3 diff = cmp.handleGrid[index]->getChunkPosition().pos - cmp.centerPosition;
-                                int d2 = selfDot(diff);
-                                if (d2 <= radius2) {
-                                    continue; // Still in range
-                                } else {
-                                    releaseAndDisconnect(cmp, cmp.handleGrid[index]);
-                                }
-                            }
-                            // Check if its in range
-                            if (x * x + y * y + z * z <= radius2) {
-                                i32v3 chunkPos(cmp.centerPosition.x + x,
-                                               cmp.centerPosition.y + y,
-                                               cmp.centerPosition.z + z);
-                                // TODO(Ben): Sort
-                                cmp.handleGrid[index] = submitAndConnect(cmp, chunkPos);
-                            }
-                        }
-                    }
+                // Release the part of the old sphere outside the new one.
+                // The rest is added nearest first by fillSphere.
+                for (auto& o : cmp.shellOffsets) {
+                    i32v3 diff = oldCenter + o - cmp.centerPosition;
+                    if (selfDot(diff) <= radius2) continue; // Still in range
+                    ChunkSphereSlot& slot = cmp.slotGrid[getSlot(cmp, diff)];
+                    if (slot.isActive) removeInterest(cmp, slot);
+                }
+                cmp.fillIndex = 0;
+            }
+        }
+
+        if (cmp.fillIndex < cmp.shellOffsets.size()) fillSphere(cmp);
+
+        // Prefetch along the path ahead when moving faster than the sphere can keep up with
+        cmp.updateCount++;
+        releasePrefetches(cmp, true);
+        vecs::ComponentID physicsID = gameSystem->physics.getComponentID(it.first);
+        if (physicsID) {
+            const f64v3& velocity = gameSystem->physics.get(physicsID).velocity;
+            f64 distance = vmath::length(velocity) * CHUNK_PREFETCH_UPDATES;
+            if (distance > cmp.radius * CHUNK_WIDTH) {
+                int submits = 0;
+                prefetchPath(cmp, voxelPos.gridPosition.pos, velocity / vmath::length(velocity), distance, submits);
+                // Also look where the head is facing, in case the entity turns
+                vecs::ComponentID headID = gameSystem->head.getComponentID(it.first);
+                if (headID) {
+                    f64q orientation = voxelPos.orientation * gameSystem->head.get(headID).relativeOrientation;
+                    prefetchPath(cmp, voxelPos.gridPosition.pos, orientation * f64v3(0.0, 0.0, 1.0), distance, submits);
                 }
             }
         }
@@ -97,8 +103,8 @@ void ChunkSphereComponentUpdater::update(GameSystem* gameSystem, SpaceSystem* sp
 }
 
 void ChunkSphereComponentUpdater::setRadius(ChunkSphereComponent& cmp, ui32 radius) {
-    // Release old handles
-    releaseHandles(cmp);
+    // Release old slots
+    releaseSlots(cmp);
 
     // Set vars
     cmp.radius = radius;
@@ -106,7 +112,7 @@ void ChunkSphereComponentUpdater::setRadius(ChunkSphereComponent& cmp, ui32 radi
     cmp.layer = cmp.width * cmp.width;
     cmp.size = cmp.layer * cmp.width;
 
-    // Allocate handles
+    // Allocate slots
     initSphere(cmp);
 }
 
@@ -128,7 +134,9 @@ void ChunkSphereComponentUpdater::shiftDirection(ChunkSphereComponent& cmp, int
                     p[i] -= cmp.width;
                 }
             }
-            releaseAndDisconnect(cmp, cmp.handleGrid[GET_INDEX(p.x, p.y, p.z)]);
+            // The sphere may still be filling
+            ChunkSphereSlot& slot = cmp.slotGrid[GET_INDEX(p.x, p.y, p.z)];
+            if (slot.isActive) removeInterest(cmp, slot);
         }
         // Acquire
         for (auto& o : cmp.acquireOffsets) {
@@ -148,7 +156,7 @@ void ChunkSphereComponentUpdater::shiftDirection(ChunkSphereComponent& cmp, int
             off[axis1] = o.x;
             off[axis2] = o.y;
             off[axis3] = o.z;
-            cmp.handleGrid[GET_INDEX(p.x, p.y, p.z)] = submitAndConnect(cmp, cmp.centerPosition + off);
+            addInterest(cmp, cmp.slotGrid[GET_INDEX(p.x, p.y, p.z)], cmp.centerPosition + off);
         }
 
         cmp.offset[axis1]++;
@@ -167,7 +175,9 @@ void ChunkSphereComponentUpdater::shiftDirection(ChunkSphereComponent& cmp, int
                     p[i] -= cmp.width;
                 }
             }
-            releaseAndDisconnect(cmp, cmp.handleGrid[GET_INDEX(p.x, p.y, p.z)]);
+            // The sphere may still be filling
+            ChunkSphereSlot& slot = cmp.slotGrid[GET_INDEX(p.x, p.y, p.z)];
+            if (slot.isActive) removeInterest(cmp, slot);
         }
         // Acquire
         for (auto& o : cmp.acquireOffsets) {
@@ -187,7 +197,7 @@ void ChunkSphereComponentUpdater::shiftDirection(ChunkSphereComponent& cmp, int
             off[axis1] = -o.x;
             off[axis2] = o.y;
             off[axis3] = o.z;
-            cmp.handleGrid[GET_INDEX(p.x, p.y, p.z)] = submitAndConnect(cmp, cmp.centerPosition + off);
+            addInterest(cmp, cmp.slotGrid[GET_INDEX(p.x, p.y, p.z)], cmp.centerPosition + off);
         }
 
         cmp.offset[axis1]--;
@@ -197,104 +207,187 @@ void ChunkSphereComponentUpdater::shiftDirection(ChunkSphereComponent& cmp, int
 
 #undef GET_INDEX
 
-ChunkHandle ChunkSphereComponentUpdater::submitAndConnect(ChunkSphereComponent& cmp, const i32v3& chunkPos) {
-    ChunkHandle h = cmp.chunkGrid->submitQuery(chunkPos, GEN_DONE, true)->chunk.acquire();
-    // TODO(Ben): meshableNeighbors
-    // Acquire the 26 neighbors
-    // TODO(Ben): Could optimize
-    ChunkAccessor& accessor = cmp.chunkGrid->accessor;
-    { // Left
-        ChunkID id = h.getID();
-        id.x--;
-        h->left = accessor.acquire(id);
-    }
-    { // Right
-        ChunkID id = h.getID();
-        id.x++;
-        h->right = accessor.acquire(id);
-    }
-    { // Bottom
-        ChunkID id = h.getID();
-        id.y--;
-        h->bottom = accessor.acquire(id);
-    }
-    { // Top
-        ChunkID id = h.getID();
-        id.y++;
-        h->top = accessor.acquire(id);
-    }
-    { // Back
-        ChunkID id = h.getID();
-        id.z--;
-        h->back = accessor.acquire(id);
-    }
-    { // Front
-        ChunkID id = h.getID();
-        id.z++;
-        h->front = accessor.acquire(id);
-    }
-    cmp.chunkGrid->onNeighborsAcquire(h);
-    return std::move(h);
-
-#undef GET_HALF
+bool ChunkSphereComponentUpdater::addInterest(ChunkSphereComponent& cmp, ChunkSphereSlot& slot, const i32v3& chunkPos) {
+    // Positions past the face edges are loaded from the neighboring face
+    ChunkPosition3D pos;
+    pos.face = cmp.currentCubeFace;
+    pos.pos = chunkPos;
+    if (!VoxelSpaceConversions::wrapChunkPosition(pos, cmp.faceChunkRadius)) return false;
+    slot.position = pos;
+    slot.isActive = true;
+    // Neighbor face chunks are meshed too, the mesh manager turns them into
+    // the space of the face being rendered
+    cmp.chunkGrids[pos.face].interest.addInterest(pos.pos, true);
+    return true;
 }
 
-void ChunkSphereComponentUpdater::releaseAndDisconnect(ChunkSphereComponent& cmp, ChunkHandle& h) {
-    // Call the event first to prevent race condition
-    cmp.chunkGrid->onNeighborsRelease(h);
-    h->left.release();
-    h->right.release();
-    h->back.release();
-    h->front.release();
-    h->bottom.release();
-    h->top.release();
-    h.release();
+void ChunkSphereComponentUpdater::removeInterest(ChunkSphereComponent& cmp, ChunkSphereSlot& slot) {
+    const ChunkPosition3D& pos = slot.position;
+    cmp.chunkGrids[pos.face].interest.removeInterest(pos.pos, true);
+    slot.isActive = false;
 }
 
-void ChunkSphereComponentUpdater::releaseHandles(ChunkSphereComponent& cmp) {
-    if (cmp.handleGrid) {
+void ChunkSphereComponentUpdater::releaseSlots(ChunkSphereComponent& cmp) {
+    if (cmp.slotGrid) {
         for (int i = 0; i < cmp.size; i++) {
-            if (cmp.handleGrid[i].isAquired()) releaseAndDisconnect(cmp, cmp.handleGrid[i]);
+            if (cmp.slotGrid[i].isActive) removeInterest(cmp, cmp.slotGrid[i]);
         }
-        delete[] cmp.handleGrid;
-        cmp.handleGrid = nullptr;
+        delete[] cmp.slotGrid;
+        cmp.slotGrid = nullptr;
     }
 }
 
 void ChunkSphereComponentUpdater::initSphere(ChunkSphereComponent& cmp) {
-    cmp.handleGrid = new ChunkHandle[cmp.size];
+    cmp.slotGrid = new ChunkSphereSlot[cmp.size];
     cmp.offset = i32v3(0);
 
     // Pre-compute offsets
     int radius2 = cmp.radius * cmp.radius;
 
-    // Get all in range slots
+    // Get all in range offsets, sorted into shells so loading is front to back
+    cmp.shellOffsets.clear();
     for (int y = -cmp.radius; y <= cmp.radius; y++) {
         for (int z = -cmp.radius; z <= cmp.radius; z++) {
             for (int x = -cmp.radius; x <= cmp.radius; x++) {
                 // Check if its in range
                 if (x * x + y * y + z * z <= radius2) {
-                    int index = (y + cmp.radius) * cmp.layer + (z + cmp.radius) * cmp.width + (x + cmp.radius);
-                    i32v3 chunkPos(cmp.centerPosition.x + x,
-                                   cmp.centerPosition.y + y,
-                                   cmp.centerPosition.z + z);
-                    // TODO(Ben): Sort
-                    cmp.handleGrid[index] = submitAndConnect(cmp, chunkPos);
+                    cmp.shellOffsets.emplace_back(x, y, z);
                 }
             }
         }
     }
-    // Determine +x acquire offsets
-    int index = 0;
+    std::stable_sort(cmp.shellOffsets.begin(), cmp.shellOffsets.end(), [](const i32v3& a, const i32v3& b) {
+        return selfDot(a) < selfDot(b);
+    });
+    cmp.fillIndex = 0;
+
+    // Determine +x acquire offsets, one past the end of each row
+    cmp.acquireOffsets.clear();
     for (int y = -cmp.radius; y <= cmp.radius; y++) {
         for (int z = -cmp.radius; z <= cmp.radius; z++) {
-            for (int x = -cmp.radius; x <= cmp.radius; x++, index++) {
-                if (cmp.handleGrid[index].isAquired()) {
-                    if (x == cmp.radius || !cmp.handleGrid[index + 1].isAquired()) {
-                        cmp.acquireOffsets.emplace_back(x + 1, y, z);
-                    }
+            int yz2 = y * y + z * z;
+            if (yz2 > radius2) continue;
+            int x = cmp.radius;
+            while (x * x + yz2 > radius2) x--;
+            cmp.acquireOffsets.emplace_back(x + 1, y, z);
+        }
+    }
+}
+
+void ChunkSphereComponentUpdater::rebaseSphere(ChunkSphereComponent& cmp, const ChunkPosition3D& chunkPos) {
+    ChunkSphereSlot* slotGrid = new ChunkSphereSlot[cmp.size];
+    int radius2 = cmp.radius * cmp.radius;
+
+    for (int i = 0; i < cmp.size; i++) {
+        ChunkSphereSlot& slot = cmp.slotGrid[i];
+        if (!slot.isActive) continue;
+        const ChunkPosition3D& pos = slot.position;
+        // Find where the chunk sits in the new face's space
+        i32v3 p(0);
+        bool keep = VoxelSpaceConversions::unwrapChunkPosition(pos, chunkPos.face, cmp.faceChunkRadius, p);
+        i32v3 diff = p - chunkPos.pos;
+        if (keep) keep = selfDot(diff) <= radius2;
+        if (keep) {
+            // It must also be the chunk the new sphere would have loaded there
+            ChunkPosition3D wrapped;
+            wrapped.face = chunkPos.face;
+            wrapped.pos = p;
+            keep = VoxelSpaceConversions::wrapChunkPosition(wrapped, cmp.faceChunkRadius) &&
+                   wrapped.face == pos.face && wrapped.pos == pos.pos;
+        }
+        if (!keep) {
+            removeInterest(cmp, slot);
+            continue;
+        }
+        int index = (diff.y + cmp.radius) * cmp.layer + (diff.z + cmp.radius) * cmp.width + (diff.x + cmp.radius);
+        slotGrid[index] = slot;
+    }
+
+    delete[] cmp.slotGrid;
+    cmp.slotGrid = slotGrid;
+    cmp.offset = i32v3(0);
+    cmp.centerPosition = chunkPos.pos;
+    cmp.currentCubeFace = chunkPos.face;
+    cmp.chunkGrid = &cmp.chunkGrids[chunkPos.face];
+    cmp.fillIndex = 0;
+}
+
+void ChunkSphereComponentUpdater::fillSphere(ChunkSphereComponent& cmp) {
+    int submits = 0;
+    while (cmp.fillIndex < cmp.shellOffsets.size()) {
+        const i32v3& o = cmp.shellOffsets[cmp.fillIndex];
+        ChunkSphereSlot& slot = cmp.slotGrid[getSlot(cmp, o)];
+        if (!slot.isActive) {
+            if (submits == CHUNK_SPHERE_MAX_SUBMITS_PER_UPDATE) return;
+            // Positions past two face edges have no chunk
+            if (addInterest(cmp, slot, cmp.centerPosition + o)) submits++;
+        }
+        cmp.fillIndex++;
+    }
+}
+
+void ChunkSphereComponentUpdater::prefetchPath(ChunkSphereComponent& cmp, const f64v3& position, const f64v3& direction,
+                                               f64 distance, int& submits) {
+    const int PREFETCH_RADIUS2 = CHUNK_PREFETCH_RADIUS * CHUNK_PREFETCH_RADIUS;
+    int radius2 = cmp.radius * cmp.radius;
+
+    // Walk the path a chunk at a time starting at the edge of the sphere, so
+    // the nearest chunks are requested first
+    for (f64 d = (f64)(cmp.radius * CHUNK_WIDTH); d <= distance; d += CHUNK_WIDTH) {
+        i32v3 pathChunk = VoxelSpaceConversions::voxelToChunk(position + direction * d);
+        for (int y = -CHUNK_PREFETCH_RADIUS; y <= CHUNK_PREFETCH_RADIUS; y++) {
+            for (int z = -CHUNK_PREFETCH_RADIUS; z <= CHUNK_PREFETCH_RADIUS; z++) {
+                for (int x = -CHUNK_PREFETCH_RADIUS; x <= CHUNK_PREFETCH_RADIUS; x++) {
+                    if (x * x + y * y + z * z > PREFETCH_RADIUS2) continue;
+                    if (submits == CHUNK_PREFETCH_MAX_SUBMITS_PER_UPDATE ||
+                        cmp.prefetches.size() >= CHUNK_PREFETCH_MAX_CHUNKS) return;
+                    i32v3 p = pathChunk + i32v3(x, y, z);
+                    // The sphere loads these itself
+                    if (selfDot(p - cmp.centerPosition) <= radius2) continue;
+
+                    ChunkPosition3D pos;
+                    pos.face = cmp.currentCubeFace;
+                    pos.pos = p;
+                    if (!VoxelSpaceConversions::wrapChunkPosition(pos, cmp.faceChunkRadius)) continue;
+                    ui64 key = ChunkID(pos.pos).id ^ ((ui64)pos.face << 61);
+                    if (!cmp.prefetchKeys.insert(key).second) continue;
+
+                    cmp.prefetches.emplace_back();
+                    ChunkPrefetch& prefetch = cmp.prefetches.back();
+                    prefetch.chunk = cmp.chunkGrids[pos.face].submitLowPriorityQuery(pos.pos, GEN_DONE, true)->chunk.acquire();
+                    prefetch.key = key;
+                    prefetch.expireUpdate = cmp.updateCount + CHUNK_PREFETCH_LIFETIME;
+                    submits++;
                 }
             }
         }
     }
-}
\ No newline at end of file
+}
+
+void ChunkSphereComponentUpdater::releasePrefetches(ChunkSphereComponent& cmp, bool expiredOnly) {
+    for (size_t i = 0; i < cmp.prefetches.size();) {
+        ChunkPrefetch& prefetch = cmp.prefetches[i];
+        if (expiredOnly && prefetch.expireUpdate > cmp.updateCount) {
+            i++;
+            continue;
+        }
+        // If the sphere reached the chunk the grid's interest holds it. If
+        // the prefetch is still waiting it is no longer worth generating.
+        const ChunkPosition3D& pos = prefetch.chunk->getChunkPosition();
+        cmp.chunkGrids[pos.face].cancelLowPriorityQuery(pos.pos);
+        prefetch.chunk.release();
+        cmp.prefetchKeys.erase(prefetch.key);
+        prefetch = std::move(cmp.prefetches.back());
+        cmp.prefetches.pop_back();
+    }
+}
+
+int ChunkSphereComponentUpdater::getSlot(const ChunkSphereComponent& cmp, const i32v3& offset) {
+    // Chunks always map to the same slot, so wrap the offset into the grid
+    i32v3 p;
+    for (int i = 0; i < 3; i++) {
+        p[i] = (cmp.offset[i] + offset[i] + cmp.radius) % cmp.width;
+        if (p[i] < 0) p[i] += cmp.width;
+    }
+    return p.y * cmp.layer + p.z * cmp.width + p.x;
+}
@@ -22,19 +22,46 @@ class GameSystem;
 class SpaceSystem;
 class ChunkAccessor;
 
+// Most new chunks a sphere submits per update while filling, so big
+// jumps load over several frames instead of spiking one
+#define CHUNK_SPHERE_MAX_SUBMITS_PER_UPDATE 128
+// How far ahead in updates the movement path is prefetched
+#define CHUNK_PREFETCH_UPDATES 180
+// Prefetched chunks are released this many updates after being requested
+#define CHUNK_PREFETCH_LIFETIME 360
+// Radius in chunks of the ball prefetched around each point on the path
+#define CHUNK_PREFETCH_RADIUS 2
+#define CHUNK_PREFETCH_MAX_SUBMITS_PER_UPDATE 32
+#define CHUNK_PREFETCH_MAX_CHUNKS 1024
+
 class ChunkSphereComponentUpdater {
 public:
     void update(GameSystem* gameSystem, SpaceSystem* spaceSystem);
 
     void setRadius(ChunkSphereComponent& cmp, ui32 radius);
 
+    /// Releases the sphere's prefetched chunks
+    /// @param expiredOnly: Only release prefetches past their lifetime
+    static void releasePrefetches(ChunkSphereComponent& cmp, bool expiredOnly);
 private:
     void shiftDirection(ChunkSphereComponent& cmp, int axis1, int axis2, int axis3, int offset);
-    // Submits a gen query and connects to neighbors
-    ChunkHandle submitAndConnect(ChunkSphereComponent& cmp, const i32v3& chunkPos);
-    void releaseAndDisconnect(ChunkSphereComponent& cmp, ChunkHandle& h);
-    void releaseHandles(ChunkSphereComponent& cmp);
+    /// Registers interest in the chunk at chunkPos on the sphere's face. The
+    /// grid loads it and connects it to its neighbors on its next update.
+    /// @return false if there is no chunk there, the slot is left inactive
+    bool addInterest(ChunkSphereComponent& cmp, ChunkSphereSlot& slot, const i32v3& chunkPos);
+    void removeInterest(ChunkSphereComponent& cmp, ChunkSphereSlot& slot);
+    void releaseSlots(ChunkSphereComponent& cmp);
     void initSphere(ChunkSphereComponent& cmp);
+    /// Moves the sphere to a new face, keeping every chunk both spheres share
+    void rebaseSphere(ChunkSphereComponent& cmp, const ChunkPosition3D& chunkPos);
+    /// Adds interest in missing chunks nearest first, up to the per update limit
+    void fillSphere(ChunkSphereComponent& cmp);
+    /// Requests chunks along the extrapolated movement path at low priority
+    /// @param direction: Normalized direction to extrapolate along
+    /// @param distance: Distance in voxels to extrapolate
+    void prefetchPath(ChunkSphereComponent& cmp, const f64v3& position, const f64v3& direction, f64 distance, int& submits);
+    /// @return index into slotGrid of the chunk at centerPosition + offset
+    int getSlot(const ChunkSphereComponent& cmp, const i32v3& offset);
 };
 
 #endif // ChunkSphereAcquirer_h__
@@ -9,113 +9,96 @@
 #include "VoxelNavigation.inl"
 #include "VoxelUtils.h"
 
-#include "VoxelUpdateOrder.inl"
 
 BlockPack* ChunkUpdater::blockPack = nullptr;
 
-void ChunkUpdater::randomBlockUpdates(PhysicsEngine* physicsEngine, Chunk* chunk)
-{
-    //if (!chunk->isAccessible) return;
-    //int blockIndex, blockIndex2, blockID;
-    //ChunkStates newState;
-    //bool needsSetup;
-    //Chunk *owner;
-
-    //Chunk* left = chunk->left;
-    //Chunk* right = chunk->right;
-    //Chunk* front = chunk->front;
-    //Chunk* back = chunk->back;
-    //Chunk* bottom = chunk->bottom;
-    //Chunk* top = chunk->top;
-
-    //i32v3 pos;
-
-    //Chunk* lockedChunk = nullptr;
+// Offset to the voxel across each face, ordered like Chunk::neighbors
+const i32v3 FACE_DIRS[6] = {
+    i32v3(-1, 0, 0), i32v3(1, 0, 0),
+    i32v3(0, -1, 0), i32v3(0, 1, 0),
+    i32v3(0, 0, -1), i32v3(0, 0, 1)
+};
+const int SIDE_FACES[4] = { 0, 1, 4, 5 };
+
+void ChunkUpdater::randomBlockUpdates(ChunkHandle& chunk, ChunkHandle neighbors[], std::mt19937& randomEngine) {
+    std::vector<BlockIndex> tickIndices;
+    ui8 faces = 0;
+    {
+        ChunkWriteLock l(chunk->dataMutex);
+        ChunkVoxelSet& tickVoxels = chunk->tickVoxels;
+        if (tickVoxels.empty()) return;
+
+        // Every eligible voxel has the same odds no matter how full the set is
+        f32 expectedTicks = (f32)tickVoxels.size() * RANDOM_TICK_CHANCE;
+        ui32 numTicks = (ui32)expectedTicks;
+        if (std::uniform_real_distribution<f32>(0.0f, 1.0f)(randomEngine) < expectedTicks - (f32)numTicks) numTicks++;
+
+        for (ui32 i = 0; i < numTicks && tickVoxels.size(); i++) {
+            size_t r = std::uniform_int_distribution<size_t>(0, tickVoxels.size() - 1)(randomEngine);
+            ui16 blockIndex = tickVoxels[r];
+            const Block& block = blockPack->operator[](chunk->blocks.get(blockIndex));
+            if (!block.randomTick) {
+                // Block was replaced since it was added
+                tickVoxels.removeAt(r);
+                continue;
+            }
+            tickIndices.push_back(blockIndex);
+            // A tick touches voxels up to two away, plants also read down their stem
+            i32v3 pos = getPosFromBlockIndex((int)blockIndex);
+            if (pos.x <= 1) faces |= 1 << 0;
+            if (pos.x >= CHUNK_WIDTH - 2) faces |= 1 << 1;
+            if (pos.y <= 1 || pos.y < block.floraHeight) faces |= 1 << 2;
+            if (pos.y >= CHUNK_WIDTH - 2) faces |= 1 << 3;
+            if (pos.z <= 1) faces |= 1 << 4;
+            if (pos.z >= CHUNK_WIDTH - 2) faces |= 1 << 5;
+        }
+    }
+    if (tickIndices.empty()) return;
+
+    // Only the neighbors the ticked voxels can reach are locked
+    TickArea area;
+    MultiChunkLock chunkLock;
+    area.slots[0] = chunk;
+    chunkLock.add(chunk, ChunkLockMode::WRITE);
+    for (int i = 0; i < 6; i++) {
+        area.slots[i + 1] = (faces & (1 << i)) ? (Chunk*)neighbors[i] : nullptr;
+        if (area.slots[i + 1]) chunkLock.add(area.slots[i + 1], ChunkLockMode::WRITE);
+    }
+    chunkLock.lock();
+    for (BlockIndex blockIndex : tickIndices) {
+        // The chunk was unlocked in between, so check the block again
+        const Block& block = blockPack->operator[](chunk->blocks.get(blockIndex));
+        if (block.randomTick) randomTickBlock(area, blockIndex, block, randomEngine);
+    }
+    chunkLock.clear();
 
-    //for (int i = 0; i < 15; i++) {
-    //    needsSetup = false;
-
-    //    blockIndex = RandomUpdateOrder[chunk->blockUpdateIndex++];
-    //    if (chunk->blockUpdateIndex == CHUNK_SIZE) chunk->blockUpdateIndex = 0;
-
-    //    pos = getPosFromBlockIndex(blockIndex);
-    //    
-    //    blockID = chunk->getBlockIDSafe(lockedChunk, blockIndex);
-
-    //    if (Blocks[blockID].emitterRandom){
-    //        // uncomment for falling leaves
-    //        //    particleEngine.AddAnimatedParticles(1, f64v3(position.x + x, Y + y, position.z + z), Blocks[b].emitterRandom);
-    //    }
-
-    //    //TODO: Replace most of this with block update scripts
-    //    //TODO(Ben): There are race conditions here!
-    //    if (blockID >= LOWWATER && blockID < LOWWATER + 5 && (GETBLOCKID(vvox::getBottomBlockData(chunk, lockedChunk, blockIndex, pos.y, blockIndex2, owner)) < LOWWATER)) {
-    //        chunk->setBlockDataSafe(lockedChunk, blockIndex, NONE);
-    //        owner->numBlocks--;
-    //        needsSetup = true;
-    //        newState = ChunkStates::WATERMESH;
-    //        ChunkUpdater::addBlockToUpdateList(chunk, lockedChunk, blockIndex);
-    //    } else if (blockID == FIRE) {
-    //        // TODO(Ben): Update
-    //        //updateFireBlock(chunkManager, physicsEngine, chunk, blockIndex);
-    //        needsSetup = true;
-    //        newState = ChunkStates::MESH;
-    //    } else if (blockID == DIRTGRASS){
-    //        ui32 bt = GETBLOCKID(vvox::getTopBlockData(chunk, lockedChunk, blockIndex, pos.y, blockIndex2, owner));
-    //        // Tmp debugging           
-    //        if (bt > Blocks.size()) {
-    //            pError("Invalid block in update!: " + std::to_string(bt));
-    //        }
-    //        if ((Blocks[bt].collide && bt != LEAVES1) || bt >= LOWWATER){
-    //            chunk->setBlockDataSafe(lockedChunk, blockIndex, DIRT);
-    //            needsSetup = true;
-    //            newState = ChunkStates::MESH;
-    //        }
-    //    } else if (blockID == DIRT){
-    //        if ((rand() % 10 == 0) && (GETBLOCKID(vvox::getTopBlockData(chunk, lockedChunk, blockIndex, pos.y, blockIndex2, owner)) == NONE) &&
-    //            (GETBLOCKID(vvox::getLeftBlockData(chunk, lockedChunk, blockIndex, pos.x, blockIndex2, owner)) == DIRTGRASS ||
-    //            GETBLOCKID(vvox::getRightBlockData(chunk, lockedChunk, blockIndex, pos.x, blockIndex2, owner)) == DIRTGRASS ||
-    //            GETBLOCKID(vvox::getFrontBlockData(chunk, lockedChunk, blockIndex, pos.z, blockIndex2, owner)) == DIRTGRASS ||
-    //            GETBLOCKID(vvox::getBackBlockData(chunk, lockedChunk, blockIndex, pos.z, blockIndex2, owner)) == DIRTGRASS)) {
-    //            chunk->setBlockDataSafe(lockedChunk, blockIndex, DIRTGRASS);
-    //            needsSetup = true;
-    //            newState = ChunkStates::MESH;
-    //        }
-    //    }
+    // One DataChange per modified chunk rather than per voxel
+    if ((area.remeshSlots & 1) && chunk->genLevel == GEN_DONE) chunk->DataChange(chunk);
+    for (int i = 0; i < 6; i++) {
+        if ((area.remeshSlots & (2 << i)) && neighbors[i]->genLevel == GEN_DONE) {
+            neighbors[i]->DataChange(neighbors[i]);
+        }
+    }
+}
 
-    //    if (needsSetup){
-    //        
-    //        chunk->changeState(newState);
-    //        if (pos.x == 0){
-    //            if (left && left->isAccessible){
-    //                left->changeState(newState);
-    //            }
-    //        } else if (pos.x == CHUNK_WIDTH - 1){
-    //            if (right && right->isAccessible){
-    //                right->changeState(newState);
-    //            }
-    //        }
-    //        if (pos.y == 0){
-    //            if (bottom && bottom->isAccessible){
-    //                bottom->changeState(newState);
-    //            }
-    //        } else if (pos.y == CHUNK_WIDTH - 1){
-    //            if (top && top->isAccessible){
-    //                top->changeState(newState);
-    //            }
-    //        }
-    //        if (pos.z == 0){
-    //            if (back && back->isAccessible){
-    //                back->changeState(newState);
-    //            }
-    //        } else if (pos.z == CHUNK_WIDTH - 1){
-    //            if (front && front->isAccessible){
-    //                front->changeState(newState);
-    //            }
-    //        }
-    //    }
-    //}
-    //if (lockedChunk) lockedChunk->unlock();
+void ChunkUpdater::initTickVoxels(Chunk* chunk) {
+    chunk->tickVoxels.clear();
+    if (!blockPack) return;
+    if (chunk->blocks.getState() == vvox::VoxelStorageState::INTERVAL_TREE) {
+        // Only look up each run's block once
+        auto& dataTree = chunk->blocks.getTree();
+        for (size_t i = 0; i < dataTree.size(); i++) {
+            if (!blockPack->operator[](dataTree[i].data).randomTick) continue;
+            for (size_t j = 0; j < dataTree[i].length; j++) {
+                chunk->tickVoxels.insert((ui16)(dataTree[i].getStart() + j));
+            }
+        }
+    } else {
+        const ui16* blockIDs = chunk->blocks.getDataArray();
+        for (int i = 0; i < CHUNK_SIZE; i++) {
+            if (blockPack->operator[](blockIDs[i]).randomTick) chunk->tickVoxels.insert((ui16)i);
+        }
+    }
 }
 
 void ChunkUpdater::placeBlockSafe(Chunk* chunk, Chunk*& lockedChunk, BlockIndex blockIndex, BlockID blockData) {
@@ -125,8 +108,14 @@ void ChunkUpdater::placeBlockSafe(Chunk* chunk, Chunk*& lockedChunk, BlockIndex
 
 void ChunkUpdater::placeBlockNoUpdate(Chunk* chunk, BlockIndex blockIndex, BlockID blockType) {
  
-    chunk->blocks.set(blockIndex, blockType);
+    chunk->setBlock(blockIndex, blockType);
+    setCollidable(chunk, blockIndex, blockType);
     chunk->flagDirty();
+    if (blockPack) VoxelLightEngine::updateSunHeight(chunk, blockIndex, blockPack);
+    VoxelLightEngine::postMessage(chunk, LightMessage(LightMessageType::BLOCK_CHANGE, blockIndex, 0));
+    // Liquids next to the change may be able to flow now
+    CAEngine::activateVoxelAndNeighbors(chunk, blockIndex, blockPack);
+    addTickVoxel(chunk, blockIndex, blockType);
 
     //Block &block = GETBLOCK(blockType);
 
@@ -576,8 +565,140 @@ void ChunkUpdater::snowAddBlockToUpdateList(Chunk* chunk, int c)
     //}
 }
 
+const Block* ChunkUpdater::TickArea::getBlock(const i32v3& pos) const {
+    BlockIndex blockIndex;
+    int slot = find(pos, blockIndex);
+    if (slot < 0) return nullptr;
+    return &blockPack->operator[](slots[slot]->blocks.get(blockIndex));
+}
+
+void ChunkUpdater::TickArea::setBlock(const i32v3& pos, BlockID blockID) {
+    BlockIndex blockIndex;
+    int slot = find(pos, blockIndex);
+    if (slot < 0) return;
+    placeBlockNoUpdate(slots[slot], blockIndex, blockID);
+    remeshSlots |= 1 << slot;
+    // Chunks cull their faces against their neighbors, so those remesh too
+    for (int face = 0; face < 6; face++) {
+        if (!isBlockIndexOnFace(blockIndex, face)) continue;
+        if (slot == 0) {
+            remeshSlots |= 2 << face;
+        } else if ((face ^ 1) == slot - 1) {
+            remeshSlots |= 1;
+        }
+    }
+}
+
+int ChunkUpdater::TickArea::find(const i32v3& pos, OUT BlockIndex& blockIndex) const {
+    i32v3 p = pos;
+    int slot = 0;
+    for (int axis = 0; axis < 3; axis++) {
+        int face;
+        if (p[axis] < 0) {
+            face = axis * 2;
+            p[axis] += CHUNK_WIDTH;
+        } else if (p[axis] >= CHUNK_WIDTH) {
+            face = axis * 2 + 1;
+            p[axis] -= CHUNK_WIDTH;
+        } else {
+            continue;
+        }
+        // Diagonal chunks and anything past a neighbor are never locked
+        if (slot || p[axis] < 0 || p[axis] >= CHUNK_WIDTH) return -1;
+        slot = face + 1;
+    }
+    if (!slots[slot]) return -1;
+    blockIndex = (BlockIndex)getBlockIndexFromPos(p);
+    return slot;
+}
+
+void ChunkUpdater::randomTickBlock(TickArea& area, BlockIndex blockIndex, const Block& block, std::mt19937& randomEngine) {
+    std::uniform_real_distribution<f32> chance(0.0f, 1.0f);
+    const i32v3 pos = getPosFromBlockIndex((int)blockIndex);
+    const i32v3 up = pos + FACE_DIRS[3];
+    const Block* above = area.getBlock(up);
+
+    // Smothered by something opaque on top, like grass turning to dirt
+    if (block.coveredTransform && above && !above->allowLight) {
+        area.setBlock(pos, block.coveredTransform);
+        return;
+    }
+
+    // Spread onto a random side neighbor, one step up or down at most
+    if (block.spreadTarget) {
+        const i32v3& side = FACE_DIRS[SIDE_FACES[std::uniform_int_distribution<int>(0, 3)(randomEngine)]];
+        i32v3 target = pos + side;
+        target.y += std::uniform_int_distribution<int>(-1, 1)(randomEngine);
+        const Block* targetBlock = area.getBlock(target);
+        const Block* targetAbove = area.getBlock(target + FACE_DIRS[3]);
+        if (targetBlock && targetBlock->ID == block.spreadTarget && targetAbove && targetAbove->allowLight) {
+            area.setBlock(target, block.ID);
+            return;
+        }
+    }
+
+    // Fire eats into a random neighbor, catches onto open voxels next to
+    // fuel, and goes out once nothing around it can burn
+    if (block.isFire) {
+        i32v3 target = pos + FACE_DIRS[std::uniform_int_distribution<int>(0, 5)(randomEngine)];
+        const Block* targetBlock = area.getBlock(target);
+        if (targetBlock) {
+            if (targetBlock->flammability > 0.0f) {
+                if (chance(randomEngine) < targetBlock->flammability) {
+                    area.setBlock(target, targetBlock->burnTransform ? targetBlock->burnTransform : block.ID);
+                    return;
+                }
+            } else if (targetBlock->ID == 0 || targetBlock->waterBreak) {
+                if (chance(randomEngine) < getBurnChance(area, target)) {
+                    area.setBlock(target, block.ID);
+                    return;
+                }
+            }
+        }
+        if (getBurnChance(area, pos) == 0.0f) area.setBlock(pos, block.burnTransform);
+        return;
+    }
+
+    const Chunk* chunk = area.slots[0];
+    const PlanetHeightData& heightData = chunk->gridData->heightData[pos.z * CHUNK_WIDTH + pos.x];
+
+    // Snow settles on cold ground open to the sky and melts when it warms up
+    if (block.isSnowCover && heightData.temperature > SNOW_MAX_TEMPERATURE) {
+        area.setBlock(pos, 0);
+        return;
+    }
+    if (block.snowCover && above && above->ID == 0 && heightData.temperature <= SNOW_MAX_TEMPERATURE &&
+        chunk->gridData->isSkyExposed(pos.z * CHUNK_WIDTH + pos.x, chunk->getVoxelPosition().pos.y + up.y)) {
+        area.setBlock(up, block.snowCover);
+        return;
+    }
+
+    // Plants grow a voxel at a time until their stem is floraHeight tall
+    if (block.floraHeight > 1 && above && above->ID == 0) {
+        const Block* below = nullptr;
+        int height = 1;
+        while (height < block.floraHeight) {
+            below = area.getBlock(pos - i32v3(0, height, 0));
+            if (!below || below->ID != block.ID) break;
+            height++;
+        }
+        // Don't grow past a stem we can't see the bottom of
+        if (height < block.floraHeight && below) area.setBlock(up, block.ID);
+    }
+}
+
+f32 ChunkUpdater::getBurnChance(const TickArea& area, const i32v3& pos) {
+    f32 flammability = 0.0f;
+    for (int face = 0; face < 6; face++) {
+        const Block* neighbor = area.getBlock(pos + FACE_DIRS[face]);
+        if (neighbor) flammability += neighbor->flammability;
+    }
+    return flammability / 6.0f;
+}
+
 //TODO: Replace this with simple emitterOnBreak
 //This function name is misleading, ignore for now
+
 void ChunkUpdater::breakBlock(Chunk* chunk, int x, int y, int z, int blockType, double force, f32v3 extraForce)
 {
 //    f32v4 color;
@@ -1,4 +1,6 @@
 #pragma once
+#include <random>
+
 #include "Constants.h"
 
 // TODO(Ben): Temporary
@@ -7,6 +9,11 @@
 
 #include "VoxelUpdateBufferer.h"
 
+// Chance per random tick pass that a tick eligible voxel gets a random tick
+#define RANDOM_TICK_CHANCE 0.008f
+// Snow covers settle at or below this column temperature and melt above it
+#define SNOW_MAX_TEMPERATURE 64
+
 class PhysicsEngine;
 class ChunkManager;
 class BlockPack;
@@ -14,7 +21,27 @@ enum class ChunkStates;
 
 class ChunkUpdater {
 public:
-    static void randomBlockUpdates(PhysicsEngine* physicsEngine, Chunk* chunk);
+    /// Ticks random voxels from the chunk's tickVoxels set, so the cost
+    /// scales with the number of eligible voxels rather than the volume.
+    /// Ticks may change voxels up to two away, so the chunk is locked
+    /// along with whichever face neighbors the ticked voxels can reach.
+    /// @param neighbors: Acquired face neighbors in Chunk::neighbors order
+    /// @param randomEngine: Owned by the calling thread
+    static void randomBlockUpdates(ChunkHandle& chunk, ChunkHandle neighbors[], std::mt19937& randomEngine);
+    /// Rebuilds tickVoxels from the block data. Chunk must be locked.
+    static void initTickVoxels(Chunk* chunk);
+    /// Adds the voxel to tickVoxels if blockID gets random ticks. Chunk must be locked.
+    static void addTickVoxel(Chunk* chunk, BlockIndex blockIndex, BlockID blockID) {
+        if (blockPack && blockPack->operator[](blockID).randomTick) chunk->tickVoxels.insert(blockIndex);
+    }
+    /// Rebuilds the collidable mask from the block data. Chunk must be locked.
+    static void initCollidable(Chunk* chunk) {
+        if (blockPack) chunk->collidable.init(chunk->blocks, *blockPack);
+    }
+    /// Updates the collidable mask after blockID was written. Chunk must be locked.
+    static void setCollidable(Chunk* chunk, BlockIndex blockIndex, BlockID blockID) {
+        if (blockPack) chunk->collidable.set(blockIndex, blockPack->operator[](blockID).collide);
+    }
     static void placeBlock(VoxelUpdateBufferer& bufferer, Chunk* chunk, Chunk*& lockedChunk, BlockIndex blockIndex, BlockID blockData) {
         updateBlockAndNeighbors(bufferer, chunk, blockIndex, blockData);
         //addBlockToUpdateList(chunk, lockedChunk, blockIndex);
@@ -39,7 +66,26 @@ class ChunkUpdater {
 
     static BlockPack* blockPack;
 private:
+    /// The ticked chunk and the face neighbors locked along with it
+    struct TickArea {
+        Chunk* slots[7]; ///< The chunk, then neighbors in Chunk::neighbors order. nullptr if not locked.
+        ui8 remeshSlots = 0; ///< Slots to remesh once unlocked
+        /// @param pos: Relative to the chunk, may lie past one of its faces
+        /// @return nullptr if pos is in a chunk that isn't locked
+        const Block* getBlock(const i32v3& pos) const;
+        /// Places blockID at pos if its chunk is locked
+        void setBlock(const i32v3& pos, BlockID blockID);
+    private:
+        /// @return slot holding pos, or -1 if it isn't locked
+        int find(const i32v3& pos, OUT BlockIndex& blockIndex) const;
+    };
+
     //TODO: Replace with emitterOnBreak
+    /// Applies the block's random tick behavior
+    static void randomTickBlock(TickArea& area, BlockIndex blockIndex, const Block& block, std::mt19937& randomEngine);
+    /// Average flammability of the voxels next to pos, unlocked ones count as 0
+    static f32 getBurnChance(const TickArea& area, const i32v3& pos);
+
     static void breakBlock(Chunk* chunk, int x, int y, int z, int blockType, double force = 0.0f, f32v3 extraForce = f32v3(0.0f));
 
     static void placeFlora(Chunk* chunk, int blockIndex, int blockID);
@@ -0,0 +1,74 @@
+///
+/// ChunkVoxelSet.h
+/// Seed of Andromeda
+///
+/// Copyright 2014 Regrowth Studios
+/// All Rights Reserved
+///
+/// Summary:
+/// Sparse set of voxel indices within a single chunk.
+///
+
+#pragma once
+
+#ifndef ChunkVoxelSet_h__
+#define ChunkVoxelSet_h__
+
+#include "Constants.h"
+
+/// Unordered set of block indices. Insert and lookup are O(1) and
+/// iteration only touches members. Not thread safe, owners guard it
+/// with the chunk's dataMutex.
+class ChunkVoxelSet {
+public:
+    /// @return false if the index was already a member
+    bool insert(ui16 blockIndex) {
+        // Membership bits are only allocated once something is added
+        if (m_bits.empty()) m_bits.resize(CHUNK_SIZE / 64, 0);
+        ui64& word = m_bits[blockIndex >> 6];
+        ui64 bit = 1ull << (blockIndex & 63);
+        if (word & bit) return false;
+        word |= bit;
+        m_indices.push_back(blockIndex);
+        return true;
+    }
+    bool contains(ui16 blockIndex) const {
+        if (m_bits.empty()) return false;
+        return (m_bits[blockIndex >> 6] & (1ull << (blockIndex & 63))) != 0;
+    }
+    /// Removes the i-th member by swapping in the last one
+    void removeAt(size_t i) {
+        ui16 blockIndex = m_indices[i];
+        m_bits[blockIndex >> 6] &= ~(1ull << (blockIndex & 63));
+        m_indices[i] = m_indices.back();
+        m_indices.pop_back();
+    }
+    /// Empties the set into out, which is cleared first
+    void swapOut(std::vector<ui16>& out) {
+        out.clear();
+        out.swap(m_indices);
+        for (ui16 blockIndex : out) {
+            m_bits[blockIndex >> 6] &= ~(1ull << (blockIndex & 63));
+        }
+    }
+    void clear() {
+        for (ui16 blockIndex : m_indices) {
+            m_bits[blockIndex >> 6] &= ~(1ull << (blockIndex & 63));
+        }
+        m_indices.clear();
+    }
+    /// Clears and frees all memory
+    void dispose() {
+        std::vector<ui16>().swap(m_indices);
+        std::vector<ui64>().swap(m_bits);
+    }
+
+    size_t size() const { return m_indices.size(); }
+    bool empty() const { return m_indices.empty(); }
+    ui16 operator[](size_t i) const { return m_indices[i]; }
+private:
+    std::vector<ui16> m_indices;
+    std::vector<ui64> m_bits; ///< One bit per voxel
+};
+
+#endif // ChunkVoxelSet_h__
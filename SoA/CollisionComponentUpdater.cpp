@@ -4,7 +4,16 @@
 #include "GameSystem.h"
 
 void CollisionComponentUpdater::update(GameSystem* gameSystem) {
+    // Move every collidable entity in voxel space. Entities that left
+    // voxel space or lost their component are dropped by removeStale.
     for (auto& it : gameSystem->aabbCollidable) {
-        //TODO(Ben): this
+        auto& cmp = it.second;
+        auto& physics = gameSystem->physics.get(cmp.physics);
+        if (physics.voxelPosition == 0) continue;
+        auto& position = gameSystem->voxelPosition.get(physics.voxelPosition);
+        if (position.parentVoxel == 0) continue;
+        m_spatialHash.update(it.first, position.parentVoxel, position.gridPosition.face,
+                             position.gridPosition.pos + f64v3(cmp.offset), f64v3(cmp.box) * 0.5);
     }
-}
\ No newline at end of file
+    m_spatialHash.removeStale();
+}
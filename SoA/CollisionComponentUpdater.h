@@ -15,6 +15,8 @@
 #ifndef CollisionComponentUpdater_h__
 #define CollisionComponentUpdater_h__
 
+#include "EntitySpatialHash.h"
+
 class GameSystem;
 
 class CollisionComponentUpdater {
@@ -22,6 +24,14 @@ class CollisionComponentUpdater {
     /// Updates collision components
     /// @param gameSystem: Game ECS
     void update(GameSystem* gameSystem);
+
+    /// Broadphase of all collidable entities in voxel space
+    const EntitySpatialHash& getSpatialHash() const { return m_spatialHash; }
+    /// Finds entities whose boxes overlapped as of the last update. Pairs
+    /// are only built when asked for, nothing pays for them otherwise.
+    void queryOverlappingPairs(std::vector<EntityPair>& pairs) const { m_spatialHash.queryPairs(pairs); }
+private:
+    EntitySpatialHash m_spatialHash;
 };
 
 #endif // CollisionComponentUpdater_h__
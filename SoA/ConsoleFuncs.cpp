@@ -103,5 +103,9 @@ void registerFuncs(vscript::Environment& env) {
     env.setNamespaces("CHS");
     env.addCDelegate("run", makeDelegate(runCHS));
 
+    env.setNamespaces("CMBA");
+    env.addCRDelegate("test", makeRDelegate(testCMBA));
+    env.addCDelegate("run", makeDelegate(runCMBA));
+
     env.setNamespaces();
 }
@@ -3,6 +3,7 @@
 
 #include "ChunkAllocator.h"
 #include "ChunkAccessor.h"
+#include "ChunkMeshBufferAllocator.h"
 
 #include <random>
 #include <Vorb/Timing.h>
@@ -102,3 +103,205 @@ void runCHS() {
     h2.release();
     h1.release();
 }
+
+// Checks that live ranges don't overlap and that the used size adds up
+static bool checkCMBA(const ChunkMeshBufferAllocator& allocator, const std::vector<MeshBufferAllocation>& allocations) {
+    for (ui32 p = 0; p < allocator.getNumPages(); p++) {
+        std::vector<const MeshBufferAllocation*> live;
+        ui32 used = 0;
+        for (auto& a : allocations) {
+            if (a.isValid() && a.page == p) {
+                live.push_back(&a);
+                used += a.size;
+            }
+        }
+        if (used != allocator.getUsedSize(p)) return false;
+        std::sort(live.begin(), live.end(), [](const MeshBufferAllocation* a, const MeshBufferAllocation* b) {
+            return a->offset < b->offset;
+        });
+        for (size_t i = 0; i < live.size(); i++) {
+            if (live[i]->offset + live[i]->size > allocator.getPageSize()) return false;
+            if (i && live[i - 1]->offset + live[i - 1]->size > live[i]->offset) return false;
+        }
+    }
+    return true;
+}
+
+#define CMBA_CHECK(cond) if (!(cond)) { printf("CMBA check failed on line %d: %s\n", __LINE__, #cond); passed = false; }
+
+bool testCMBA() {
+    const ui32 PAGE_SIZE = 4096;
+    bool passed = true;
+
+    ChunkMeshBufferAllocator allocator;
+    allocator.init(PAGE_SIZE);
+    // Allocations must not move while allocated
+    std::vector<MeshBufferAllocation> allocations(32);
+    // CPU mirror of the page memory, each unit tagged with its owner
+    std::vector<std::vector<ui32> > memory;
+    auto write = [&](ui32 index) {
+        MeshBufferAllocation& a = allocations[index];
+        while (memory.size() < allocator.getNumPages()) memory.emplace_back(PAGE_SIZE, UINT_MAX);
+        for (ui32 i = 0; i < a.size; i++) memory[a.page][a.offset + i] = index;
+    };
+    auto verify = [&]() {
+        for (ui32 index = 0; index < allocations.size(); index++) {
+            MeshBufferAllocation& a = allocations[index];
+            if (!a.isValid()) continue;
+            for (ui32 i = 0; i < a.size; i++) {
+                if (memory[a.page][a.offset + i] != index) return false;
+            }
+        }
+        return true;
+    };
+
+    { // Rejected sizes
+        CMBA_CHECK(!allocator.alloc(allocations[0], 0));
+        CMBA_CHECK(!allocator.alloc(allocations[0], PAGE_SIZE + 1));
+        CMBA_CHECK(!allocations[0].isValid());
+        CMBA_CHECK(allocator.getNumPages() == 0);
+    }
+
+    { // First fit packs from the front
+        for (ui32 i = 0; i < 16; i++) {
+            CMBA_CHECK(allocator.alloc(allocations[i], 256));
+            CMBA_CHECK(allocations[i].page == 0 && allocations[i].offset == i * 256);
+            write(i);
+        }
+        CMBA_CHECK(allocator.getNumPages() == 1);
+        CMBA_CHECK(allocator.getFreeSize(0) == 0);
+        CMBA_CHECK(allocator.getFragmentation(0) == 0.0f);
+    }
+
+    { // Freeing coalesces with the free neighbors on either side
+        allocator.free(allocations[1]);
+        CMBA_CHECK(!allocations[1].isValid());
+        allocator.free(allocations[3]);
+        CMBA_CHECK(allocator.getLargestFreeBlock(0) == 256);
+        CMBA_CHECK(allocator.getFragmentation(0) == 0.5f);
+        allocator.free(allocations[2]); // Both sides
+        CMBA_CHECK(allocator.getLargestFreeBlock(0) == 768);
+        allocator.free(allocations[4]); // Left side
+        CMBA_CHECK(allocator.getLargestFreeBlock(0) == 1024);
+        allocator.free(allocations[0]); // Right side
+        CMBA_CHECK(allocator.getLargestFreeBlock(0) == 1280);
+        CMBA_CHECK(allocator.getFragmentation(0) == 0.0f);
+        CMBA_CHECK(checkCMBA(allocator, allocations));
+    }
+
+    { // Holes are reused before a new page is added
+        CMBA_CHECK(allocator.alloc(allocations[16], 512));
+        CMBA_CHECK(allocations[16].page == 0 && allocations[16].offset == 0);
+        write(16);
+        CMBA_CHECK(allocator.alloc(allocations[17], 1024));
+        CMBA_CHECK(allocations[17].page == 1 && allocations[17].offset == 0);
+        write(17);
+        CMBA_CHECK(allocator.getNumPages() == 2);
+        // Reallocating frees the old range first, then fits the hole left in page 0
+        CMBA_CHECK(allocator.alloc(allocations[17], 128));
+        CMBA_CHECK(allocations[17].page == 0 && allocations[17].offset == 512);
+        CMBA_CHECK(allocator.getUsedSize(1) == 0);
+        write(17);
+        CMBA_CHECK(checkCMBA(allocator, allocations));
+    }
+
+    { // Compaction slides live ranges to the front and keeps their data
+        for (ui32 i = 6; i < 16; i += 2) allocator.free(allocations[i]);
+        CMBA_CHECK(allocator.getFragmentation(0) > 0.0f);
+        std::vector<MeshBufferMove> moves;
+        allocator.compact(0, moves);
+        CMBA_CHECK(moves.size() > 0);
+        for (auto& m : moves) {
+            CMBA_CHECK(m.page == 0 && m.dstOffset < m.srcOffset);
+            // Moves can overlap their own source, so copy like the GPU path does
+            ui32 step = m.srcOffset - m.dstOffset;
+            for (ui32 copied = 0; copied < m.size; copied += step) {
+                ui32 size = vmath::min(step, m.size - copied);
+                memcpy(&memory[0][m.dstOffset + copied], &memory[0][m.srcOffset + copied], size * sizeof(ui32));
+            }
+        }
+        CMBA_CHECK(allocator.getFragmentation(0) == 0.0f);
+        CMBA_CHECK(allocator.getLargestFreeBlock(0) == allocator.getFreeSize(0));
+        CMBA_CHECK(verify());
+        CMBA_CHECK(checkCMBA(allocator, allocations));
+        // A compact page has nothing to move
+        moves.clear();
+        allocator.compact(0, moves);
+        CMBA_CHECK(moves.empty());
+    }
+
+    { // Dispose invalidates every owner
+        allocator.dispose();
+        CMBA_CHECK(allocator.getNumPages() == 0);
+        for (auto& a : allocations) CMBA_CHECK(!a.isValid());
+    }
+
+    printf("CMBA test %s\n", passed ? "PASSED" : "FAILED");
+    fflush(stdout);
+    return passed;
+}
+
+void runCMBA(size_t numOps) {
+    const ui32 PAGE_SIZE = 4096;
+    const ui32 MAX_ALLOC = 512;
+    bool passed = true;
+
+    ChunkMeshBufferAllocator allocator;
+    allocator.init(PAGE_SIZE);
+    std::vector<MeshBufferAllocation> allocations(256);
+    std::vector<std::vector<ui32> > memory;
+    auto write = [&](ui32 index) {
+        MeshBufferAllocation& a = allocations[index];
+        while (memory.size() < allocator.getNumPages()) memory.emplace_back(PAGE_SIZE, UINT_MAX);
+        for (ui32 i = 0; i < a.size; i++) memory[a.page][a.offset + i] = index;
+    };
+
+    std::mt19937 rEngine(1337);
+    std::uniform_int_distribution<ui32> slot(0, allocations.size() - 1);
+    std::uniform_int_distribution<ui32> size(1, MAX_ALLOC);
+    std::vector<MeshBufferMove> moves;
+    PreciseTimer timer;
+    timer.start();
+    for (size_t i = 0; i < numOps && passed; i++) {
+        ui32 index = slot(rEngine);
+        if (allocations[index].isValid()) {
+            allocator.free(allocations[index]);
+        } else {
+            allocator.alloc(allocations[index], size(rEngine));
+            write(index);
+        }
+        // Compact the worst pages now and then
+        if (i % 64 == 0) {
+            for (ui32 p = 0; p < allocator.getNumPages(); p++) {
+                if (allocator.getFragmentation(p) < 0.5f) continue;
+                moves.clear();
+                allocator.compact(p, moves);
+                for (auto& m : moves) {
+                    memmove(&memory[m.page][m.dstOffset], &memory[m.page][m.srcOffset], m.size * sizeof(ui32));
+                }
+            }
+        }
+        if (!checkCMBA(allocator, allocations)) passed = false;
+    }
+    f64 ms = timer.stop();
+    for (ui32 index = 0; index < allocations.size() && passed; index++) {
+        MeshBufferAllocation& a = allocations[index];
+        if (!a.isValid()) continue;
+        for (ui32 i = 0; i < a.size; i++) {
+            if (memory[a.page][a.offset + i] != index) passed = false;
+        }
+    }
+
+    ui32 used = 0;
+    f32 fragmentation = 0.0f;
+    for (ui32 p = 0; p < allocator.getNumPages(); p++) {
+        used += allocator.getUsedSize(p);
+        fragmentation += allocator.getFragmentation(p);
+    }
+    printf("CMBA churn: %d ops in %lf ms, %d pages, %f utilization, %f avg fragmentation\n", (int)numOps, ms,
+           allocator.getNumPages(), (f32)used / (f32)(allocator.getNumPages() * PAGE_SIZE), fragmentation / allocator.getNumPages());
+
+    allocator.dispose();
+    printf("CMBA churn %s\n", passed ? "PASSED" : "FAILED");
+    fflush(stdout);
+}
@@ -27,4 +27,12 @@ void freeCAS(ChunkAccessSpeedData* data);
 
 void runCHS();
 
+/************************************************************************/
+/* Chunk Mesh Buffer Allocator                                          */
+/************************************************************************/
+/// Checks alloc, free, coalescing and compaction against known layouts
+bool testCMBA();
+/// Random alloc and free churn with periodic compaction
+void runCMBA(size_t numOps);
+
 #endif // !ConsoleTests_h__
@@ -44,15 +44,17 @@ void CutoutVoxelRenderStage::render(const Camera* camera) {
     {
         std::lock_guard<std::mutex> l(cmm->lckActiveChunkMeshes);
         if (chunkMeshes.empty()) return;
+        m_drawList.clear();
         for (int i = chunkMeshes.size() - 1; i >= 0; i--) {
             cm = chunkMeshes[i];
 
             if (cm->inFrustum) {
-                m_renderer->drawCutout(cm, position,
-                                       m_gameRenderParams->chunkCamera->getViewProjectionMatrix());
+                m_drawList.addRange(cm, cm->cutoutAlloc, 0, cm->renderData.cutoutVboSize);
             }
         }
     }
+    m_renderer->drawCutout(m_drawList, cmm->getBufferPool(), position,
+                           m_gameRenderParams->chunkCamera->getViewProjectionMatrix());
     glEnable(GL_CULL_FACE);
     
     m_renderer->end();
@@ -18,11 +18,11 @@
 #define CutoutVoxelRenderStage_h__
 
 #include "IRenderStage.h"
+#include "ChunkRenderer.h"
 
 #include <Vorb/graphics/GLProgram.h>
 
 class Camera;
-class ChunkRenderer;
 class GameRenderParams;
 class MeshManager;
 
@@ -35,6 +35,7 @@ class CutoutVoxelRenderStage : public IRenderStage {
 private:
     ChunkRenderer* m_renderer;
     const GameRenderParams* m_gameRenderParams; ///< Handle to some shared parameters
+    ChunkDrawList m_drawList; ///< Rebuilt every frame from visible meshes
 };
 
 #endif // CutoutVoxelRenderStage_h__
\ No newline at end of file
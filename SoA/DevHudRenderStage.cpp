@@ -6,6 +6,7 @@
 #include <Vorb/graphics/SpriteFont.h>
 
 #include "App.h"
+#include "ChunkMeshManager.h"
 
 DevHudRenderStage::DevHudRenderStage() {
     // Empty
@@ -17,16 +18,23 @@ DevHudRenderStage::~DevHudRenderStage() {
 }
 
 void DevHudRenderStage::hook(const cString fontPath, i32 fontSize,
-          const App* app, const f32v2& windowDims) {
+          const App* app, const f32v2& windowDims,
+          const ChunkMeshManager* chunkMeshManager /*= nullptr*/) {
+    // Hooked again every time gameplay is entered
+    delete _spriteBatch;
+    delete _spriteFont;
     _spriteBatch = new vg::SpriteBatch(true, true);
     _spriteFont = new vg::SpriteFont();
     _app = app;
+    _chunkMeshManager = chunkMeshManager;
     _windowDims = windowDims;
     _spriteFont->init(fontPath, fontSize);
     _fontHeight = _spriteFont->getFontHeight();
 }
 
 void DevHudRenderStage::render(const Camera* camera) {
+    if (_mode == DevUiModes::NONE) return;
+
     // Reset the yOffset
     _yOffset = 0;
 
@@ -52,6 +60,11 @@ void DevHudRenderStage::render(const Camera* camera) {
         drawPosition();
     }
 
+    // Allocation counters
+    if (_mode >= DevUiModes::MESH_STATS) {
+        drawMeshStats();
+    }
+
     _spriteBatch->end();
     // Render to the screen
     _spriteBatch->render(_windowDims);
@@ -200,3 +213,34 @@ void DevHudRenderStage::drawPosition() {
                              color::White);
     _yOffset += _fontHeight;*/
 }
+
+void DevHudRenderStage::drawMeshStats() {
+    if (!_chunkMeshManager) return;
+    const f32v2 NUMBER_SCALE(0.75f);
+    char buffer[256];
+    ChunkMeshAllocStats stats = _chunkMeshManager->getAllocStats();
+
+    _yOffset += _fontHeight;
+    _spriteBatch->drawString(_spriteFont,
+                             "Chunk Mesh Pools",
+                             f32v2(0.0f, _yOffset),
+                             f32v2(1.0f),
+                             color::White);
+    _yOffset += _fontHeight;
+
+    std::sprintf(buffer, "Data: %u new %u reused", stats.meshDataAllocs, stats.meshDataReuses);
+    _spriteBatch->drawString(_spriteFont,
+                             buffer,
+                             f32v2(0.0f, _yOffset),
+                             NUMBER_SCALE,
+                             color::White);
+    _yOffset += _fontHeight;
+
+    std::sprintf(buffer, "Tasks: %u new %u reused", stats.meshTaskAllocs, stats.meshTaskReuses);
+    _spriteBatch->drawString(_spriteFont,
+                             buffer,
+                             f32v2(0.0f, _yOffset),
+                             NUMBER_SCALE,
+                             color::White);
+    _yOffset += _fontHeight;
+}
@@ -22,6 +22,7 @@ DECL_VG(class SpriteBatch;
         class SpriteFont)
 
 class App;
+class ChunkMeshManager;
 
 class DevHudRenderStage : public IRenderStage{
 public:
@@ -29,7 +30,8 @@ class DevHudRenderStage : public IRenderStage{
     ~DevHudRenderStage();
 
     void hook(const cString fontPath, i32 fontSize,
-              const App* app, const f32v2& windowDims);
+              const App* app, const f32v2& windowDims,
+              const ChunkMeshManager* chunkMeshManager = nullptr);
 
     /// Draws the render stage
     virtual void render(const Camera* camera) override;
@@ -45,7 +47,8 @@ class DevHudRenderStage : public IRenderStage{
         HANDS = 2,
         FPS = 3,
         POSITION = 4,
-        LAST = POSITION // Make sure LAST is always last
+        MESH_STATS = 5,
+        LAST = MESH_STATS // Make sure LAST is always last
     };
 
 private:
@@ -53,12 +56,14 @@ class DevHudRenderStage : public IRenderStage{
     void drawHands();
     void drawFps();
     void drawPosition();
+    void drawMeshStats();
 
     vg::SpriteBatch* _spriteBatch = nullptr; ///< For rendering 2D sprites
     vg::SpriteFont* _spriteFont = nullptr; ///< Font used by spritebatch
-    DevUiModes _mode = DevUiModes::HANDS; ///< The mode for rendering
+    DevUiModes _mode = DevUiModes::NONE; ///< The mode for rendering, cycled with INPUT_HUD
     f32v2 _windowDims; ///< Dimensions of the window
     const App* _app = nullptr; ///< Handle to the app
+    const ChunkMeshManager* _chunkMeshManager = nullptr; ///< For mesh allocation counters
     int _fontHeight; ///< Height of the spriteFont
     int _yOffset; ///< Y offset accumulator
 };
@@ -0,0 +1,120 @@
+#include "stdafx.h"
+#include "EntitySpatialHash.h"
+
+void EntitySpatialHash::update(vecs::EntityID entity, vecs::ComponentID planet, WorldCubeFace face,
+                               const f64v3& center, const f64v3& halfExtents) {
+    ui64 key = getKey(face, getCell(center));
+    auto it = m_entries.find(entity);
+    if (it == m_entries.end()) {
+        it = m_entries.emplace(entity, Entry()).first;
+        m_cells[key].push_back(entity);
+    } else if (it->second.key != key) {
+        // Only move buckets when the entity changes cells
+        removeFromCell(it->second.key, entity);
+        m_cells[key].push_back(entity);
+    }
+    Entry& entry = it->second;
+    entry.key = key;
+    entry.planet = planet;
+    entry.min = center - halfExtents;
+    entry.max = center + halfExtents;
+    entry.stamp = m_stamp;
+    m_maxHalfExtents = vmath::max(m_maxHalfExtents, halfExtents);
+}
+
+void EntitySpatialHash::remove(vecs::EntityID entity) {
+    auto it = m_entries.find(entity);
+    if (it == m_entries.end()) return;
+    removeFromCell(it->second.key, entity);
+    m_entries.erase(it);
+}
+
+void EntitySpatialHash::removeStale() {
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        if (it->second.stamp != m_stamp) {
+            removeFromCell(it->second.key, it->first);
+            it = m_entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    m_stamp++;
+}
+
+void EntitySpatialHash::clear() {
+    m_cells.clear();
+    m_entries.clear();
+    m_maxHalfExtents = f64v3(0.0);
+}
+
+template<typename F>
+void EntitySpatialHash::forEachInCells(WorldCubeFace face, const i32v3& minCell, const i32v3& maxCell, F f) const {
+    for (i32 y = minCell.y; y <= maxCell.y; y++) {
+        for (i32 z = minCell.z; z <= maxCell.z; z++) {
+            for (i32 x = minCell.x; x <= maxCell.x; x++) {
+                auto it = m_cells.find(getKey(face, i32v3(x, y, z)));
+                if (it == m_cells.end()) continue;
+                for (vecs::EntityID entity : it->second) {
+                    f(entity, m_entries.at(entity));
+                }
+            }
+        }
+    }
+}
+
+void EntitySpatialHash::queryPairs(std::vector<EntityPair>& pairs) const {
+    for (auto& it : m_entries) {
+        const Entry& entry = it.second;
+        WorldCubeFace face = (WorldCubeFace)(entry.key >> 60);
+        // Any box that overlaps this one has its center within the padded range
+        i32v3 minCell = getCell(entry.min - m_maxHalfExtents);
+        i32v3 maxCell = getCell(entry.max + m_maxHalfExtents);
+        forEachInCells(face, minCell, maxCell, [&](vecs::EntityID other, const Entry& o) {
+            if (other <= it.first || o.planet != entry.planet) return;
+            if (entry.min.x < o.max.x && entry.max.x > o.min.x &&
+                entry.min.y < o.max.y && entry.max.y > o.min.y &&
+                entry.min.z < o.max.z && entry.max.z > o.min.z) {
+                pairs.emplace_back(it.first, other);
+            }
+        });
+    }
+}
+
+void EntitySpatialHash::queryRadius(vecs::ComponentID planet, WorldCubeFace face, const f64v3& center, f64 radius,
+                                    std::vector<vecs::EntityID>& entities) const {
+    i32v3 minCell = getCell(center - radius - m_maxHalfExtents);
+    i32v3 maxCell = getCell(center + radius + m_maxHalfExtents);
+    f64 radius2 = radius * radius;
+    forEachInCells(face, minCell, maxCell, [&](vecs::EntityID entity, const Entry& e) {
+        if (e.planet != planet) return;
+        // Distance from the center to the closest point on the box
+        f64v3 d = center - vmath::clamp(center, e.min, e.max);
+        if (vmath::dot(d, d) <= radius2) entities.push_back(entity);
+    });
+}
+
+i32v3 EntitySpatialHash::getCell(const f64v3& position) {
+    return i32v3(vmath::floor(position / (f64)ENTITY_HASH_CELL_WIDTH));
+}
+
+ui64 EntitySpatialHash::getKey(WorldCubeFace face, const i32v3& cell) {
+    // 4 bits face, 22 bits x, 16 bits y, 22 bits z
+    return ((ui64)face << 60) |
+           (((ui64)cell.x & 0x3FFFFF) << 38) |
+           (((ui64)cell.y & 0xFFFF) << 22) |
+           ((ui64)cell.z & 0x3FFFFF);
+}
+
+void EntitySpatialHash::removeFromCell(ui64 key, vecs::EntityID entity) {
+    auto it = m_cells.find(key);
+    if (it == m_cells.end()) return;
+    std::vector<vecs::EntityID>& cell = it->second;
+    for (size_t i = 0; i < cell.size(); i++) {
+        if (cell[i] == entity) {
+            cell[i] = cell.back();
+            cell.pop_back();
+            break;
+        }
+    }
+    if (cell.empty()) m_cells.erase(it);
+}
@@ -0,0 +1,71 @@
+///
+/// EntitySpatialHash.h
+/// Seed of Andromeda
+///
+/// Copyright 2014 Regrowth Studios
+/// All Rights Reserved
+///
+/// Summary:
+/// Uniform grid broadphase for entities in voxel space.
+///
+
+#pragma once
+
+#ifndef EntitySpatialHash_h__
+#define EntitySpatialHash_h__
+
+#include <Vorb/ecs/Entity.h>
+
+#include "VoxelCoordinateSpaces.h"
+
+// Width of a hash cell in voxels
+#define ENTITY_HASH_CELL_WIDTH 4
+
+typedef std::pair<vecs::EntityID, vecs::EntityID> EntityPair;
+
+/// Buckets entity boxes by the grid cell of their center, keyed by cube
+/// face and cell. Boxes are tracked per entity, so updating an entity
+/// that stays in its cell never touches the buckets.
+class EntitySpatialHash {
+public:
+    /// Inserts an entity or moves it to its new position
+    /// @param planet: Spherical voxel component the entity is in, only
+    /// entities on the same planet can overlap
+    void update(vecs::EntityID entity, vecs::ComponentID planet, WorldCubeFace face,
+                const f64v3& center, const f64v3& halfExtents);
+    void remove(vecs::EntityID entity);
+    /// Removes every entity that wasn't updated since the last call
+    void removeStale();
+    void clear();
+
+    /// Finds every pair of entities whose boxes overlap. Each pair is
+    /// reported once, with the lower entity ID first.
+    void queryPairs(std::vector<EntityPair>& pairs) const;
+    /// Finds every entity whose box intersects the sphere
+    void queryRadius(vecs::ComponentID planet, WorldCubeFace face, const f64v3& center, f64 radius,
+                     std::vector<vecs::EntityID>& entities) const;
+
+    size_t size() const { return m_entries.size(); }
+private:
+    struct Entry {
+        ui64 key;
+        vecs::ComponentID planet;
+        f64v3 min;
+        f64v3 max;
+        ui32 stamp;
+    };
+
+    static i32v3 getCell(const f64v3& position);
+    static ui64 getKey(WorldCubeFace face, const i32v3& cell);
+    void removeFromCell(ui64 key, vecs::EntityID entity);
+    /// Calls f on every entity whose cell is within [minCell, maxCell] on the face
+    template<typename F>
+    void forEachInCells(WorldCubeFace face, const i32v3& minCell, const i32v3& maxCell, F f) const;
+
+    std::unordered_map<ui64, std::vector<vecs::EntityID>> m_cells;
+    std::unordered_map<vecs::EntityID, Entry> m_entries;
+    f64v3 m_maxHalfExtents = f64v3(0.0); ///< Largest box seen, so queries can pad by it
+    ui32 m_stamp = 0;
+};
+
+#endif // EntitySpatialHash_h__
@@ -162,7 +162,33 @@ inline void smoothInterpFactor(f32& l, const FloraInterpType& type) {
     }
 }
 
-void FloraGenerator::generateChunkFlora(const Chunk* chunk, const PlanetHeightData* heightData, OUT std::vector<FloraNode>& fNodes, OUT std::vector<FloraNode>& wNodes) {
+ui32 FloraNodeBuckets::get(ui32 chunkOffset) {
+    int slot = FloraGenerator::getNeighborhoodSlot(chunkOffset);
+    if (slot != -1) {
+        if (m_slots[slot] != -1) return m_slots[slot];
+    } else {
+        // Far from the origin, very rare
+        for (size_t i = 0; i < m_numBuckets; i++) {
+            if (m_buckets[i].chunkOffset == chunkOffset) return i;
+        }
+    }
+    if (m_numBuckets == m_buckets.size()) m_buckets.emplace_back();
+    FloraNodeBucket& bucket = m_buckets[m_numBuckets];
+    bucket.chunkOffset = chunkOffset;
+    if (slot != -1) m_slots[slot] = (i16)m_numBuckets;
+    return m_numBuckets++;
+}
+
+void FloraNodeBuckets::clear() {
+    for (size_t i = 0; i < m_numBuckets; i++) {
+        m_buckets[i].fNodes.clear();
+        m_buckets[i].wNodes.clear();
+    }
+    m_numBuckets = 0;
+    memset(m_slots, 0xFF, sizeof(m_slots));
+}
+
+void FloraGenerator::generateChunkFlora(const Chunk* chunk, const PlanetHeightData* heightData, OUT FloraNodeBuckets& nodes) {
     // Iterate all block indices where flora must be generated
     for (ui16 blockIndex : chunk->floraToGenerate) {
         // Get position
@@ -179,10 +205,18 @@ void FloraGenerator::generateChunkFlora(const Chunk* chunk, const PlanetHeightDa
         // Determine which to generate
         if (hd.flora < b->flora.size()) {
             // It's a flora
-            generateFlora(b->flora[hd.flora].data, age, fNodes, wNodes, NO_CHUNK_OFFSET, blockIndex);
+            generateFlora(b->flora[hd.flora].data, age, nodes, NO_CHUNK_OFFSET, blockIndex);
         } else {
             // It's a tree
-            generateTree(b->trees[hd.flora - b->flora.size()].data, age, fNodes, wNodes, b->genData, NO_CHUNK_OFFSET, blockIndex);
+            const NTreeType* type = b->trees[hd.flora - b->flora.size()].data;
+            if (m_rGen.genlf() < TREE_TEMPLATE_HERO_CHANCE) {
+                // Hero trees are one of a kind
+                generateTree(type, age, nodes, b->genData, NO_CHUNK_OFFSET, blockIndex);
+            } else {
+                ui32 variant = m_rGen.gen() % TREE_TEMPLATE_VARIANTS;
+                ui32 rotation = m_rGen.gen() & 3; // & 3 == % 4
+                generateTreeFromTemplate(type, variant, rotation, nodes, b->genData, NO_CHUNK_OFFSET, blockIndex);
+            }
         }
     }
 }
@@ -317,18 +351,15 @@ struct DirLookup {
 };
 const DirLookup DIR_AXIS_LOOKUP[4] = { {0, X_1, -1}, {2, Z_1, -1}, {0, X_1, 1}, {2, Z_1, 1} };
 
-void FloraGenerator::generateTree(const NTreeType* type, f32 age, OUT std::vector<FloraNode>& fNodes, OUT std::vector<FloraNode>& wNodes, const PlanetGenData* genData, ui32 chunkOffset /*= NO_CHUNK_OFFSET*/, ui16 blockIndex /*= 0*/) {
+void FloraGenerator::generateTree(const NTreeType* type, f32 age, OUT FloraNodeBuckets& nodes, const PlanetGenData* genData, ui32 chunkOffset /*= NO_CHUNK_OFFSET*/, ui16 blockIndex /*= 0*/) {
     // Get the properties for this tree
     // TODO(Ben): Temp
     m_genData = genData;
     age = 1.0f;
-    m_currChunkOff = 0;
     generateTreeProperties(type, age, m_treeData);
-    m_nodeFields.reserve(m_treeData.height / CHUNK_WIDTH + 3);
-    m_nodeFieldsMap.reserve(200);
+    clearNodeFields();
     // Get handles
-    m_wNodes = &wNodes;
-    m_fNodes = &fNodes;
+    m_nodes = &nodes;
 
     f32v3 m_startPos = f32v3(m_center) +
         f32v3(CHUNK_WIDTH * getChunkXOffset(chunkOffset),
@@ -397,10 +428,10 @@ void FloraGenerator::generateTree(const NTreeType* type, f32 age, OUT std::vecto
                 if (trunkProps->coreWidth + trunkProps->barkWidth == 1) {
                     if (trunkProps->coreWidth) {
                         ui16 blockIndex = (ui16)(m_center.x + m_center.y * CHUNK_LAYER + m_center.z * CHUNK_WIDTH);
-                        tryPlaceNode(m_wNodes, 3, trunkProps->coreBlockID, blockIndex, chunkOffset);
+                        tryPlaceNode(NodeType::WOOD, 3, trunkProps->coreBlockID, blockIndex, chunkOffset);
                     } else {
                         ui16 blockIndex = (ui16)(m_center.x + m_center.y * CHUNK_LAYER + m_center.z * CHUNK_WIDTH);
-                        tryPlaceNode(m_wNodes, 3, trunkProps->barkBlockID, blockIndex, chunkOffset);
+                        tryPlaceNode(NodeType::WOOD, 3, trunkProps->barkBlockID, blockIndex, chunkOffset);
                     }
                 }
                 const DirLookup& dir = DIR_AXIS_LOOKUP[m_treeData.currentDir];
@@ -454,14 +485,14 @@ void FloraGenerator::generateTree(const NTreeType* type, f32 age, OUT std::vecto
             }
         }
         // Last node is leaf
-        m_scLeafSet.insert(m_scRayNodes.size() - 1);
+        m_scLeaves.push_back(m_scRayNodes.size() - 1);
     }
 
     // Place nodes for branches
     if (m_scRayNodes.size()) {
         generateSCBranches();
         std::vector<SCRayNode>().swap(m_scRayNodes);
-        std::set<ui32>().swap(m_scLeafSet);
+        std::vector<ui32>().swap(m_scLeaves);
     }
 
     // Place leaves last to prevent node overlap
@@ -480,11 +511,85 @@ void FloraGenerator::generateTree(const NTreeType* type, f32 age, OUT std::vecto
     std::vector<LeavesToPlace>().swap(m_leavesToPlace);
     std::vector<BranchToGenerate>().swap(m_branchesToGenerate);
     std::vector<TreeTrunkProperties>().swap(m_scTrunkProps);
-    std::unordered_map<ui32, ui32>().swap(m_nodeFieldsMap);
-    std::vector<NodeField>().swap(m_nodeFields);
 }
 
-void FloraGenerator::generateFlora(const FloraType* type, f32 age, OUT std::vector<FloraNode>& fNodes, OUT std::vector<FloraNode>& wNodes, ui32 chunkOffset /*= NO_CHUNK_OFFSET*/, ui16 blockIndex /*= 0*/) {
+void FloraGenerator::generateTreeFromTemplate(const NTreeType* type, ui32 variant, ui32 rotation, OUT FloraNodeBuckets& nodes, const PlanetGenData* genData, ui32 chunkOffset /*= NO_CHUNK_OFFSET*/, ui16 blockIndex /*= 0*/) {
+    // Root relative to the origin chunk. Making a template moves m_center, so get this first.
+    i32v3 root((blockIndex & 0x1F) + getChunkXOffset(chunkOffset) * CHUNK_WIDTH, // & 0x1F = % 32
+               blockIndex / CHUNK_LAYER + getChunkYOffset(chunkOffset) * CHUNK_WIDTH,
+               (blockIndex & 0x3FF) / CHUNK_WIDTH + getChunkZOffset(chunkOffset) * CHUNK_WIDTH); // & 0x3FF = % 1024
+    const TreeTemplate& tree = getTreeTemplate(type, variant, genData);
+
+    ui32 currChunkOff = UINT32_MAX;
+    ui32 currBucket = 0;
+    auto stamp = [&](const TreeTemplateNode& node, bool wood) {
+        // Rotate about the root in 90 degree steps
+        i32v3 pos;
+        switch (rotation) {
+            case 0: pos.x = node.x; pos.z = node.z; break;
+            case 1: pos.x = -node.z; pos.z = node.x; break;
+            case 2: pos.x = -node.x; pos.z = -node.z; break;
+            default: pos.x = node.z; pos.z = -node.x; break;
+        }
+        pos.x += root.x;
+        pos.y = node.y + root.y;
+        pos.z += root.z;
+        // Arithmetic shift floors, so negative positions land in the right chunk
+        ui32 off = ((ui32)((pos.x >> 5) + 0x1FF) << 20) |
+                   ((ui32)((pos.y >> 5) + 0x1FF) << 10) |
+                   (ui32)((pos.z >> 5) + 0x1FF);
+        if (off != currChunkOff) {
+            currChunkOff = off;
+            currBucket = nodes.get(off);
+        }
+        ui16 index = (ui16)((pos.x & 0x1F) + (pos.y & 0x1F) * CHUNK_LAYER + (pos.z & 0x1F) * CHUNK_WIDTH);
+        if (wood) {
+            nodes[currBucket].wNodes.emplace_back(node.blockID, index);
+        } else {
+            nodes[currBucket].fNodes.emplace_back(node.blockID, index);
+        }
+    };
+    for (auto& node : tree.wNodes) stamp(node, true);
+    for (auto& node : tree.fNodes) stamp(node, false);
+}
+
+void FloraGenerator::clearTreeTemplates() {
+    std::unordered_map<TreeTemplateKey, TreeTemplate, TreeTemplateKeyHash>().swap(m_treeTemplates);
+}
+
+const TreeTemplate& FloraGenerator::getTreeTemplate(const NTreeType* type, ui32 variant, const PlanetGenData* genData) {
+    TreeTemplateKey key = { type, variant };
+    auto it = m_treeTemplates.find(key);
+    if (it != m_treeTemplates.end()) return it->second;
+
+    TreeTemplate& tree = m_treeTemplates[key];
+    // The seed only depends on the key, so every worker makes the same template
+    m_rGen.seed(variant, 0u, 0u);
+    m_center = i32v3(0);
+    m_templateNodes.clear();
+    generateTree(type, 1.0f, m_templateNodes, genData, NO_CHUNK_OFFSET, 0);
+
+    // Store positions relative to the root
+    for (size_t i = 0; i < m_templateNodes.size(); i++) {
+        const FloraNodeBucket& bucket = m_templateNodes[i];
+        int bx = getChunkXOffset(bucket.chunkOffset) * CHUNK_WIDTH;
+        int by = getChunkYOffset(bucket.chunkOffset) * CHUNK_WIDTH;
+        int bz = getChunkZOffset(bucket.chunkOffset) * CHUNK_WIDTH;
+        for (auto& n : bucket.wNodes) {
+            tree.wNodes.emplace_back((i16)(bx + (n.blockIndex & 0x1F)), (i16)(by + n.blockIndex / CHUNK_LAYER),
+                                     (i16)(bz + (n.blockIndex & 0x3FF) / CHUNK_WIDTH), n.blockID);
+        }
+        for (auto& n : bucket.fNodes) {
+            tree.fNodes.emplace_back((i16)(bx + (n.blockIndex & 0x1F)), (i16)(by + n.blockIndex / CHUNK_LAYER),
+                                     (i16)(bz + (n.blockIndex & 0x3FF) / CHUNK_WIDTH), n.blockID);
+        }
+    }
+    tree.wNodes.shrink_to_fit();
+    tree.fNodes.shrink_to_fit();
+    return tree;
+}
+
+void FloraGenerator::generateFlora(const FloraType* type, f32 age, OUT FloraNodeBuckets& nodes, ui32 chunkOffset /*= NO_CHUNK_OFFSET*/, ui16 blockIndex /*= 0*/) {
     FloraData data;
     generateFloraProperties(type, age, data);
 
@@ -496,14 +601,14 @@ void FloraGenerator::generateFlora(const FloraType* type, f32 age, OUT std::vect
     do {
         if (data.dir == TREE_UP) {
             for (m_h = 0; m_h < data.height; ++m_h) {
-                fNodes.emplace_back(data.block, blockIndex, chunkOffset);
+                nodes[nodes.get(chunkOffset)].fNodes.emplace_back(data.block, blockIndex);
                 // Move up
                 offsetPositive(y, Y_1, chunkOffset, 1);
                 blockIndex = x + y * CHUNK_LAYER + z * CHUNK_WIDTH;
             }
         } else if (data.dir == TREE_DOWN) {
             for (m_h = 0; m_h < data.height; ++m_h) {
-                fNodes.emplace_back(data.block, blockIndex, chunkOffset);
+                nodes[nodes.get(chunkOffset)].fNodes.emplace_back(data.block, blockIndex);
                 // Move up
                 offsetNegative(y, Y_1, chunkOffset, 1);
                 blockIndex = x + y * CHUNK_LAYER + z * CHUNK_WIDTH;
@@ -678,55 +783,80 @@ void FloraGenerator::spaceColonization(const f32v3& startPos) {
         }
     }
 
+    if (attractPoints.size() < 5 || m_scNodes.empty()) return;
+
+    // Index nodes by position. Cells span the largest query radius, so
+    // every node that can reach a point is in the 27 cells around it.
+    f32v3 minPos = attractPoints[0];
+    f32v3 maxPos = attractPoints[0];
+    for (auto& p : attractPoints) {
+        minPos = vmath::min(minPos, p);
+        maxPos = vmath::max(maxPos, p);
+    }
+    f32 cellSize = vmath::max(infRadius, killRadius);
+    // Cap the cell count for tiny radii
+    f32v3 extent = maxPos - minPos;
+    cellSize = vmath::max(cellSize, vmath::max(extent.x, vmath::max(extent.y, extent.z)) / 32.0f);
+    m_scGrid.init(minPos - f32v3(cellSize), maxPos + f32v3(cellSize), cellSize);
+    for (size_t i = 0; i < m_scNodes.size(); i++) {
+        m_scGrid.add(m_scRayNodes[m_scNodes[i].rayNode].pos, i);
+    }
+
     // Iteratively construct the tree
     int iter = 0;
     while (++iter < 10000) {
-        if (attractPoints.size() < 5 || m_scNodes.empty()) return;
+        if (attractPoints.size() < 5) break;
 
+        // Nothing will change once no point is killed or attracts a node
+        bool changed = false;
         for (int i = (int)attractPoints.size() - 1; i >= 0; --i) {
+            const f32v3& point = attractPoints[i];
             f32 closestDist = FLT_MAX;
             int closestIndex = -1;
+            bool killed = false;
             // Get closest node and attract it towards attract point
-            for (size_t j = 0; j < m_scNodes.size(); j++) {
-                auto& tn = m_scNodes[j];
-                f32v3 v = attractPoints[i] - m_scRayNodes[tn.rayNode].pos;
+            m_scGrid.forEachNear(point, [&](ui32 j) {
+                f32v3 v = point - m_scRayNodes[m_scNodes[j].rayNode].pos;
                 f32 dist2 = selfDot(v);
                 if (dist2 <= killRadius2) {
-                    attractPoints[i] = attractPoints.back();
-                    attractPoints.pop_back();
-                    closestIndex = -1;
-                    break;
+                    killed = true;
+                    return false;
                 } else if (dist2 <= infRadius2 && dist2 < closestDist) {
                     closestDist = dist2;
                     closestIndex = j;
                 }
-            }
-            if (closestIndex != -1) {
+                return true;
+            });
+            if (killed) {
+                attractPoints[i] = attractPoints.back();
+                attractPoints.pop_back();
+                changed = true;
+            } else if (closestIndex != -1) {
                 auto& tn = m_scNodes[closestIndex];
-                tn.dir += (attractPoints[i] - m_scRayNodes[tn.rayNode].pos) / closestDist;
+                tn.dir += (point - m_scRayNodes[tn.rayNode].pos) / closestDist;
+                changed = true;
             }
         }
+        if (!changed) break;
 
         // Generate new nodes and erase unneeded ones
         for (int i = (int)m_scNodes.size() - 1; i >= 0; --i) {
-            SCTreeNode& tn = m_scNodes.at(i);
+            SCTreeNode& tn = m_scNodes[i];
             const SCRayNode& n = m_scRayNodes[tn.rayNode];
             // Self dot?
             if (tn.dir.x && tn.dir.y && tn.dir.z) {
                 f32v3 pos = n.pos + vmath::normalize(tn.dir) * branchStep;
                 tn.dir = f32v3(0.0f);
+                // The new node is the tip now
+                tn.isLeaf = false;
                 ui32 nextIndex = m_scRayNodes.size();
-                // Change leaf node
-                // TODO(Ben): This can be a vector mebby?
-                auto& it = m_scLeafSet.find(tn.rayNode);
-                if (it != m_scLeafSet.end()) m_scLeafSet.erase(it);
-                m_scLeafSet.insert(nextIndex);
-    
+
                 // Have to make temp copies with emplace_back
                 ui16 trunkPropsIndex = n.trunkPropsIndex;
-                m_scRayNodes.emplace_back(pos, tn.rayNode, trunkPropsIndex);
-                m_scNodes.emplace_back(nextIndex);
-
+                ui16 rayNode = tn.rayNode;
+                m_scRayNodes.emplace_back(pos, rayNode, trunkPropsIndex);
+                m_scGrid.add(pos, m_scNodes.size());
+                m_scNodes.emplace_back(nextIndex, true);
             } else {
                 // Remove it since its close to nothing
      //           m_scNodes[i] = m_scNodes.back();
@@ -734,33 +864,65 @@ void FloraGenerator::spaceColonization(const f32v3& startPos) {
             }
         }
     }
+
+    for (auto& tn : m_scNodes) {
+        if (tn.isLeaf) m_scLeaves.push_back(tn.rayNode);
+    }
 }
 
 // Priority can not be bigger than 3
-inline void FloraGenerator::tryPlaceNode(std::vector<FloraNode>* nodes, ui8 priority, ui16 blockID, ui16 blockIndex, ui32 chunkOffset) {
+inline void FloraGenerator::tryPlaceNode(NodeType type, ui8 priority, ui16 blockID, ui16 blockIndex, ui32 chunkOffset) {
     if (m_currChunkOff != chunkOffset) {
         m_currChunkOff = chunkOffset;
-        auto& it = m_nodeFieldsMap.find(chunkOffset);
-        if (it == m_nodeFieldsMap.end()) {
-            m_currNodeField = m_nodeFields.size();
-            m_nodeFields.emplace_back();
-            m_nodeFieldsMap.insert(std::pair<ui32, int>(chunkOffset, m_currNodeField));
-        } else {
-            m_currNodeField = it->second;
-        }
+        m_currNodeField = getNodeField(chunkOffset);
+        m_currBucket = m_nodes->get(chunkOffset);
     }
     // For memory compression we pack 4 nodes into each val
     NodeField& nf = m_nodeFields[m_currNodeField];
     ui8& val = nf.vals[blockIndex >> 2];
     ui8 shift = (blockIndex & 0x3) << 1;
     if ((((val >> shift) & 0x3) < priority)) {
-        nodes->emplace_back(blockID, blockIndex, chunkOffset);
+        FloraNodeBucket& bucket = (*m_nodes)[m_currBucket];
+        if (type == NodeType::WOOD) {
+            bucket.wNodes.emplace_back(blockID, blockIndex);
+        } else {
+            bucket.fNodes.emplace_back(blockID, blockIndex);
+        }
         // Overwrite priority
         val &= ~(0x3 << shift);
         val |= (priority << shift);
     }
 }
 
+ui32 FloraGenerator::getNodeField(ui32 chunkOffset) {
+    int slot = getNeighborhoodSlot(chunkOffset);
+    if (slot != -1) {
+        if (m_nodeFieldSlots[slot] != -1) return m_nodeFieldSlots[slot];
+    } else {
+        for (auto& it : m_farNodeFields) {
+            if (it.first == chunkOffset) return it.second;
+        }
+    }
+    if (m_numNodeFields == m_nodeFields.size()) m_nodeFields.emplace_back();
+    if (slot != -1) {
+        m_nodeFieldSlots[slot] = (i16)m_numNodeFields;
+    } else {
+        m_farNodeFields.emplace_back(chunkOffset, m_numNodeFields);
+    }
+    return m_numNodeFields++;
+}
+
+void FloraGenerator::clearNodeFields() {
+    // Only the fields the last tree touched are dirty
+    for (ui32 i = 0; i < m_numNodeFields; i++) {
+        memset(m_nodeFields[i].vals, 0, sizeof(m_nodeFields[i].vals));
+    }
+    m_numNodeFields = 0;
+    memset(m_nodeFieldSlots, 0xFF, sizeof(m_nodeFieldSlots));
+    m_farNodeFields.clear();
+    m_currChunkOff = UINT32_MAX; // Not a real offset, forces a lookup
+}
+
 // TODO(Ben): Need to handle different shapes than just round
 void FloraGenerator::makeTrunkSlice(ui32 chunkOffset, const TreeTrunkProperties& props) {
     // This function is so clever
@@ -821,16 +983,16 @@ void FloraGenerator::makeTrunkSlice(ui32 chunkOffset, const TreeTrunkProperties&
                 if (dist2 > woodWidth2m1) {
                     if (m_rGen.gen() % OUTER_SKIP_MOD) {
                         if (dist2 < innerWidth2) {
-                            tryPlaceNode(m_wNodes, 3, props.coreBlockID, blockIndex, chunkOff);
+                            tryPlaceNode(NodeType::WOOD, 3, props.coreBlockID, blockIndex, chunkOff);
                         } else {
-                            tryPlaceNode(m_wNodes, 3, props.barkBlockID, blockIndex, chunkOff);
+                            tryPlaceNode(NodeType::WOOD, 3, props.barkBlockID, blockIndex, chunkOff);
                         }
                     }
                 } else {
                     if (dist2 < innerWidth2) {
-                        tryPlaceNode(m_wNodes, 3, props.coreBlockID, blockIndex, chunkOff);
+                        tryPlaceNode(NodeType::WOOD, 3, props.coreBlockID, blockIndex, chunkOff);
                     } else {
-                        tryPlaceNode(m_wNodes, 3, props.barkBlockID, blockIndex, chunkOff);
+                        tryPlaceNode(NodeType::WOOD, 3, props.barkBlockID, blockIndex, chunkOff);
                     }
                 }
             } else if (dist2 < woodWidth2p1) { // Fruit and branching
@@ -848,7 +1010,7 @@ void FloraGenerator::makeTrunkSlice(ui32 chunkOffset, const TreeTrunkProperties&
                     }
                     m_branchesToGenerate.emplace_back(blockIndex, chunkOff, dx, dz, m_scTrunkProps.size() - 1);
                 } else if (leafWidth && leafBlockID) {
-                    tryPlaceNode(m_fNodes, 1, leafBlockID, blockIndex, chunkOff);
+                    tryPlaceNode(NodeType::FLORA, 1, leafBlockID, blockIndex, chunkOff);
                 }
             } else if (dist2 < leafWidth2 && leafBlockID) { // Leaves
                 // Get position
@@ -856,7 +1018,7 @@ void FloraGenerator::makeTrunkSlice(ui32 chunkOffset, const TreeTrunkProperties&
                 ui32 chunkOff = chunkOffset;
                 addChunkOffset(pos, chunkOff);
                 ui16 blockIndex = (ui16)(pos.x + yOff + pos.y * CHUNK_WIDTH);
-                tryPlaceNode(m_fNodes, 1, leafBlockID, blockIndex, chunkOff);
+                tryPlaceNode(NodeType::FLORA, 1, leafBlockID, blockIndex, chunkOff);
             }
         }
     }
@@ -954,9 +1116,9 @@ void FloraGenerator::generateBranch(ui32 chunkOffset, int x, int y, int z, f32 l
                     addChunkOffset(pos, chunkOff);
                     ui16 newIndex = (ui16)(pos.x + pos.y * CHUNK_LAYER + pos.z * CHUNK_WIDTH);
                     if (dist2 > width2m1 + 1) {
-                        if (m_rGen.gen() % OUTER_SKIP_MOD) tryPlaceNode(m_wNodes, 3, props.coreBlockID, newIndex, chunkOff);
+                        if (m_rGen.gen() % OUTER_SKIP_MOD) tryPlaceNode(NodeType::WOOD, 3, props.coreBlockID, newIndex, chunkOff);
                     } else {
-                        tryPlaceNode(m_wNodes, 3, props.coreBlockID, newIndex, chunkOff);
+                        tryPlaceNode(NodeType::WOOD, 3, props.coreBlockID, newIndex, chunkOff);
                     }
                 } else if (canFruit && dist2 < width2p1 && props.fruitProps.flora != FLORA_ID_NONE) {
                     // Distribute fruit chance over the circumference of the branch
@@ -966,7 +1128,7 @@ void FloraGenerator::generateBranch(ui32 chunkOffset, int x, int y, int z, f32 l
                         ui32 chunkOff = chunkOffset;
                         addChunkOffset(pos, chunkOff);
                         ui16 newIndex = (ui16)(pos.x + pos.y * CHUNK_LAYER + pos.z * CHUNK_WIDTH);
-                        generateFlora(&m_genData->flora.at(props.fruitProps.flora), 1.0f, *m_fNodes, *m_wNodes, chunkOff, newIndex);
+                        generateFlora(&m_genData->flora.at(props.fruitProps.flora), 1.0f, *m_nodes, chunkOff, newIndex);
                     }
                 }
             }
@@ -991,9 +1153,11 @@ void FloraGenerator::generateSCBranches() {
         }
     }
 
+    // Tips are walked in index order
+    std::sort(m_scLeaves.begin(), m_scLeaves.end());
     std::vector <ui32> lNodesToAdd;
     // Set widths and sub branches
-    for (auto& l : m_scLeafSet) {
+    for (auto& l : m_scLeaves) {
         ui32 i = l;
         while (true) {
             SCRayNode& a = m_scRayNodes[i];
@@ -1063,13 +1227,12 @@ void FloraGenerator::generateSCBranches() {
             }
         }
     }
-    for (auto& i : lNodesToAdd) {
-        m_scLeafSet.insert(i);
-    }
+    // Sub branch tips come after every existing node, so order is kept
+    m_scLeaves.insert(m_scLeaves.end(), lNodesToAdd.begin(), lNodesToAdd.end());
 
     // Make branches
     int a = 0;
-    for (auto& l : m_scLeafSet) {
+    for (auto& l : m_scLeaves) {
         ui32 i = l;
         bool hasLeaves = true;
         while (true) {
@@ -1137,9 +1300,9 @@ void FloraGenerator::generateRoundLeaves(ui32 chunkOffset, int x, int y, int z,
                     addChunkOffset(pos, chunkOff);
                     ui16 blockIndex = (ui16)(pos.x + pos.y * CHUNK_LAYER + pos.z * CHUNK_WIDTH);
                     if (dist2 > radius2m1) {
-                        if (m_rGen.gen() % OUTER_SKIP_MOD) tryPlaceNode(m_fNodes, 1, props.round.blockID, blockIndex, chunkOff);
+                        if (m_rGen.gen() % OUTER_SKIP_MOD) tryPlaceNode(NodeType::FLORA, 1, props.round.blockID, blockIndex, chunkOff);
                     } else {
-                        tryPlaceNode(m_fNodes, 1, props.round.blockID, blockIndex, chunkOff);
+                        tryPlaceNode(NodeType::FLORA, 1, props.round.blockID, blockIndex, chunkOff);
                     }
                 }
             }
@@ -1181,9 +1344,9 @@ void FloraGenerator::generateEllipseLeaves(ui32 chunkOffset, int x, int y, int z
                     addChunkOffset(pos, chunkOff);
                     ui16 blockIndex = (ui16)(pos.x + yOff + pos.y * CHUNK_WIDTH);
                     if (dist2 > radius2m1) {
-                        if (m_rGen.gen() % OUTER_SKIP_MOD) tryPlaceNode(m_fNodes, 1, props.round.blockID, blockIndex, chunkOff);
+                        if (m_rGen.gen() % OUTER_SKIP_MOD) tryPlaceNode(NodeType::FLORA, 1, props.round.blockID, blockIndex, chunkOff);
                     } else {
-                        tryPlaceNode(m_fNodes, 1, props.round.blockID, blockIndex, chunkOff);
+                        tryPlaceNode(NodeType::FLORA, 1, props.round.blockID, blockIndex, chunkOff);
                     }
                 }
             }
@@ -1239,9 +1402,9 @@ void FloraGenerator::generateMushroomCap(ui32 chunkOffset, int x, int y, int z,
                         addChunkOffset(pos, chunkOff);
                         ui16 blockIndex = (ui16)(pos.x + yOff + pos.y * CHUNK_WIDTH);
                         if (dist2 >= capRadius2) {
-                            tryPlaceNode(m_fNodes, 1, props.mushroom.capBlockID, blockIndex, chunkOff);
+                            tryPlaceNode(NodeType::FLORA, 1, props.mushroom.capBlockID, blockIndex, chunkOff);
                         } else {
-                            tryPlaceNode(m_fNodes, 1, props.mushroom.gillBlockID, blockIndex, chunkOff);
+                            tryPlaceNode(NodeType::FLORA, 1, props.mushroom.gillBlockID, blockIndex, chunkOff);
                         }
                     }
                 }
@@ -1304,9 +1467,9 @@ void FloraGenerator::generateMushroomCap(ui32 chunkOffset, int x, int y, int z,
                         addChunkOffset(pos, chunkOff);
                         ui16 blockIndex = (ui16)(pos.x + yOff + pos.y * CHUNK_WIDTH);
                         if (dist2 >= capRadius2) {
-                            tryPlaceNode(m_fNodes, 1, props.mushroom.capBlockID, blockIndex, chunkOff);
+                            tryPlaceNode(NodeType::FLORA, 1, props.mushroom.capBlockID, blockIndex, chunkOff);
                         } else {
-                            tryPlaceNode(m_fNodes, 1, props.mushroom.gillBlockID, blockIndex, chunkOff);
+                            tryPlaceNode(NodeType::FLORA, 1, props.mushroom.gillBlockID, blockIndex, chunkOff);
                         }
                     }
                 }
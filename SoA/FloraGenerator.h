@@ -17,6 +17,7 @@
 
 #include "Flora.h"
 #include "Chunk.h"
+#include "VoxelNodeSetter.h"
 #include "soaUtils.h"
 
 // 0111111111 0111111111 0111111111 = 0x1FF7FDFF
@@ -24,15 +25,72 @@
 
 struct PlanetGenData;
 
-// Will not work for chunks > 32^3
-struct FloraNode {
-    FloraNode(ui16 blockID, ui16 blockIndex, ui32 chunkOffset) :
-        blockID(blockID), blockIndex(blockIndex), chunkOffset(chunkOffset) {
-    };
-    ui16 blockID;
-    ui16 blockIndex;
+// Chunks within this many chunks of the one flora grows from are looked
+// up directly by offset. Anything further goes through a slower search.
+#define FLORA_NEIGHBORHOOD_RADIUS 2
+#define FLORA_NEIGHBORHOOD_WIDTH (FLORA_NEIGHBORHOOD_RADIUS * 2 + 1)
+#define FLORA_NEIGHBORHOOD_SIZE (FLORA_NEIGHBORHOOD_WIDTH * FLORA_NEIGHBORHOOD_WIDTH * FLORA_NEIGHBORHOOD_WIDTH)
+
+/// Nodes that land in one chunk
+struct FloraNodeBucket {
     // TODO(Ben): ui32 instead for massive trees? Use leftover bits for Y?
     ui32 chunkOffset; ///< Packed 00 XXXXXXXXXX YYYYYYYYYY ZZZZZZZZZZ for positional offset. 00111 == 0
+    std::vector<VoxelToPlace> fNodes; ///< Low priority nodes, for flora and leaves
+    std::vector<VoxelToPlace> wNodes; ///< High priority nodes, for tree "wood"
+};
+
+/// Generated nodes grouped by the chunk they land in, as they are made
+class FloraNodeBuckets {
+public:
+    FloraNodeBuckets() { memset(m_slots, 0xFF, sizeof(m_slots)); }
+
+    /// Gets the bucket for a chunk offset, adding it if needed
+    /// @return Index of the bucket
+    ui32 get(ui32 chunkOffset);
+    /// Empties all buckets. Memory is kept for reuse.
+    void clear();
+
+    size_t size() const { return m_numBuckets; }
+    FloraNodeBucket& operator[](size_t i) { return m_buckets[i]; }
+    const FloraNodeBucket& operator[](size_t i) const { return m_buckets[i]; }
+private:
+    std::vector<FloraNodeBucket> m_buckets;
+    size_t m_numBuckets = 0;
+    i16 m_slots[FLORA_NEIGHBORHOOD_SIZE]; ///< Bucket for each neighborhood chunk, or -1
+};
+
+// Trees are stamped from cached templates, one per species and variant.
+// generateTree always grows trees to full age, so age is not part of the key.
+#define TREE_TEMPLATE_VARIANTS 8
+// Chance that a tree skips the cache and is generated from scratch
+#define TREE_TEMPLATE_HERO_CHANCE 0.05
+
+/// Voxel of a tree template, relative to the root
+struct TreeTemplateNode {
+    TreeTemplateNode(i16 x, i16 y, i16 z, ui16 blockID) : x(x), y(y), z(z), blockID(blockID) {}
+    i16 x, y, z;
+    ui16 blockID;
+};
+
+/// Pre-voxelized tree, already resolved for node priority
+struct TreeTemplate {
+    std::vector<TreeTemplateNode> wNodes;
+    std::vector<TreeTemplateNode> fNodes;
+};
+
+struct TreeTemplateKey {
+    const NTreeType* type;
+    ui32 variant;
+    bool operator==(const TreeTemplateKey& o) const {
+        return type == o.type && variant == o.variant;
+    }
+};
+
+struct TreeTemplateKeyHash {
+    size_t operator()(const TreeTemplateKey& k) const {
+        std::hash<const NTreeType*> h;
+        return h(k.type) ^ (k.variant * 2654435761u);
+    }
 };
 
 #define SC_NO_PARENT 0x7FFFu
@@ -51,10 +109,64 @@ struct SCRayNode {
 static_assert(sizeof(SCRayNode) == 24, "Size of SCRayNode is not 24");
 
 struct SCTreeNode {
-    SCTreeNode(ui16 rayNode) :
-        rayNode(rayNode), dir(0.0f) {};
+    SCTreeNode(ui16 rayNode, bool isLeaf = false) :
+        rayNode(rayNode), dir(0.0f), isLeaf(isLeaf) {};
     ui16 rayNode;
     f32v3 dir;
+    bool isLeaf; ///< Grown by space colonization and not grown from since
+};
+
+/// Uniform grid of space colonization nodes so attraction points only test
+/// nodes around them. Each cell is a linked list through m_next.
+class SCNodeGrid {
+public:
+    /// Cells must be at least as big as the largest query radius
+    void init(const f32v3& minPos, const f32v3& maxPos, f32 cellSize) {
+        m_min = minPos;
+        m_invCellSize = 1.0f / cellSize;
+        m_dims = i32v3((maxPos - minPos) * m_invCellSize) + i32v3(1);
+        m_heads.assign(m_dims.x * m_dims.y * m_dims.z, -1);
+        m_next.clear();
+    }
+    /// Nodes must be added in index order. Nodes outside the grid are too
+    /// far from every point to matter and are left out.
+    void add(const f32v3& pos, ui32 node) {
+        m_next.resize(node + 1, -1);
+        i32v3 c = getCell(pos);
+        if (!isInside(c)) return;
+        i32& head = m_heads[(c.y * m_dims.z + c.z) * m_dims.x + c.x];
+        m_next[node] = head;
+        head = (i32)node;
+    }
+    /// Calls f(node) for nodes in the 27 cells around pos until f returns false
+    template <typename F>
+    void forEachNear(const f32v3& pos, F f) const {
+        i32v3 c = getCell(pos);
+        i32v3 lo = vmath::max(c - i32v3(1), i32v3(0));
+        i32v3 hi = vmath::min(c + i32v3(1), m_dims - i32v3(1));
+        for (int y = lo.y; y <= hi.y; y++) {
+            for (int z = lo.z; z <= hi.z; z++) {
+                for (int x = lo.x; x <= hi.x; x++) {
+                    for (i32 n = m_heads[(y * m_dims.z + z) * m_dims.x + x]; n != -1; n = m_next[n]) {
+                        if (!f((ui32)n)) return;
+                    }
+                }
+            }
+        }
+    }
+private:
+    i32v3 getCell(const f32v3& pos) const {
+        return i32v3(vmath::floor((pos - m_min) * m_invCellSize));
+    }
+    bool isInside(const i32v3& c) const {
+        return c.x >= 0 && c.y >= 0 && c.z >= 0 && c.x < m_dims.x && c.y < m_dims.y && c.z < m_dims.z;
+    }
+
+    f32v3 m_min;
+    f32 m_invCellSize;
+    i32v3 m_dims;
+    std::vector<i32> m_heads; ///< First node in each cell, or -1
+    std::vector<i32> m_next; ///< Next node in the same cell, or -1
 };
 
 struct NodeField {
@@ -92,13 +204,17 @@ class FloraGenerator {
     /// @brief Generates flora for a chunk using its QueuedFlora.
     /// @param chunk: Chunk who's flora should be generated.
     /// @param gridData: The heightmap to use
-    /// @param fNodes: Returned low priority nodes, for flora and leaves.
-    /// @param wNodes: Returned high priority nodes, for tree "wood".
-    void generateChunkFlora(const Chunk* chunk, const PlanetHeightData* heightData, OUT std::vector<FloraNode>& fNodes, OUT std::vector<FloraNode>& wNodes);
+    /// @param nodes: Returned nodes, grouped by the chunk they land in.
+    void generateChunkFlora(const Chunk* chunk, const PlanetHeightData* heightData, OUT FloraNodeBuckets& nodes);
     /// Generates standalone tree.
-    void generateTree(const NTreeType* type, f32 age, OUT std::vector<FloraNode>& fNodes, OUT std::vector<FloraNode>& wNodes, const PlanetGenData* genData, ui32 chunkOffset = NO_CHUNK_OFFSET, ui16 blockIndex = 0);
+    void generateTree(const NTreeType* type, f32 age, OUT FloraNodeBuckets& nodes, const PlanetGenData* genData, ui32 chunkOffset = NO_CHUNK_OFFSET, ui16 blockIndex = 0);
+    /// Generates a tree by stamping a cached template, rotated about its root.
+    /// The template is generated on first use. Same arguments as generateTree, minus age.
+    void generateTreeFromTemplate(const NTreeType* type, ui32 variant, ui32 rotation, OUT FloraNodeBuckets& nodes, const PlanetGenData* genData, ui32 chunkOffset = NO_CHUNK_OFFSET, ui16 blockIndex = 0);
+    /// Frees all tree templates. Must be called when the gen data they came from is freed.
+    void clearTreeTemplates();
     /// Generates standalone flora.
-    void generateFlora(const FloraType* type, f32 age, OUT std::vector<FloraNode>& fNodes, OUT std::vector<FloraNode>& wNodes, ui32 chunkOffset = NO_CHUNK_OFFSET, ui16 blockIndex = 0);
+    void generateFlora(const FloraType* type, f32 age, OUT FloraNodeBuckets& nodes, ui32 chunkOffset = NO_CHUNK_OFFSET, ui16 blockIndex = 0);
     /// Generates a specific tree's properties
     static void generateTreeProperties(const NTreeType* type, f32 age, OUT TreeData& tree);
     static void generateFloraProperties(const FloraType* type, f32 age, OUT FloraData& flora);
@@ -114,12 +230,25 @@ class FloraGenerator {
     static inline int getChunkZOffset(ui32 chunkOffset) {
         return (int)(chunkOffset & 0x3FF) - 0x1FF;
     }
+    /// @return Index of the chunk in the neighborhood, or -1 if it is outside
+    static inline int getNeighborhoodSlot(ui32 chunkOffset) {
+        int x = getChunkXOffset(chunkOffset) + FLORA_NEIGHBORHOOD_RADIUS;
+        int y = getChunkYOffset(chunkOffset) + FLORA_NEIGHBORHOOD_RADIUS;
+        int z = getChunkZOffset(chunkOffset) + FLORA_NEIGHBORHOOD_RADIUS;
+        if ((ui32)x >= FLORA_NEIGHBORHOOD_WIDTH || (ui32)y >= FLORA_NEIGHBORHOOD_WIDTH || (ui32)z >= FLORA_NEIGHBORHOOD_WIDTH) return -1;
+        return (y * FLORA_NEIGHBORHOOD_WIDTH + z) * FLORA_NEIGHBORHOOD_WIDTH + x;
+    }
 private:
     enum TreeDir {
         TREE_LEFT = 0, TREE_BACK, TREE_RIGHT, TREE_FRONT, TREE_UP, TREE_DOWN, TREE_NO_DIR
     };
 
-    void tryPlaceNode(std::vector<FloraNode>* nodes, ui8 priority, ui16 blockID, ui16 blockIndex, ui32 chunkOffset);
+    enum class NodeType { FLORA, WOOD };
+
+    const TreeTemplate& getTreeTemplate(const NTreeType* type, ui32 variant, const PlanetGenData* genData);
+    void tryPlaceNode(NodeType type, ui8 priority, ui16 blockID, ui16 blockIndex, ui32 chunkOffset);
+    ui32 getNodeField(ui32 chunkOffset);
+    void clearNodeFields();
     void makeTrunkSlice(ui32 chunkOffset, const TreeTrunkProperties& props);
     void generateBranch(ui32 chunkOffset, int x, int y, int z, f32 length, f32 width, f32 endWidth, f32v3 dir, bool makeLeaves, bool hasParent, const TreeBranchProperties& props);
     void generateSCBranches();
@@ -129,16 +258,21 @@ class FloraGenerator {
     void generateMushroomCap(ui32 chunkOffset, int x, int y, int z, const TreeLeafProperties& props);
     void newDirFromAngle(f32v3& dir, f32 minAngle, f32 maxAngle);
 
-    std::set<ui32> m_scLeafSet;
-    std::unordered_map<ui32, ui32> m_nodeFieldsMap;
-    std::vector<NodeField> m_nodeFields;
+    std::vector<ui32> m_scLeaves; ///< Ray nodes at branch tips
+    SCNodeGrid m_scGrid;
+    // Node priorities for the current tree
+    std::vector<NodeField> m_nodeFields; ///< Kept between trees, the first m_numNodeFields are in use
+    ui32 m_numNodeFields = 0;
+    i16 m_nodeFieldSlots[FLORA_NEIGHBORHOOD_SIZE]; ///< Field for each neighborhood chunk, or -1
+    std::vector<std::pair<ui32, ui32>> m_farNodeFields; ///< Chunk offset and field outside the neighborhood
     std::vector<SCRayNode> m_scRayNodes;
     std::vector<SCTreeNode> m_scNodes;
     std::vector<LeavesToPlace> m_leavesToPlace;
     std::vector<BranchToGenerate> m_branchesToGenerate;
     std::vector<TreeTrunkProperties> m_scTrunkProps; ///< Stores branch properties for nodes
-    std::vector<FloraNode>* m_fNodes;
-    std::vector<FloraNode>* m_wNodes;
+    FloraNodeBuckets* m_nodes;
+    std::unordered_map<TreeTemplateKey, TreeTemplate, TreeTemplateKeyHash> m_treeTemplates;
+    FloraNodeBuckets m_templateNodes; ///< Scratch for making templates
     TreeData m_treeData;
     FloraData m_floraData;
     i32v3 m_center;
@@ -146,6 +280,7 @@ class FloraGenerator {
     FastRandGenerator m_rGen;
     ui32 m_currChunkOff;
     ui32 m_currNodeField;
+    ui32 m_currBucket;
     const PlanetGenData* m_genData;
     bool m_hasStoredTrunkProps;
 };
@@ -130,6 +130,10 @@ void GameplayScreen::update(const vui::GameTime& gameTime) {
     // TODO(Ben): Move to glUpdate for voxel component
     // TODO(Ben): Don't hardcode for a single player
     auto& vpCmp = m_soaState->gameSystem->voxelPosition.getFromEntity(m_soaState->clientState.playerEntity);
+    if (vpCmp.parentVoxel) {
+        auto& svCmp = m_soaState->spaceSystem->sphericalVoxel.get(vpCmp.parentVoxel);
+        m_soaState->clientState.chunkMeshManager->setRenderFace(vpCmp.gridPosition.face, (i32)(svCmp.voxelRadius / CHUNK_WIDTH));
+    }
     m_soaState->clientState.chunkMeshManager->update(vpCmp.gridPosition.pos, true);
 
     // Update the PDA
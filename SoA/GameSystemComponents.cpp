@@ -1,6 +1,9 @@
 #include "stdafx.h"
 #include "GameSystemComponents.h"
 
+#include "ChunkGrid.h"
+#include "ChunkSphereComponentUpdater.h"
+
 KEG_TYPE_DEF(AabbCollidableComponent, AabbCollidableComponent, kt) {
     using namespace keg;
     kt.addValue("box", Value::basic(offsetof(AabbCollidableComponent, box), BasicType::F32_V3));
@@ -60,3 +63,18 @@ KEG_TYPE_DEF(HeadComponent, HeadComponent, kt) {
     kt.addValue("neckLength", Value::basic(offsetof(HeadComponent, neckLength), BasicType::F64));
 }
 
+void ChunkSphereComponentTable::disposeComponent(vecs::ComponentID cID, vecs::EntityID eID) {
+    ChunkSphereComponent& cmp = _components[cID].second;
+    if (cmp.slotGrid) {
+        // Give up the sphere's interest so the grid can free its chunks
+        for (int i = 0; i < cmp.size; i++) {
+            ChunkSphereSlot& slot = cmp.slotGrid[i];
+            if (!slot.isActive) continue;
+            cmp.chunkGrids[slot.position.face].interest.removeInterest(slot.position.pos, true);
+        }
+        delete[] cmp.slotGrid;
+        cmp.slotGrid = nullptr;
+    }
+    ChunkSphereComponentUpdater::releasePrefetches(cmp, false);
+    cmp.chunkGrid = nullptr;
+}
@@ -15,6 +15,8 @@
 #ifndef GameSystemComponents_h__
 #define GameSystemComponents_h__
 
+#include <unordered_set>
+
 #include <Vorb/io/Keg.h>
 #include <Vorb/ecs/Entity.h>
 
@@ -134,6 +136,18 @@ struct VoxelPositionComponent {
 typedef vecs::ComponentTable<VoxelPositionComponent> VoxelPositionComponentTable;
 KEG_TYPE_DECL(VoxelPositionComponent);
 
+struct ChunkPrefetch {
+    ChunkHandle chunk;
+    ui64 key; ///< Face and chunk ID, for ChunkSphereComponent::prefetchKeys
+    ui32 expireUpdate;
+};
+
+/// A chunk the sphere has registered interest in
+struct ChunkSphereSlot {
+    ChunkPosition3D position; ///< Wrapped onto the face the chunk is on
+    bool isActive = false;
+};
+
 struct ChunkSphereComponent {
     vecs::ComponentID voxelPosition;
 
@@ -142,10 +156,20 @@ struct ChunkSphereComponent {
     // TODO(Ben): Chunk position?
     i32v3 offset = i32v3(0);
     i32v3 centerPosition = i32v3(0);
-    ChunkGrid* chunkGrid = nullptr;
-    ChunkHandle* handleGrid = nullptr;
+    ChunkGrid* chunkGrid = nullptr; ///< Grid of currentCubeFace
+    ChunkGrid* chunkGrids = nullptr; ///< All 6 face grids, the sphere can span face edges
+    i32 faceChunkRadius = 0; ///< Half the width of a face in chunks
+    ChunkSphereSlot* slotGrid = nullptr;
     // For fast 1 chunk shift
     std::vector<i32v3> acquireOffsets;
+    // Offsets of every chunk in the sphere, nearest first
+    std::vector<i32v3> shellOffsets;
+    size_t fillIndex = 0; ///< Shell offsets before this have interest
+    // Chunks requested ahead of the entity's movement. They are held until
+    // they expire so they aren't freed before the sphere reaches them.
+    std::vector<ChunkPrefetch> prefetches;
+    std::unordered_set<ui64> prefetchKeys;
+    ui32 updateCount = 0;
     WorldCubeFace currentCubeFace = FACE_NONE;
 
     i32 radius = 0;
@@ -155,12 +179,7 @@ struct ChunkSphereComponent {
 };
 class ChunkSphereComponentTable : public vecs::ComponentTable<ChunkSphereComponent> {
 public:
-    virtual void disposeComponent(vecs::ComponentID cID, vecs::EntityID eID) override {
-        ChunkSphereComponent& cmp = _components[cID].second;
-        delete[] cmp.handleGrid;
-        cmp.handleGrid = nullptr;
-        cmp.chunkGrid = nullptr;
-    }
+    virtual void disposeComponent(vecs::ComponentID cID, vecs::EntityID eID) override;
 };
 
 struct PhysicsComponent {
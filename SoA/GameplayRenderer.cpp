@@ -173,7 +173,8 @@ void GameplayRenderer::hook() {
     stages.liquidVoxel.hook(&m_chunkRenderer, &m_gameRenderParams);
     stages.chunkGrid.hook(&m_gameRenderParams);
  
-    //stages.devHud.hook();
+    stages.devHud.hook("Fonts/orbitron_bold-webfont.ttf", 16, m_gameplayScreen->m_app,
+                       f32v2(m_window->getViewportDims()), m_meshManager);
     //stages.pda.hook();
     stages.pauseMenu.hook(&m_gameplayScreen->m_pauseMenu);
     stages.nightVision.hook(&m_commonState->quad);
@@ -300,7 +301,7 @@ void GameplayRenderer::render() {
     m_commonState->stages.hdr.render();
 
     // UI
-    // stages.devHud.render();
+    stages.devHud.render(&m_voxelCamera);
     // stages.pda.render();
     stages.pauseMenu.render();
 
@@ -326,7 +327,7 @@ void GameplayRenderer::render() {
 }
 
 void GameplayRenderer::cycleDevHud(int offset /* = 1 */) {
-   // stages.devHud.cycleMode(offset);
+    stages.devHud.cycleMode(offset);
 }
 
 void GameplayRenderer::toggleNightVision() {
@@ -4,6 +4,7 @@
 #include "Chunk.h"
 #include "ChunkGenerator.h"
 #include "ChunkGrid.h"
+#include "ChunkUpdater.h"
 #include "FloraGenerator.h"
 
 void GenerateTask::execute(WorkerData* workerData) {
@@ -12,6 +13,7 @@ void GenerateTask::execute(WorkerData* workerData) {
     // Check if this is a heightmap gen
     if (chunk.gridData->isLoading) {
         chunkGenerator->m_proceduralGenerator.generateHeightmap(&chunk, heightData);
+        chunk.gridData->initSunHeight();
     } else { // Its a chunk gen
 
         switch (query->genLevel) {
@@ -24,6 +26,13 @@ void GenerateTask::execute(WorkerData* workerData) {
                     workerData->floraGenerator = new FloraGenerator;
                 }
                 generateFlora(workerData, chunk);
+                {
+                    ChunkWriteLock l(chunk.dataMutex);
+                    // Neighbors may have queued flora here while the terrain generated
+                    VoxelNodeSetter::placeInbox(&chunk);
+                    ChunkUpdater::initTickVoxels(&chunk);
+                    ChunkUpdater::initCollidable(&chunk);
+                }
                 chunk.genLevel = ChunkGenLevel::GEN_DONE;
                 break;
             case ChunkGenLevel::GEN_FLORA:
@@ -41,58 +50,68 @@ void GenerateTask::execute(WorkerData* workerData) {
     chunkGenerator->finishQuery(query);
 }
 
-struct ChunkFloraArrays {
-    std::vector<VoxelToPlace> fNodes;
-    std::vector<VoxelToPlace> wNodes;
+struct FloraTarget {
+    bool placeNodes; ///< Target has terrain, set the nodes directly
+    bool placeInbox; ///< Target got terrain while its nodes were being queued
 };
 
 void GenerateTask::generateFlora(WorkerData* workerData, Chunk& chunk) {
-    std::vector<FloraNode> fNodes, wNodes;
-    workerData->floraGenerator->generateChunkFlora(&chunk, heightData, fNodes, wNodes);
-
-
-    // Sort based on chunk to minimize locking
-    std::map<ChunkID, ChunkFloraArrays> chunkMap;
+    // Nodes come out already grouped by target chunk
+    FloraNodeBuckets buckets;
+    workerData->floraGenerator->generateChunkFlora(&chunk, heightData, buckets);
 
-    // Add all nodes
-    // TODO(Ben): There should be a way to approximate size needs or use map on generator side.
-    for (auto& it : fNodes) {
+    std::vector<FloraTarget> targets(buckets.size());
+    // Reserved, since copied handles aren't acquired
+    std::vector<ChunkHandle> handles;
+    handles.reserve(targets.size());
+    MultiChunkLock lock;
+    for (size_t i = 0; i < targets.size(); i++) {
+        FloraTarget& t = targets[i];
+        FloraNodeBucket& bucket = buckets[i];
         ChunkID id(chunk.getID());
-        id.x += FloraGenerator::getChunkXOffset(it.chunkOffset);
-        id.y += FloraGenerator::getChunkYOffset(it.chunkOffset);
-        id.z += FloraGenerator::getChunkZOffset(it.chunkOffset);
-        chunkMap[id].fNodes.emplace_back(it.blockID, it.blockIndex);
-    }
-    for (auto& it : wNodes) {
-        ChunkID id(chunk.getID());
-        id.x += FloraGenerator::getChunkXOffset(it.chunkOffset);
-        id.y += FloraGenerator::getChunkYOffset(it.chunkOffset);
-        id.z += FloraGenerator::getChunkZOffset(it.chunkOffset);
+        id.x += FloraGenerator::getChunkXOffset(bucket.chunkOffset);
+        id.y += FloraGenerator::getChunkYOffset(bucket.chunkOffset);
+        id.z += FloraGenerator::getChunkZOffset(bucket.chunkOffset);
+        handles.push_back(query->grid->accessor.acquire(id));
+        ChunkHandle& h = handles.back();
 
-        chunkMap[id].wNodes.emplace_back(it.blockID, it.blockIndex);
+        t.placeNodes = h->genLevel >= GEN_TERRAIN;
+        t.placeInbox = false;
+        if (!t.placeNodes) {
+            // Wait in the target's inbox until it has terrain
+            t.placeInbox = query->grid->nodeSetter.setNodes(h, bucket.wNodes, bucket.fNodes);
+        }
+        if (t.placeNodes || t.placeInbox) lock.add(h, ChunkLockMode::WRITE);
     }
 
-    // Traverse chunks
-    for (auto& it : chunkMap) {
-        ChunkHandle h = query->grid->accessor.acquire(it.first);
-        // TODO(Ben): Handle other case
-        if (h->genLevel >= GEN_TERRAIN) {
-            {
-                std::lock_guard<std::mutex> l(h->dataMutex);
-                for (auto& node : it.second.wNodes) {
-                    h->blocks.set(node.blockIndex, node.blockID);
-                }
-                for (auto& node : it.second.fNodes) {
-                    if (h->blocks.get(node.blockIndex) == 0) {
-                        h->blocks.set(node.blockIndex, node.blockID);
-                    }
+    // Take every target at once, so a tree that crosses chunk borders
+    // never shows up half placed
+    lock.lock();
+    for (size_t i = 0; i < targets.size(); i++) {
+        const FloraTarget& t = targets[i];
+        const FloraNodeBucket& bucket = buckets[i];
+        Chunk* h = handles[i];
+        if (t.placeNodes) {
+            for (auto& node : bucket.wNodes) {
+                h->setBlock(node.blockIndex, node.blockID);
+                ChunkUpdater::addTickVoxel(h, node.blockIndex, node.blockID);
+                ChunkUpdater::setCollidable(h, node.blockIndex, node.blockID);
+            }
+            for (auto& node : bucket.fNodes) {
+                if (h->blocks.get(node.blockIndex) == 0) {
+                    h->setBlock(node.blockIndex, node.blockID);
+                    ChunkUpdater::addTickVoxel(h, node.blockIndex, node.blockID);
+                    ChunkUpdater::setCollidable(h, node.blockIndex, node.blockID);
                 }
             }
-
-            if (h->genLevel == GEN_DONE) h->DataChange(h);
-        } else {
-            query->grid->nodeSetter.setNodes(h, GEN_TERRAIN, it.second.wNodes, it.second.fNodes);
         }
+        if (t.placeInbox) VoxelNodeSetter::placeInbox(h);
+    }
+    lock.unlock();
+
+    for (size_t i = 0; i < targets.size(); i++) {
+        ChunkHandle& h = handles[i];
+        if ((targets[i].placeNodes || targets[i].placeInbox) && h->genLevel == GEN_DONE) h->DataChange(h);
         h.release();
     }
 
@@ -7,32 +7,31 @@
 #include "ChunkRenderer.h"
 
 std::vector <Distanceclass> GeometrySorter::_distBuffer;
+std::vector <Distanceclass> GeometrySorter::_tmpBuffer;
 
-i32 convertData(Distanceclass* data) {
-    return data->distance;
-}
-
-bool comparator(const Distanceclass& i, const Distanceclass& j) { 
-    return (i.distance > j.distance); 
-}
-
-void GeometrySorter::sortTransparentBlocks(ChunkMesh* cm, const i32v3& cameraPos) {
+bool GeometrySorter::sortTransparentBlocks(ChunkMesh* cm, const i32v3& cameraPos) {
+    // Order can only change when the camera crosses a voxel boundary
+    if (!cm->needsSort && cm->sortPosition == cameraPos) return false;
+    cm->needsSort = false;
+    cm->sortPosition = cameraPos;
 
     _distBuffer.resize(cm->transQuadPositions.size());
 
+    // Quad positions are in the chunk's own axes, so measure from there
+    i32v3 offset = (i32v3(-cm->toChunkSpace(f64v3(cameraPos))) << 1) - 1;
     for (size_t i = 0; i < cm->transQuadPositions.size(); i++) {
         _distBuffer[i].quadIndex = i; 
         //We multiply by 2 because we need twice the precision of integers per block
         //we subtract by 1 in order to ensure that the camera position is centered on a block
-        _distBuffer[i].distance = selfDot(((i32v3(cm->position) - cameraPos) << 1) - 1 + i32v3(cm->transQuadPositions[i]));
+        _distBuffer[i].distance = selfDot(offset + i32v3(cm->transQuadPositions[i]));
     }
 
-   // radixSort<Distanceclass, 8>(&(_distBuffer[0]), _distBuffer.size(), convertData, 31);
-    std::sort(_distBuffer.begin(), _distBuffer.end(), comparator);
+    radixSort(_distBuffer, _tmpBuffer);
 
+    // Back to front
     int startIndex;
     int j = 0;
-    for (size_t i = 0; i < _distBuffer.size(); i++) {
+    for (size_t i = _distBuffer.size(); i-- > 0;) {
         startIndex = _distBuffer[i].quadIndex * 4;
         cm->transQuadIndices[j] = startIndex;
         cm->transQuadIndices[j + 1] = startIndex + 1;
@@ -42,4 +41,37 @@ void GeometrySorter::sortTransparentBlocks(ChunkMesh* cm, const i32v3& cameraPos
         cm->transQuadIndices[j + 5] = startIndex;
         j += 6;
     }
+    return true;
+}
+
+void GeometrySorter::radixSort(std::vector<Distanceclass>& data, std::vector<Distanceclass>& tmp) {
+    const size_t n = data.size();
+    if (n < 2) return;
+    tmp.resize(n);
+
+    bool inTmp = false;
+    for (ui32 shift = 0; shift < 32; shift += 8) {
+        const Distanceclass* src = inTmp ? tmp.data() : data.data();
+        Distanceclass* dst = inTmp ? data.data() : tmp.data();
+
+        // Distances are squared lengths, so never negative
+        size_t counts[256] = {};
+        for (size_t i = 0; i < n; i++) {
+            counts[((ui32)src[i].distance >> shift) & 0xFF]++;
+        }
+        // Every key has the same byte here, nothing to do
+        if (counts[((ui32)src[0].distance >> shift) & 0xFF] == n) continue;
+
+        size_t total = 0;
+        for (int b = 0; b < 256; b++) {
+            size_t c = counts[b];
+            counts[b] = total;
+            total += c;
+        }
+        for (size_t i = 0; i < n; i++) {
+            dst[counts[((ui32)src[i].distance >> shift) & 0xFF]++] = src[i];
+        }
+        inTmp = !inTmp;
+    }
+    if (inTmp) data.swap(tmp);
 }
\ No newline at end of file
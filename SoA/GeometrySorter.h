@@ -12,10 +12,15 @@ class Distanceclass {
 
 class GeometrySorter {
 public:
-    static void sortTransparentBlocks(ChunkMesh* cm, const i32v3& cameraPos);
+    /// Sorts transparent quads back to front and rewrites cm->transQuadIndices.
+    /// Does nothing if cameraPos matches the position of the last sort.
+    /// @return true if the indices changed and need to be uploaded
+    static bool sortTransparentBlocks(ChunkMesh* cm, const i32v3& cameraPos);
 
 private:
-
+    /// LSD radix sort on distance, ascending. Skips bytes that are equal for every key.
+    static void radixSort(std::vector<Distanceclass>& data, std::vector<Distanceclass>& tmp);
 
     static std::vector <Distanceclass> _distBuffer;
+    static std::vector <Distanceclass> _tmpBuffer;
 };
\ No newline at end of file
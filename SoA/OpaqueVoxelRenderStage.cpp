@@ -31,23 +31,30 @@ void OpaqueVoxelRenderStage::render(const Camera* camera) {
     f64v3 closestPoint;
     static const f64v3 boxDims(CHUNK_WIDTH);
     static const f64v3 boxDims_2(CHUNK_WIDTH / 2);
+    // Cave culling, also used by the cutout, transparent and liquid stages through inFrustum
+    cmm->updateOcclusion(position, m_gameRenderParams->chunkCamera);
+    ui32 occlusionFrame = cmm->getOcclusionFrame();
+
     const std::vector <ChunkMesh *>& chunkMeshes = cmm->getChunkMeshes();
     {
         std::lock_guard<std::mutex> l(cmm->lckActiveChunkMeshes);
         if (chunkMeshes.empty()) return;
+        m_drawList.clear();
         for (int i = chunkMeshes.size() - 1; i >= 0; i--) {
             ChunkMesh* cm = chunkMeshes[i];
 
-            if (m_gameRenderParams->chunkCamera->sphereInFrustum(f32v3(cm->position + boxDims_2 - position), CHUNK_DIAGONAL_LENGTH)) {
+            // Occlusion pass already did the frustum test
+            if (cm->occlusionFrame == occlusionFrame) {
                 // TODO(Ben): Implement perfect fade
                 cm->inFrustum = 1;
-                m_renderer->drawOpaque(cm, position,
-                                       m_gameRenderParams->chunkCamera->getViewProjectionMatrix());
+                m_drawList.addOpaqueFaces(cm, position);
             } else {
                 cm->inFrustum = 0;
             }
         }
     }
+    m_renderer->drawOpaque(m_drawList, cmm->getBufferPool(), position,
+                           m_gameRenderParams->chunkCamera->getViewProjectionMatrix());
     
     m_renderer->end();
 }
@@ -16,11 +16,11 @@
 #define OpaqueVoxelRenderStage_h__
 
 #include "IRenderStage.h"
+#include "ChunkRenderer.h"
 
 #include <Vorb/graphics/GLProgram.h>
 
 class Camera;
-class ChunkRenderer;
 class GameRenderParams;
 class MeshManager;
 
@@ -34,6 +34,7 @@ class OpaqueVoxelRenderStage : public IRenderStage
 private:
     ChunkRenderer* m_renderer;
     const GameRenderParams* m_gameRenderParams; ///< Handle to some shared parameters
+    ChunkDrawList m_drawList; ///< Rebuilt every frame from visible meshes
 };
 
 #endif // OpaqueVoxelRenderStage_h__
\ No newline at end of file
@@ -7,6 +7,7 @@
 #include "TerrainPatch.h"
 #include "VoxelSpaceConversions.h"
 #include "VoxelSpaceUtils.h"
+#include "VoxelSweep.h"
 #include "soaUtils.h"
 
 #include <Vorb/utils.h>
@@ -19,15 +20,44 @@
 
 // TODO(Ben): Timestep
 void PhysicsComponentUpdater::update(GameSystem* gameSystem, SpaceSystem* spaceSystem) {
-  
+    // Sort entities before updating any of them, since transitions add
+    // and remove components.
+    m_spaceEntities.clear();
+    m_voxelEntities.clear();
+    m_exitingEntities.clear();
     for (auto& it : gameSystem->physics) {
         auto& cmp = it.second;
         // Voxel position dictates space position
         if (cmp.voxelPosition) {
-            updateVoxelPhysics(gameSystem, spaceSystem, cmp, it.first);
+            // Check for removal of spherical voxel component
+            auto& spCmp = gameSystem->spacePosition.get(cmp.spacePosition);
+            auto& stCmp = spaceSystem->sphericalTerrain.get(spCmp.parentSphericalTerrain);
+            if (stCmp.sphericalVoxelComponent == 0) {
+                m_exitingEntities.emplace_back(it.first, &cmp);
+            } else {
+                m_voxelEntities.emplace_back(it.first, &cmp);
+            }
         } else {
-            updateSpacePhysics(gameSystem, spaceSystem, cmp, it.first);
-        } 
+            m_spaceEntities.emplace_back(it.first, &cmp);
+        }
+    }
+
+    for (auto& e : m_exitingEntities) {
+        transitionToSpace(gameSystem, *e.cmp, e.entity);
+    }
+    for (auto& e : m_spaceEntities) {
+        updateSpacePhysics(gameSystem, spaceSystem, *e.cmp, e.entity);
+    }
+
+    // Voxel physics is batched
+    m_voxelBatch.clear();
+    for (auto& e : m_voxelEntities) {
+        gatherVoxelPhysics(gameSystem, spaceSystem, *e.cmp, e.entity);
+    }
+    updateGroundGenerated();
+    integrateVoxelPhysics();
+    for (size_t i = 0; i < m_voxelBatch.size(); i++) {
+        scatterVoxelPhysics(i);
     }
 }
 
@@ -38,44 +68,142 @@ f64v3 PhysicsComponentUpdater::calculateGravityAcceleration(f64v3 relativePositi
     return relativePosition * ((fgrav / M_PER_KM) / FPS); // Return acceleration vector
 }
 
-// TODO(Ben): This is a clusterfuck
-void PhysicsComponentUpdater::updateVoxelPhysics(GameSystem* gameSystem, SpaceSystem* spaceSystem,
+void PhysicsComponentUpdater::VoxelPhysicsBatch::clear() {
+    physics.clear();
+    spacePositions.clear();
+    voxelPositions.clear();
+    sphericalVoxels.clear();
+    sphericalTerrains.clear();
+    axisRotations.clear();
+    aabbCollidables.clear();
+    posX.clear();
+    posY.clear();
+    posZ.clear();
+    velX.clear();
+    velY.clear();
+    velZ.clear();
+    gravity.clear();
+    voxelRadius.clear();
+    groundGenerated.clear();
+    grids.clear();
+    chunkIDs.clear();
+    gravityOrder.clear();
+}
+
+void PhysicsComponentUpdater::transitionToSpace(GameSystem* gameSystem, PhysicsComponent& pyCmp, vecs::EntityID entity) {
+    pyCmp.voxelPosition = 0;
+    // TODO(Ben): Orient this
+    pyCmp.velocity = f64v3(0.0);
+    GameSystemAssemblages::removeVoxelPosition(gameSystem, entity);
+    GameSystemAssemblages::removeChunkSphere(gameSystem, entity);
+}
+
+void PhysicsComponentUpdater::gatherVoxelPhysics(GameSystem* gameSystem, SpaceSystem* spaceSystem,
                                                  PhysicsComponent& pyCmp, vecs::EntityID entity) {
+    VoxelPhysicsBatch& b = m_voxelBatch;
 
-    // Get the position component
     auto& spCmp = gameSystem->spacePosition.get(pyCmp.spacePosition);
-    // Check for removal of spherical voxel component
-    auto& stCmp = spaceSystem->sphericalTerrain.get(spCmp.parentSphericalTerrain);
-    if (stCmp.sphericalVoxelComponent == 0) {
-        // We need to transition to space
-        pyCmp.voxelPosition = 0;
-        // TODO(Ben): Orient this
-        pyCmp.velocity = f64v3(0.0);
-        GameSystemAssemblages::removeVoxelPosition(gameSystem, entity);
-        GameSystemAssemblages::removeChunkSphere(gameSystem, entity);
-        return;
-    }
-
     auto& vpcmp = gameSystem->voxelPosition.get(pyCmp.voxelPosition);
     auto& svcmp = spaceSystem->sphericalVoxel.get(vpcmp.parentVoxel);
-    auto& npcmp = spaceSystem->namePosition.get(svcmp.namePositionComponent);
-    auto& arcmp = spaceSystem->axisRotation.get(svcmp.axisRotationComponent);
+    vecs::ComponentID aabbID = gameSystem->aabbCollidable.getComponentID(entity);
 
-    // Apply gravity
+    b.physics.push_back(&pyCmp);
+    b.spacePositions.push_back(&spCmp);
+    b.voxelPositions.push_back(&vpcmp);
+    b.sphericalVoxels.push_back(&svcmp);
+    b.sphericalTerrains.push_back(&spaceSystem->sphericalTerrain.get(spCmp.parentSphericalTerrain));
+    b.axisRotations.push_back(&spaceSystem->axisRotation.get(svcmp.axisRotationComponent));
+    b.aabbCollidables.push_back(aabbID ? &gameSystem->aabbCollidable.get(aabbID) : nullptr);
+
+    const f64v3& pos = vpcmp.gridPosition.pos;
+    b.posX.push_back(pos.x);
+    b.posY.push_back(pos.y);
+    b.posZ.push_back(pos.z);
+    b.velX.push_back(pyCmp.velocity.x);
+    b.velY.push_back(pyCmp.velocity.y);
+    b.velZ.push_back(pyCmp.velocity.z);
+    b.voxelRadius.push_back(svcmp.voxelRadius);
+    b.groundGenerated.push_back(0.0);
+    b.grids.push_back(&svcmp.chunkGrids[vpcmp.gridPosition.face]);
+    b.chunkIDs.push_back(ChunkID(VoxelSpaceConversions::voxelToChunk(vpcmp.gridPosition)));
     if (spCmp.parentGravity) {
-        auto& gravCmp = spaceSystem->sphericalGravity.get(spCmp.parentGravity);
-        f64 height = (vpcmp.gridPosition.pos.y + svcmp.voxelRadius) * M_PER_VOXEL;
-        f64 fgrav = M_G * gravCmp.mass / (height * height);
-        ChunkID id(VoxelSpaceConversions::voxelToChunk(vpcmp.gridPosition));
-        ChunkHandle chunk = svcmp.chunkGrids[vpcmp.gridPosition.face].accessor.acquire(id);
+        b.gravity.push_back(M_G * spaceSystem->sphericalGravity.get(spCmp.parentGravity).mass);
+        b.gravityOrder.push_back((ui32)b.size() - 1);
+    } else {
+        b.gravity.push_back(0.0);
+    }
+}
+
+void PhysicsComponentUpdater::updateGroundGenerated() {
+    VoxelPhysicsBatch& b = m_voxelBatch;
+
+    // Entities standing in the same chunk end up next to each other
+    std::sort(b.gravityOrder.begin(), b.gravityOrder.end(), [&b](ui32 l, ui32 r) {
+        if (b.grids[l] != b.grids[r]) return b.grids[l] < b.grids[r];
+        return b.chunkIDs[l] < b.chunkIDs[r];
+    });
+
+    size_t i = 0;
+    while (i < b.gravityOrder.size()) {
+        ui32 first = b.gravityOrder[i];
+        ChunkHandle chunk = b.grids[first]->accessor.acquire(ChunkID(b.chunkIDs[first]));
         // Don't apply gravity in non generated chunks.
-        if (chunk->genLevel == GEN_DONE) {
-            pyCmp.velocity.y -= (fgrav * 0.1) / FPS;
-        }
+        f64 generated = (chunk->genLevel == GEN_DONE) ? 1.0 : 0.0;
         chunk.release();
+        for (; i < b.gravityOrder.size(); i++) {
+            ui32 e = b.gravityOrder[i];
+            if (b.grids[e] != b.grids[first] || b.chunkIDs[e] != b.chunkIDs[first]) break;
+            b.groundGenerated[e] = generated;
+        }
     }
+}
+
+void PhysicsComponentUpdater::integrateVoxelPhysics() {
+    VoxelPhysicsBatch& b = m_voxelBatch;
+    const size_t n = b.size();
+    const f64 GRAVITY_SCALE = 0.1 / FPS;
+
+    // Kept branch free so they vectorize
+    f64* posX = b.posX.data();
+    f64* posY = b.posY.data();
+    f64* posZ = b.posZ.data();
+    const f64* velX = b.velX.data();
+    f64* velY = b.velY.data();
+    const f64* velZ = b.velZ.data();
+    const f64* gravity = b.gravity.data();
+    const f64* radius = b.voxelRadius.data();
+    const f64* generated = b.groundGenerated.data();
+    for (size_t i = 0; i < n; i++) {
+        f64 height = (posY[i] + radius[i]) * M_PER_VOXEL;
+        velY[i] -= generated[i] * gravity[i] / (height * height) * GRAVITY_SCALE;
+    }
+    for (size_t i = 0; i < n; i++) {
+        posX[i] += velX[i];
+        posY[i] += velY[i];
+        posZ[i] += velZ[i];
+    }
+}
+
+// TODO(Ben): This is a clusterfuck
+void PhysicsComponentUpdater::scatterVoxelPhysics(size_t i) {
+    VoxelPhysicsBatch& b = m_voxelBatch;
+    auto& pyCmp = *b.physics[i];
+    auto& spCmp = *b.spacePositions[i];
+    auto& vpcmp = *b.voxelPositions[i];
+    auto& svcmp = *b.sphericalVoxels[i];
+    auto& arcmp = *b.axisRotations[i];
+
+    pyCmp.velocity.y = b.velY[i];
     // Update position
-    vpcmp.gridPosition.pos += pyCmp.velocity;
+    if (b.aabbCollidables[i]) {
+        // Sweep the box so fast movement can't tunnel through thin walls
+        auto& aabbCmp = *b.aabbCollidables[i];
+        f64v3 boxMin = vpcmp.gridPosition.pos + f64v3(aabbCmp.offset - aabbCmp.box * 0.5f);
+        vpcmp.gridPosition.pos += VoxelSweep::moveAndSlide(*b.grids[i], boxMin, f64v3(aabbCmp.box),
+                                                           pyCmp.velocity, pyCmp.velocity);
+    } else {
+        vpcmp.gridPosition.pos = f64v3(b.posX[i], b.posY[i], b.posZ[i]);
+    }
     // Store old position in case of transition
     VoxelPositionComponent oldVPCmp = vpcmp;
     SpacePositionComponent oldSPCmp = spCmp;
@@ -105,7 +233,7 @@ void PhysicsComponentUpdater::updateVoxelPhysics(GameSystem* gameSystem, SpaceSy
     // Check transitions
     // TODO(Ben): This assumes a single player entity!
     if (spCmp.parentSphericalTerrain) {
-        auto& stCmp = spaceSystem->sphericalTerrain.get(spCmp.parentSphericalTerrain);
+        auto& stCmp = *b.sphericalTerrains[i];
 
         f64 distance = vmath::length(spCmp.position);
         // Check transition to Space
@@ -134,7 +262,7 @@ void PhysicsComponentUpdater::updateVoxelPhysics(GameSystem* gameSystem, SpaceSy
         }
     } else {
         // This really shouldn't happen
-        std::cerr << "Missing parent spherical terrain ID in updateVoxelPhysics\n";
+        std::cerr << "Missing parent spherical terrain ID in scatterVoxelPhysics\n";
     }
 }
 
@@ -15,9 +15,15 @@
 #ifndef PhysicsComponentUpdater_h__
 #define PhysicsComponentUpdater_h__
 
+class ChunkGrid;
 class GameSystem;
 class SpaceSystem;
+struct AabbCollidableComponent;
+struct AxisRotationComponent;
 struct PhysicsComponent;
+struct SpacePositionComponent;
+struct SphericalTerrainComponent;
+struct SphericalVoxelComponent;
 struct VoxelPositionComponent;
 
 #include <Vorb/ecs/ECS.h>
@@ -36,15 +42,56 @@ class PhysicsComponentUpdater {
     /// @return the acceleration vector
     static f64v3 calculateGravityAcceleration(f64v3 relativePosition, f64 mass);
 private:
-    void updateVoxelPhysics(GameSystem* gameSystem, SpaceSystem* spaceSystem,
-                            PhysicsComponent& pyCmp, vecs::EntityID entity);
+    struct PhysicsEntity {
+        PhysicsEntity(vecs::EntityID Entity, PhysicsComponent* Cmp) : entity(Entity), cmp(Cmp) {}
+        vecs::EntityID entity;
+        PhysicsComponent* cmp;
+    };
+
+    /// Voxel physics entities gathered for one update. Components are looked
+    /// up once, and the integrated fields are stored as parallel arrays so
+    /// the integration loops vectorize.
+    struct VoxelPhysicsBatch {
+        void clear();
+        size_t size() const { return physics.size(); }
+
+        // Per entity components
+        std::vector<PhysicsComponent*> physics;
+        std::vector<SpacePositionComponent*> spacePositions;
+        std::vector<VoxelPositionComponent*> voxelPositions;
+        std::vector<SphericalVoxelComponent*> sphericalVoxels;
+        std::vector<SphericalTerrainComponent*> sphericalTerrains;
+        std::vector<AxisRotationComponent*> axisRotations;
+        std::vector<AabbCollidableComponent*> aabbCollidables; ///< Null if not collidable
+        // Integrated fields
+        std::vector<f64> posX, posY, posZ;
+        std::vector<f64> velX, velY, velZ;
+        std::vector<f64> gravity; ///< G * mass of the parent, 0 if there is none
+        std::vector<f64> voxelRadius;
+        std::vector<f64> groundGenerated; ///< 1.0 if the chunk the entity is in is generated
+        // Ground chunk of each entity with gravity, sorted so each chunk is acquired once
+        std::vector<ChunkGrid*> grids;
+        std::vector<ui64> chunkIDs;
+        std::vector<ui32> gravityOrder;
+    };
+
+    void transitionToSpace(GameSystem* gameSystem, PhysicsComponent& pyCmp, vecs::EntityID entity);
+    void gatherVoxelPhysics(GameSystem* gameSystem, SpaceSystem* spaceSystem, PhysicsComponent& pyCmp, vecs::EntityID entity);
+    /// Checks which ground chunks are generated, acquiring each one once
+    void updateGroundGenerated();
+    void integrateVoxelPhysics();
+    void scatterVoxelPhysics(size_t i);
     void updateSpacePhysics(GameSystem* gameSystem, SpaceSystem* spaceSystem,
                             PhysicsComponent& pyCmp, vecs::EntityID entity);
     void transitionPosX(VoxelPositionComponent& vpCmp, PhysicsComponent& pyCmp, float voxelRadius);
     void transitionNegX(VoxelPositionComponent& vpCmp, PhysicsComponent& pyCmp, float voxelRadius);
     void transitionPosZ(VoxelPositionComponent& vpCmp, PhysicsComponent& pyCmp, float voxelRadius);
     void transitionNegZ(VoxelPositionComponent& vpCmp, PhysicsComponent& pyCmp, float voxelRadius);
-    
+
+    std::vector<PhysicsEntity> m_spaceEntities;
+    std::vector<PhysicsEntity> m_voxelEntities;
+    std::vector<PhysicsEntity> m_exitingEntities; ///< Voxel entities whose planet lost its voxels
+    VoxelPhysicsBatch m_voxelBatch;
 };
 
 #endif // PhysicsComponentUpdater_h__
@@ -13,6 +13,7 @@ void ProceduralChunkGenerator::init(PlanetGenData* genData) {
 }
 
 void ProceduralChunkGenerator::generateChunk(Chunk* chunk, PlanetHeightData* heightData) const {
+    chunk->initLight();
 
     int temperature;
     int rainfall;
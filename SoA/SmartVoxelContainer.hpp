@@ -151,7 +151,8 @@ namespace vorb {
                 }
             }
 
-            inline void changeState(VoxelStorageState newState, std::mutex& dataLock) {
+            template <typename Mutex>
+            inline void changeState(VoxelStorageState newState, Mutex& dataLock) {
                 if (newState == _state) return;
                 if (newState == VoxelStorageState::INTERVAL_TREE) {
                     compress(dataLock);
@@ -164,7 +165,8 @@ namespace vorb {
 
             /// Updates the container. Call once per frame
             /// @param dataLock: The mutex that guards the data
-            inline void update(std::mutex& dataLock) {
+            template <typename Mutex>
+            inline void update(Mutex& dataLock) {
                 // If access count is higher than the threshold, this is not a quiet frame
                 if (_accessCount >= ACCESS_COUNT_UNTIL_DECOMPRESS) {
                     _quietFrames = 0;
@@ -254,7 +256,8 @@ namespace vorb {
             static Getter getters[2];
             static Setter setters[2];
 
-            inline void uncompress(std::mutex& dataLock) {
+            template <typename Mutex>
+            inline void uncompress(Mutex& dataLock) {
                 dataLock.lock();
                 _dataArray = _arrayRecycler->create();
                 uncompressIntoBuffer(_dataArray);
@@ -264,7 +267,8 @@ namespace vorb {
                 _state = VoxelStorageState::FLAT_ARRAY;
                 dataLock.unlock();
             }
-            inline void compress(std::mutex& dataLock) {
+            template <typename Mutex>
+            inline void compress(Mutex& dataLock) {
                 dataLock.lock();
                 // Sorted array for creating the interval tree
                 // Using stack array to avoid allocations, beware stack overflow
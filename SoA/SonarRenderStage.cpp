@@ -48,15 +48,17 @@ void SonarRenderStage::render(const Camera* camera) {
     glDisable(GL_CULL_FACE);
     glDepthMask(GL_FALSE);
     const std::vector <ChunkMesh *>& chunkMeshes = cmm->getChunkMeshes();
+    const f64v3& cameraPos = m_gameRenderParams->chunkCamera->getPosition();
     {
         std::lock_guard<std::mutex> l(cmm->lckActiveChunkMeshes);
         if (chunkMeshes.empty()) return;
+        m_drawList.clear();
         for (unsigned int i = 0; i < chunkMeshes.size(); i++) {
-            ChunkRenderer::drawOpaqueCustom(chunkMeshes[i], m_program,
-                                            m_gameRenderParams->chunkCamera->getPosition(),
-                                            m_gameRenderParams->chunkCamera->getViewProjectionMatrix());
+            m_drawList.addOpaqueFaces(chunkMeshes[i], cameraPos);
         }
     }
+    ChunkRenderer::drawListCustom(m_drawList, cmm->getBufferPool(), m_program, cameraPos,
+                                  m_gameRenderParams->chunkCamera->getViewProjectionMatrix());
 
     glDepthMask(GL_TRUE);
     glEnable(GL_CULL_FACE);
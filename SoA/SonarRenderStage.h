@@ -16,6 +16,7 @@
 #define SonarRenderStage_h__
 
 #include "IRenderStage.h"
+#include "ChunkRenderer.h"
 
 #include <Vorb/graphics/GLProgram.h>
 
@@ -36,6 +37,7 @@ class SonarRenderStage : public IRenderStage
 private:
     vg::GLProgram m_program;
     const GameRenderParams* m_gameRenderParams; ///< Handle to shared parameters
+    ChunkDrawList m_drawList;
 };
 
 #endif // SonarRenderStage_h__
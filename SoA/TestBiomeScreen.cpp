@@ -257,7 +257,8 @@ void TestBiomeScreen::draw(const vui::GameTime& gameTime) {
 
 void TestBiomeScreen::initHeightData() {
     printf("Generating height data...\n");
-    m_heightData.resize(HORIZONTAL_CHUNKS * HORIZONTAL_CHUNKS);
+    // ChunkGridData holds a mutex so it can't live in a vector
+    if (!m_heightData) m_heightData = std::make_unique<ChunkGridData[]>(HORIZONTAL_CHUNKS * HORIZONTAL_CHUNKS);
     // Init height data
     m_heightGenerator.init(m_genData);
     for (int z = 0; z < HORIZONTAL_CHUNKS; z++) {
@@ -280,9 +281,9 @@ void TestBiomeScreen::initHeightData() {
     // Get center height
     f32 cHeight = m_heightData[HORIZONTAL_CHUNKS * HORIZONTAL_CHUNKS / 2].heightData[CHUNK_LAYER / 2].height;
     // Center the heightmap
-    for (auto& hd : m_heightData) {
+    for (int c = 0; c < HORIZONTAL_CHUNKS * HORIZONTAL_CHUNKS; c++) {
         for (int i = 0; i < CHUNK_LAYER; i++) {
-            hd.heightData[i].height -= cHeight;
+            m_heightData[c].heightData[i].height -= cHeight;
         }
     }
 }
@@ -317,41 +318,34 @@ void TestBiomeScreen::initChunks() {
     }
 
     // Generate flora
-    std::vector<FloraNode> lNodes;
-    std::vector<FloraNode> wNodes;
+    FloraNodeBuckets buckets;
     // TODO(Ben): I know this is ugly
     PreciseTimer t1;
     t1.start();
     for (size_t i = 0; i < m_chunks.size(); i++) {
         Chunk* chunk = m_chunks[i].chunk;
-        m_floraGenerator.generateChunkFlora(chunk, m_heightData[i % (HORIZONTAL_CHUNKS * HORIZONTAL_CHUNKS)].heightData, lNodes, wNodes);
-        for (auto& node : wNodes) {
+        m_floraGenerator.generateChunkFlora(chunk, m_heightData[i % (HORIZONTAL_CHUNKS * HORIZONTAL_CHUNKS)].heightData, buckets);
+        for (size_t j = 0; j < buckets.size(); j++) {
+            const FloraNodeBucket& bucket = buckets[j];
             i32v3 gridPos = m_chunks[i].gridPosition;
-            gridPos.x += FloraGenerator::getChunkXOffset(node.chunkOffset);
-            gridPos.y += FloraGenerator::getChunkYOffset(node.chunkOffset);
-            gridPos.z += FloraGenerator::getChunkZOffset(node.chunkOffset);
+            gridPos.x += FloraGenerator::getChunkXOffset(bucket.chunkOffset);
+            gridPos.y += FloraGenerator::getChunkYOffset(bucket.chunkOffset);
+            gridPos.z += FloraGenerator::getChunkZOffset(bucket.chunkOffset);
             if (gridPos.x >= 0 && gridPos.y >= 0 && gridPos.z >= 0
                 && gridPos.x < HORIZONTAL_CHUNKS && gridPos.y < VERTICAL_CHUNKS && gridPos.z < HORIZONTAL_CHUNKS) {
                 Chunk* chunk = m_chunks[gridPos.x + gridPos.y * HORIZONTAL_CHUNKS * HORIZONTAL_CHUNKS + gridPos.z * HORIZONTAL_CHUNKS].chunk;
-                chunk->blocks.set(node.blockIndex, node.blockID);
-            }
-        }
-        for (auto& node : lNodes) {
-            i32v3 gridPos = m_chunks[i].gridPosition;
-            gridPos.x += FloraGenerator::getChunkXOffset(node.chunkOffset);
-            gridPos.y += FloraGenerator::getChunkYOffset(node.chunkOffset);
-            gridPos.z += FloraGenerator::getChunkZOffset(node.chunkOffset);
-            if (gridPos.x >= 0 && gridPos.y >= 0 && gridPos.z >= 0
-                && gridPos.x < HORIZONTAL_CHUNKS && gridPos.y < VERTICAL_CHUNKS && gridPos.z < HORIZONTAL_CHUNKS) {
-                Chunk* chunk = m_chunks[gridPos.x + gridPos.y * HORIZONTAL_CHUNKS * HORIZONTAL_CHUNKS + gridPos.z * HORIZONTAL_CHUNKS].chunk;
-                if (chunk->blocks.get(node.blockIndex) == 0) {
+                for (auto& node : bucket.wNodes) {
                     chunk->blocks.set(node.blockIndex, node.blockID);
                 }
+                for (auto& node : bucket.fNodes) {
+                    if (chunk->blocks.get(node.blockIndex) == 0) {
+                        chunk->blocks.set(node.blockIndex, node.blockID);
+                    }
+                }
             }
         }
         std::vector<ui16>().swap(chunk->floraToGenerate);
-        lNodes.clear();
-        wNodes.clear();
+        buckets.clear();
     }
     printf("Tree Gen Time %lf\n", t1.stop());
 
@@ -466,6 +460,8 @@ void TestBiomeScreen::initInput() {
                 SoaEngine::initVoxelGen(m_genData, m_soaState->blocks);
 
                 m_chunkGenerator.init(m_genData);
+                // Templates point at the old tree types
+                m_floraGenerator.clearTreeTemplates();
 
                 for (auto& cv : m_chunks) {
                     m_mesher.freeChunkMesh(cv.chunkMesh);
@@ -68,7 +68,7 @@ class TestBiomeScreen : public vui::IAppScreen < App > {
     vg::SpriteFont m_font;
 
     std::vector <ViewableChunk> m_chunks;
-    std::vector <ChunkGridData> m_heightData;
+    std::unique_ptr<ChunkGridData[]> m_heightData;
     vcore::FixedSizeArrayRecycler<CHUNK_SIZE, ui16> m_blockArrayRecycler;
 
     vg::GBuffer m_hdrTarget; ///< Framebuffer needed for the HDR rendering
@@ -32,31 +32,18 @@ void TransparentVoxelRenderStage::render(const Camera* camera) {
 
     f64v3 cpos;
 
-    static i32v3 oldPos = i32v3(0);
-    bool sort = false;
-
     i32v3 intPosition(fastFloor(position.x), fastFloor(position.y), fastFloor(position.z));
-
-    if (oldPos != intPosition) {
-        //sort the geometry
-        sort = true;
-        oldPos = intPosition;
-    }
     const std::vector <ChunkMesh *>& chunkMeshes = cmm->getChunkMeshes();
     {
         std::lock_guard<std::mutex> l(cmm->lckActiveChunkMeshes);
         if (chunkMeshes.empty()) return;
         for (size_t i = 0; i < chunkMeshes.size(); i++) {
             ChunkMesh* cm = chunkMeshes[i];
-            if (sort) cm->needsSort = true;
 
             if (cm->inFrustum) {
                 // TODO(Ben): We should probably do this outside of a lock
-                if (cm->needsSort) {
-                    cm->needsSort = false;
-                    if (cm->transQuadIndices.size() != 0) {
-                        GeometrySorter::sortTransparentBlocks(cm, intPosition);
-
+                if (cm->transQuadIndices.size() != 0) {
+                    if (GeometrySorter::sortTransparentBlocks(cm, intPosition)) {
                         //update index data buffer
                         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cm->transIndexID);
                         glBufferData(GL_ELEMENT_ARRAY_BUFFER, cm->transQuadIndices.size() * sizeof(ui32), NULL, GL_STATIC_DRAW);
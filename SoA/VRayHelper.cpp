@@ -10,6 +10,32 @@ bool solidVoxelPredBlock(const Block& block) {
     return block.collide == true;
 }
 
+bool VRayHelper::testVoxel(const Chunk* chunk, ui16 voxelIndex, const BlockPack* blockPack, PredBlock f, OUT BlockID& id) {
+    // Solid tests only read the collidable mask, so the block data is
+    // only touched for the voxel that is hit
+    if (f == &solidVoxelPredBlock) {
+        if (!chunk->collidable.get(voxelIndex)) return false;
+        id = chunk->blocks.get(voxelIndex);
+        return true;
+    }
+    id = chunk->blocks.get(voxelIndex);
+    return f(blockPack->operator[](id));
+}
+
+i32 VRayHelper::getSkipWidth(const Chunk* chunk, bool locked, bool solidTest, bool airMatches, const i32v3& relativeLocation) {
+    // Nothing to hit in chunks that aren't loaded
+    if (!locked) return CHUNK_WIDTH;
+    if (solidTest) {
+        if (chunk->collidable.empty()) return CHUNK_WIDTH;
+        if (chunk->collidable.isBrickEmpty(relativeLocation.x & 0x1f, relativeLocation.y & 0x1f, relativeLocation.z & 0x1f)) {
+            return COLLISION_BRICK_WIDTH;
+        }
+        return 1;
+    }
+    if (chunk->numBlocks == 0 && !airMatches) return CHUNK_WIDTH;
+    return 1;
+}
+
 const VoxelRayQuery VRayHelper::getQuery(const f64v3& pos, const f32v3& dir, f64 maxDistance, ChunkGrid& cg, PredBlock f) {
 
     // Set the ray coordinates
@@ -28,6 +54,10 @@ const VoxelRayQuery VRayHelper::getQuery(const f64v3& pos, const f32v3& dir, f64
     // Chunk position
     i32v3 chunkPos;
 
+    // Empty chunks and bricks are skipped whole when the test can't match air
+    bool solidTest = (f == &solidVoxelPredBlock);
+    bool airMatches = !solidTest && f(cg.blockPack->operator[](0));
+
     // TODO: Use A Bounding Box Intersection First And Allow Traversal Beginning Outside The Voxel World
 
     // Keep track of the previous chunk for locking
@@ -46,42 +76,43 @@ const VoxelRayQuery VRayHelper::getQuery(const f64v3& pos, const f32v3& dir, f64
             query.chunkID = id;
             if (chunk.isAquired()) {
                 if (locked) {
-                    chunk->dataMutex.unlock();
+                    chunk->dataMutex.unlock_shared();
                     locked = false;
                 }
                 chunk.release();
             }
             chunk = cg.accessor.acquire(id);
             if (chunk->isAccessible) {
-                chunk->dataMutex.lock();
+                chunk->dataMutex.lock_shared();
                 locked = true;
             }
         }
-        
-        if (locked) {
+
+        i32 skipWidth = getSkipWidth(chunk, locked, solidTest, airMatches, relativeLocation);
+        if (skipWidth == 1) {
             // Calculate Voxel Index
             query.voxelIndex =
                 (relativeLocation.x & 0x1f) +
                 (relativeLocation.y & 0x1f) * CHUNK_LAYER +
                 (relativeLocation.z & 0x1f) * CHUNK_WIDTH;
 
-            // Get Block ID
-            query.id = chunk->blocks.get(query.voxelIndex);
-
-            // Check For The Block ID
-            if (f(cg.blockPack->operator[](query.id))) {
-                if (locked) chunk->dataMutex.unlock();
+            // Check The Voxel
+            if (testVoxel(chunk, query.voxelIndex, cg.blockPack, f, query.id)) {
+                chunk->dataMutex.unlock_shared();
                 chunk.release();
                 return query;
             }
+
+            // Traverse To The Next
+            query.location = vr.getNextVoxelPosition();
+        } else {
+            // Skip The Empty Cell
+            query.location = vr.skipCell(skipWidth);
         }
-        
-        // Traverse To The Next
-        query.location = vr.getNextVoxelPosition();
         query.distance = vr.getDistanceTraversed();
     }
     if (chunk.isAquired()) {
-        if (locked) chunk->dataMutex.unlock();
+        if (locked) chunk->dataMutex.unlock_shared();
         chunk.release();
     }
     return query;
@@ -103,6 +134,10 @@ const VoxelRayFullQuery VRayHelper::getFullQuery(const f64v3& pos, const f32v3&
 
     i32v3 chunkPos;
 
+    // Empty chunks and bricks are skipped whole when the test can't match air
+    bool solidTest = (f == &solidVoxelPredBlock);
+    bool airMatches = !solidTest && f(cg.blockPack->operator[](0));
+
     // TODO: Use A Bounding Box Intersection First And Allow Traversal Beginning Outside The Voxel World
 
     // Keep track of the previous chunk for locking
@@ -120,48 +155,71 @@ const VoxelRayFullQuery VRayHelper::getFullQuery(const f64v3& pos, const f32v3&
             query.inner.chunkID = id;
             if (chunk.isAquired()) {
                 if (locked) {
-                    chunk->dataMutex.unlock();
+                    chunk->dataMutex.unlock_shared();
                     locked = false;
                 }
                 chunk.release();
             }
             chunk = cg.accessor.acquire(id);
             if (chunk->isAccessible) {
-                chunk->dataMutex.lock();
+                chunk->dataMutex.lock_shared();
                 locked = true;
             }
         }
-       
-        if (locked) {
-            relativeLocation = query.inner.location - relativeChunkSpot;
+
+        relativeLocation = query.inner.location - relativeChunkSpot;
+        i32 skipWidth = getSkipWidth(chunk, locked, solidTest, airMatches, relativeLocation);
+        if (skipWidth == 1) {
             // Calculate Voxel Index
             query.inner.voxelIndex =
                 (relativeLocation.x & 0x1f) +
                 (relativeLocation.y & 0x1f) * CHUNK_LAYER +
                 (relativeLocation.z & 0x1f) * CHUNK_WIDTH;
 
-            // Get Block ID
-            query.inner.id = chunk->blocks.get(query.inner.voxelIndex);
-
-            // Check For The Block ID
-            if (f(cg.blockPack->operator[](query.inner.id))) {
-                if (locked) chunk->dataMutex.unlock();
+            // Check The Voxel
+            if (testVoxel(chunk, query.inner.voxelIndex, cg.blockPack, f, query.inner.id)) {
+                chunk->dataMutex.unlock_shared();
                 chunk.release();
                 return query;
             }
 
             // Refresh Previous Query
             query.outer = query.inner;
+
+            // Traverse To The Next
+            query.inner.location = vr.getNextVoxelPosition();
+        } else {
+            // Skip The Empty Cell
+            i32v3 cellStart = query.inner.location;
+            query.inner.location = vr.skipCell(skipWidth);
+
+            // The Previous Voxel Is The Last One In The Cell, Back One Step On The Axis That Left It
+            i32v3 prev = query.inner.location;
+            for (int i = 0; i < 3; i++) {
+                i32 lo = cellStart[i] & ~(skipWidth - 1);
+                if (prev[i] < lo) {
+                    prev[i]++;
+                    break;
+                } else if (prev[i] >= lo + skipWidth) {
+                    prev[i]--;
+                    break;
+                }
+            }
+            i32v3 prevRelative = prev - relativeChunkSpot;
+            query.outer.location = prev;
+            query.outer.distance = vr.getDistanceTraversed();
+            query.outer.chunkID = ChunkID(VoxelSpaceConversions::voxelToChunk(prev));
+            query.outer.voxelIndex =
+                (prevRelative.x & 0x1f) +
+                (prevRelative.y & 0x1f) * CHUNK_LAYER +
+                (prevRelative.z & 0x1f) * CHUNK_WIDTH;
+            query.outer.id = 0;
         }
-       
-        // Traverse To The Next
-        query.inner.location = vr.getNextVoxelPosition();
         query.inner.distance = vr.getDistanceTraversed();
     }
     if (chunk.isAquired()) {
-        if (locked) chunk->dataMutex.unlock();
+        if (locked) chunk->dataMutex.unlock_shared();
         chunk.release();
     }
     return query;
 }
-
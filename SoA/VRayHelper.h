@@ -1,4 +1,5 @@
 #pragma once
+class BlockPack;
 class ChunkGrid;
 class Chunk;
 
@@ -12,7 +13,7 @@ extern bool solidVoxelPredBlock(const Block& block);
 // Queryable Information
 class VoxelRayQuery {
 public:
-    // Block ID
+    // Block ID. With the default solid test, only set for the hit voxel.
     BlockID id;
 
     // Location Of The Picked Block
@@ -40,4 +41,10 @@ class VRayHelper {
 
     // Resolve A Voxel Query Keeping Previous Query Information
     static const VoxelRayFullQuery getFullQuery(const f64v3& pos, const f32v3& dir, f64 maxDistance, ChunkGrid& cm, PredBlock f = &solidVoxelPredBlock);
+
+    // Test A Voxel In A Read Locked Chunk, Sets id On A Hit
+    static bool testVoxel(const Chunk* chunk, ui16 voxelIndex, const BlockPack* blockPack, PredBlock f, OUT BlockID& id);
+
+    // Width Of The Empty Cell Around The Voxel That A Ray Can Skip In One Step, Or 1 If The Voxel Must Be Tested
+    static i32 getSkipWidth(const Chunk* chunk, bool locked, bool solidTest, bool airMatches, const i32v3& relativeLocation);
 };
\ No newline at end of file
@@ -8,4 +8,5 @@
 WorkerData::~WorkerData() {
     delete chunkMesher;
     delete voxelLightEngine;
+    delete caEngine;
 }
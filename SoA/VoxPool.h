@@ -15,6 +15,8 @@
 #ifndef VoxPool_h__
 #define VoxPool_h__
 
+#include <random>
+
 #include <Vorb/ThreadPool.h>
 
 // Worker data for a threadPool
@@ -29,6 +31,8 @@ class WorkerData {
     class TerrainPatchMesher* terrainMesher = nullptr;
     class FloraGenerator* floraGenerator = nullptr;
     class VoxelLightEngine* voxelLightEngine = nullptr;
+    class CAEngine* caEngine = nullptr;
+    std::mt19937 randomEngine = std::mt19937(std::random_device()()); ///< For random block ticks
 };
 
 typedef vcore::ThreadPool<WorkerData> VoxPool;
@@ -0,0 +1,128 @@
+#include "stdafx.h"
+#include "VoxelEditBatch.h"
+
+#include "BlockPack.h"
+#include "CAEngine.h"
+#include "Chunk.h"
+#include "ChunkGrid.h"
+#include "ChunkUpdater.h"
+#include "VoxelSpaceConversions.h"
+#include "VoxelUtils.h"
+
+void VoxelEditBatch::setBlock(const i32v3& voxelPosition, ui16 blockID) {
+    i32v3 chunkPos = VoxelSpaceConversions::voxelToChunk(voxelPosition);
+    i32v3 pos = voxelPosition - chunkPos * CHUNK_WIDTH;
+    setBlock(ChunkID(chunkPos), (ui16)(pos.x + pos.y * CHUNK_LAYER + pos.z * CHUNK_WIDTH), blockID);
+}
+
+void VoxelEditBatch::setBlock(const ChunkID& chunkID, ui16 blockIndex, ui16 blockID) {
+    m_edits.push_back({ chunkID, blockIndex, blockID, (ui32)m_edits.size() });
+}
+
+size_t VoxelEditBatch::commit(ChunkGrid& grid) {
+    // Group by chunk, and by voxel within a chunk so each voxel is visited once
+    std::sort(m_edits.begin(), m_edits.end(), [](const VoxelEdit& a, const VoxelEdit& b) {
+        if (a.chunkID.id != b.chunkID.id) return a.chunkID.id < b.chunkID.id;
+        if (a.blockIndex != b.blockIndex) return a.blockIndex < b.blockIndex;
+        return a.order < b.order;
+    });
+
+    size_t numChanged = 0;
+    size_t begin = 0;
+    while (begin < m_edits.size()) {
+        size_t end = begin + 1;
+        while (end < m_edits.size() && m_edits[end].chunkID.id == m_edits[begin].chunkID.id) end++;
+
+        ChunkHandle chunk = grid.accessor.acquire(m_edits[begin].chunkID);
+        if (chunk->isAccessible) {
+            size_t chunkChanged = 0;
+            ui8 changedFaces;
+            {
+                ChunkWriteLock l(chunk->dataMutex);
+                changedFaces = applyEdits(chunk, grid.blockPack, begin, end, chunkChanged);
+            }
+            if (chunkChanged) {
+                numChanged += chunkChanged;
+                if (m_lightMessages.size()) {
+                    VoxelLightEngine::postMessages(chunk, m_lightMessages);
+                    m_lightMessages.clear();
+                }
+                if (chunk->genLevel == GEN_DONE) chunk->DataChange(chunk);
+                // Neighbors cull their faces against ours, so they remesh too
+                for (int face = 0; face < 6; face++) {
+                    if (!(changedFaces & (1 << face)) || !chunk->neighbors[face].isAquired()) continue;
+                    ChunkHandle neighbor = chunk->neighbors[face].acquire();
+                    if (neighbor->genLevel == GEN_DONE) neighbor->DataChange(neighbor);
+                    neighbor.release();
+                }
+            }
+        }
+        chunk.release();
+        begin = end;
+    }
+    m_edits.clear();
+    return numChanged;
+}
+
+ui8 VoxelEditBatch::applyEdits(Chunk* chunk, const BlockPack* blocks, size_t begin, size_t end, size_t& numChanged) {
+    ui8 changedFaces = 0;
+    // Write into a flat copy if the tree would take too many insertions
+    bool rebuild = end - begin >= VOXEL_EDIT_BATCH_REBUILD_THRESHOLD &&
+        chunk->blocks.getState() == vvox::VoxelStorageState::INTERVAL_TREE;
+    if (rebuild) {
+        m_buffer.resize(CHUNK_SIZE);
+        chunk->blocks.uncompressIntoBuffer(m_buffer.data());
+    }
+
+    for (size_t i = begin; i < end; i++) {
+        // Only the last edit to each voxel counts
+        if (i + 1 < end && m_edits[i + 1].blockIndex == m_edits[i].blockIndex) continue;
+        const VoxelEdit& edit = m_edits[i];
+
+        ui16 oldID = rebuild ? m_buffer[edit.blockIndex] : chunk->blocks.get(edit.blockIndex);
+        if (oldID == edit.blockID) continue;
+        if (rebuild) {
+            m_buffer[edit.blockIndex] = edit.blockID;
+            if (oldID == 0) {
+                chunk->numBlocks++;
+            } else if (edit.blockID == 0) {
+                chunk->numBlocks--;
+            }
+        } else {
+            chunk->setBlock(edit.blockIndex, edit.blockID);
+        }
+
+        m_lightMessages.emplace_back(LightMessageType::BLOCK_CHANGE, edit.blockIndex, 0);
+        ChunkUpdater::addTickVoxel(chunk, edit.blockIndex, edit.blockID);
+        chunk->collidable.set(edit.blockIndex, blocks->operator[](edit.blockID).collide);
+        for (int face = 0; face < 6; face++) {
+            if (isBlockIndexOnFace(edit.blockIndex, face)) changedFaces |= 1 << face;
+        }
+        numChanged++;
+    }
+
+    if (rebuild) rebuildTree(chunk);
+    // These read the chunk's blocks, so wait until every edit is in
+    for (auto& message : m_lightMessages) {
+        VoxelLightEngine::updateSunHeight(chunk, message.blockIndex, blocks);
+        // Liquids next to the change may be able to flow now
+        CAEngine::activateVoxelAndNeighbors(chunk, message.blockIndex, blocks);
+    }
+    if (numChanged) chunk->flagDirty();
+    return changedFaces;
+}
+
+void VoxelEditBatch::rebuildTree(Chunk* chunk) {
+    m_nodes.clear();
+    m_nodes.emplace_back();
+    m_nodes.back().set(0, 1, m_buffer[0]);
+    for (int i = 1; i < CHUNK_SIZE; i++) {
+        if (m_buffer[i] == m_nodes.back().data) {
+            m_nodes.back().length++;
+        } else {
+            m_nodes.emplace_back();
+            m_nodes.back().set(i, 1, m_buffer[i]);
+        }
+    }
+    chunk->blocks.initFromSortedArray(vvox::VoxelStorageState::INTERVAL_TREE, m_nodes);
+}
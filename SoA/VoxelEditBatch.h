@@ -0,0 +1,68 @@
+///
+/// VoxelEditBatch.h
+/// Seed of Andromeda
+///
+/// Copyright 2014 Regrowth Studios
+/// All Rights Reserved
+///
+/// Summary:
+/// Gathers voxel edits across chunks and applies them with one
+/// lock and one DataChange per chunk.
+///
+
+#pragma once
+
+#ifndef VoxelEditBatch_h__
+#define VoxelEditBatch_h__
+
+#include <Vorb/Voxel/IntervalTree.h>
+
+#include "ChunkID.h"
+#include "Constants.h"
+#include "VoxelLightEngine.h"
+
+class BlockPack;
+class Chunk;
+class ChunkGrid;
+
+// Chunks with at least this many edits get their block tree rebuilt
+// from a flat copy instead of one insertion per voxel
+#define VOXEL_EDIT_BATCH_REBUILD_THRESHOLD CHUNK_LAYER
+
+/// Use for anything that touches more than a handful of voxels, such as
+/// explosions and structure placement. Not thread safe, use one per thread.
+class VoxelEditBatch {
+public:
+    /// Queues a block at a voxel position in the grid. If the same voxel
+    /// is set more than once, the last edit wins.
+    void setBlock(const i32v3& voxelPosition, ui16 blockID);
+    void setBlock(const ChunkID& chunkID, ui16 blockIndex, ui16 blockID);
+
+    /// Applies all edits and clears the batch. Edits to chunks that aren't
+    /// accessible are dropped.
+    /// @return Number of voxels that changed
+    size_t commit(ChunkGrid& grid);
+
+    void clear() { m_edits.clear(); }
+    size_t size() const { return m_edits.size(); }
+    bool empty() const { return m_edits.empty(); }
+private:
+    struct VoxelEdit {
+        ChunkID chunkID;
+        ui16 blockIndex;
+        ui16 blockID;
+        ui32 order; ///< So later edits to a voxel win after sorting
+    };
+
+    /// Applies edits [begin, end), which all belong to the chunk. Chunk must be locked.
+    /// @return Bit per face whose neighbor meshes with a changed voxel
+    ui8 applyEdits(Chunk* chunk, const BlockPack* blocks, size_t begin, size_t end, size_t& numChanged);
+    void rebuildTree(Chunk* chunk);
+
+    std::vector<VoxelEdit> m_edits;
+    std::vector<LightMessage> m_lightMessages;
+    std::vector<ui16> m_buffer; ///< Flat copy of a chunk for large edits
+    std::vector<IntervalTree<ui16>::LNode> m_nodes;
+};
+
+#endif // VoxelEditBatch_h__
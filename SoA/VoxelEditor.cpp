@@ -4,10 +4,7 @@
 #include "BlockData.h"
 #include "Chunk.h"
 #include "ChunkGrid.h"
-#include "ChunkUpdater.h"
 #include "Item.h"
-#include "VoxelNavigation.inl"
-#include "VoxelSpaceConversions.h"
 
 void VoxelEditor::editVoxels(ChunkGrid& grid, ItemStack* block) {
     if (m_startPosition.x == INT_MAX || m_endPosition.x == INT_MAX) {
@@ -25,7 +22,6 @@ void VoxelEditor::editVoxels(ChunkGrid& grid, ItemStack* block) {
 }
 
 void VoxelEditor::placeAABox(ChunkGrid& grid, ItemStack* block) {
-    BlockID blockID;
     int soundNum = 0;
     int yStart, yEnd;
     int zStart, zEnd;
@@ -59,74 +55,23 @@ void VoxelEditor::placeAABox(ChunkGrid& grid, ItemStack* block) {
         xStart = end.x;
     }
 
-    // Keep track of which chunk is locked
-    Chunk* chunk = nullptr;
-    ChunkID currentID(0xffffffffffffffff);
-    bool locked = false;
-
-    std::map<ChunkID, ChunkHandle> modifiedChunks;
-
-    for (int y = yStart; y <= yEnd; y++) {
-        for (int z = zStart; z <= zEnd; z++) {
-            for (int x = xStart; x <= xEnd; x++) {
-                i32v3 chunkPos = VoxelSpaceConversions::voxelToChunk(i32v3(x, y, z));
-                ChunkID id(chunkPos);
-                if (id != currentID) {
-                    currentID = id;
-                    if (chunk) {
-                        if (locked) {
-                            chunk->dataMutex.unlock();
-                            locked = false;
-                        }
-                    }
-                    // Only need to aquire once
-                    auto& it = modifiedChunks.find(currentID);
-                    if (it == modifiedChunks.end()) {
-                        chunk = modifiedChunks.insert(std::make_pair(currentID, grid.accessor.acquire(id))).first->second;
-                    } else {
-                        chunk = it->second;
-                    }
-                    if (chunk->isAccessible) {
-                        chunk->dataMutex.lock();
-                        locked = true;
-                    }
-                }
-                if (locked) {
-                    i32v3 pos = i32v3(x, y, z) - chunkPos * CHUNK_WIDTH;
-                    int voxelIndex = pos.x + pos.y * CHUNK_LAYER + pos.z * CHUNK_WIDTH;
-                    blockID = chunk->blocks.get(voxelIndex);
-
-                    if (!block) {
-                        // Breaking blocks
-                    } else {
-                        // Placing blocks
-                        block->count--;
-
-                        // ChunkUpdater::placeBlock(chunk, )
-                        ChunkUpdater::placeBlockNoUpdate(chunk, voxelIndex, block->pack->operator[](block->id).blockID);
-                        if (block->count == 0) {
-                            if (locked) chunk->dataMutex.unlock();
-                            for (auto& it : modifiedChunks) {
-                                if (it.second->isAccessible) {
-                                    it.second->DataChange(it.second);
-                                }
-                                it.second.release();
-                            }
-                            stopDragging();
-                            return;
-                        }
-                        
-                    }
+    // All edits go in as one batch so each chunk is locked and remeshed once
+    m_editBatch.clear();
+    if (block) {
+        BlockID blockID = block->pack->operator[](block->id).blockID;
+        for (int y = yStart; y <= yEnd && m_editBatch.size() < block->count; y++) {
+            for (int z = zStart; z <= zEnd && m_editBatch.size() < block->count; z++) {
+                for (int x = xStart; x <= xEnd && m_editBatch.size() < block->count; x++) {
+                    // Placing blocks
+                    m_editBatch.setBlock(i32v3(x, y, z), blockID);
                 }
             }
         }
-    }
-    if (locked) chunk->dataMutex.unlock();
-    for (auto& it : modifiedChunks) {
-        if (it.second->isAccessible) {
-            it.second->DataChange(it.second);
-        }
-        it.second.release();
+        // Only pay for voxels that were actually placed
+        block->count -= (ui32)m_editBatch.commit(grid);
+    } else {
+        // Breaking blocks
+        m_editBatch.commit(grid);
     }
     stopDragging();
 }
@@ -2,6 +2,8 @@
 #include <map>
 #include <Vorb/VorbPreDecl.inl>
 
+#include "VoxelEditBatch.h"
+
 DECL_VG(class GLProgram);
 
 class ChunkGrid;
@@ -49,4 +51,5 @@ class VoxelEditor {
     std::vector<EditorNode> m_currentShape;
     bool m_isAxisAligned;
     EDITOR_TOOLS m_currentTool = EDITOR_TOOLS::AABOX;
+    VoxelEditBatch m_editBatch;
 };
\ No newline at end of file
@@ -1,632 +1,452 @@
 #include "stdafx.h"
 #include "VoxelLightEngine.h"
 
-#include "Errors.h"
-#include "VoxelNavigation.inl"
-
-void VoxelLightEngine::calculateLight(Chunk* chunk)
-{
-    ////Flush all edge queues
-    //_lockedChunk = nullptr;
-
-    ////Sunlight Calculation
-    //if (chunk->sunlightRemovalQueue.size()) {
-    //    vvox::swapLockedChunk(chunk, _lockedChunk);
-    //    //Removal
-    //    while (chunk->sunlightRemovalQueue.size()){
-    //        auto& node = chunk->sunlightRemovalQueue.front();
-    //        removeSunlightBFS(chunk, (int)node.blockIndex, node.oldLightVal);
-    //        chunk->sunlightRemovalQueue.pop();
-    //    }
-    //    std::queue<SunlightRemovalNode>().swap(chunk->sunlightRemovalQueue); //forces memory to be freed
-    //}
-
-    //if (chunk->sunlightUpdateQueue.size()) {
-    //    vvox::swapLockedChunk(chunk, _lockedChunk);
-    //    //Addition
-    //    while (chunk->sunlightUpdateQueue.size()){
-    //        auto& node = chunk->sunlightUpdateQueue.front();
-    //        placeSunlightBFS(chunk, (int)node.blockIndex, (int)node.lightVal);
-    //        chunk->sunlightUpdateQueue.pop();
-    //    }
-    //    std::queue<SunlightUpdateNode>().swap(chunk->sunlightUpdateQueue); //forces memory to be freed
-    //}
-
-    ////Voxel Light Calculation
-    //if (chunk->lampLightRemovalQueue.size()) {
-    //    vvox::swapLockedChunk(chunk, _lockedChunk);
-    //    //Removal
-    //    while (chunk->lampLightRemovalQueue.size()){
-    //        auto& node = chunk->lampLightRemovalQueue.front();
-    //        removeLampLightBFS(chunk, (int)node.blockIndex, node.oldLightColor);
-    //        chunk->lampLightRemovalQueue.pop();
-    //    }
-    //    std::queue<LampLightRemovalNode>().swap(chunk->lampLightRemovalQueue); //forces memory to be freed
-    //}
-
-    //if (chunk->lampLightUpdateQueue.size()) {
-    //    vvox::swapLockedChunk(chunk, _lockedChunk);
-    //    //Addition
-    //    while (chunk->lampLightUpdateQueue.size()) {
-    //        auto& node = chunk->lampLightUpdateQueue.front();
-    //        placeLampLightBFS(chunk, (int)node.blockIndex, node.lightColor);
-    //        chunk->lampLightUpdateQueue.pop();
-    //    }
-    //    std::queue<LampLightUpdateNode>().swap(chunk->lampLightUpdateQueue); //forces memory to be freed
-    //}
-    //if (_lockedChunk) {
-    //    _lockedChunk->unlock();
-    //    _lockedChunk = nullptr;
-    //}
+#include "BlockData.h"
+#include "BlockPack.h"
+#include "Chunk.h"
+#include "ChunkMeshTask.h"
+#include "VoxelBits.h"
+#include "VoxelUtils.h"
+
+#define GETBLOCK(a) m_blocks->operator[](a)
+
+// Faces are ordered -x, +x, -y, +y, -z, +z like vvox::Cardinal
+#define FACE_Y_NEG 2
+
+const int FACE_NEIGHBOR_HANDLES[6] = {
+    NEIGHBOR_HANDLE_LEFT, NEIGHBOR_HANDLE_RIGHT,
+    NEIGHBOR_HANDLE_BOT, NEIGHBOR_HANDLE_TOP,
+    NEIGHBOR_HANDLE_BACK, NEIGHBOR_HANDLE_FRONT
+};
+
+inline bool blocksSun(const Block& block) {
+    return !block.allowLight || block.blockLight;
 }
 
-void VoxelLightEngine::calculateSunlightExtend(Chunk* chunk)
-{
-    //int blockIndex;
-    //int y;
-
-    //_lockedChunk = nullptr;
-    //vvox::swapLockedChunk(chunk, _lockedChunk);
-
-    //for (ui32 i = 0; i < chunk->sunExtendList.size(); i++){
-    //    blockIndex = chunk->sunExtendList[i];
-    //    if (chunk->getSunlight(blockIndex) == MAXLIGHT){
-    //        y = blockIndex / CHUNK_LAYER;
-    //        extendSunRay(chunk, blockIndex - y * CHUNK_LAYER, y);
-    //    }
-    //}
-    //std::vector<GLushort>().swap(chunk->sunExtendList); //forces memory to be freed
-    //if (_lockedChunk) {
-    //    _lockedChunk->unlock();
-    //    _lockedChunk = nullptr;
-    //}
+// Per channel max of two packed lamp colors
+inline ui16 maxLampColor(ui16 a, ui16 b) {
+    return vmath::max(a & LAMP_RED_MASK, b & LAMP_RED_MASK) |
+           vmath::max(a & LAMP_GREEN_MASK, b & LAMP_GREEN_MASK) |
+           vmath::max(a & LAMP_BLUE_MASK, b & LAMP_BLUE_MASK);
 }
 
-void VoxelLightEngine::calculateSunlightRemoval(Chunk* chunk)
-{
-    //int blockIndex;
-    //int y;
-
-    //_lockedChunk = nullptr;
-    //vvox::swapLockedChunk(chunk, _lockedChunk);
-
-    //for (ui32 i = 0; i < chunk->sunRemovalList.size(); i++){
-    //    blockIndex = chunk->sunRemovalList[i];
-    //    if (chunk->getSunlight(blockIndex) == 0){
-    //        y = blockIndex / CHUNK_LAYER;
-    //        blockSunRay(chunk, blockIndex - y * CHUNK_LAYER, y - 1);
-    //    }
-    //}
-    //std::vector<GLushort>().swap(chunk->sunRemovalList); //forces memory to be freed
-    //if (_lockedChunk) {
-    //    _lockedChunk->unlock();
-    //    _lockedChunk = nullptr;
-    //}
+// Dims each channel of a packed lamp color by one level
+inline ui16 dimLampColor(ui16 color) {
+    ui16 r = color & LAMP_RED_MASK;
+    ui16 g = color & LAMP_GREEN_MASK;
+    ui16 b = color & LAMP_BLUE_MASK;
+    if (r) r -= 1 << LAMP_RED_SHIFT;
+    if (g) g -= 1 << LAMP_GREEN_SHIFT;
+    if (b) b -= 1;
+    return r | g | b;
 }
 
-//Check for sun rays from the top chunk
-void VoxelLightEngine::checkTopForSunlight(Chunk* chunk)
-{
-    //int blockIndex;
-    //ui16 topLight;
-
-    //static ui16 topSunlight[CHUNK_LAYER];
-
-    //if (chunk->top && chunk->top->isAccessible) {
-    //    // First grab the sunlight from the top
-    //    chunk->top->lock();
-    //    for (int i = 0; i < CHUNK_LAYER; i++) {
-    //        topSunlight[i] = chunk->top->getSunlight(i);
-    //    }
-    //    chunk->top->unlock();
-    //    // Now check for sun extend
-    //    chunk->lock();
-    //    for (int i = 0; i < CHUNK_LAYER; i++) {
-    //        blockIndex = i + 31 * CHUNK_LAYER;
-    //        topLight = topSunlight[i];
-
-    //        if ((chunk->getBlock(blockIndex).blockLight == 0) && topLight == MAXLIGHT) {
-    //            chunk->setSunlight(blockIndex, MAXLIGHT);
-    //            chunk->sunExtendList.push_back(blockIndex);
-    //        } else if (topLight == 0) { //if the top is blocking sunlight
-    //            if (chunk->getSunlight(blockIndex) == MAXLIGHT) {
-    //                chunk->setSunlight(blockIndex, 0);
-    //                chunk->sunRemovalList.push_back(blockIndex);
-    //            }
-    //        }
-    //    }
-    //    chunk->unlock();
-    //}
+void VoxelLightEngine::postMessage(Chunk* chunk, const LightMessage& message) {
+    std::lock_guard<std::mutex> l(chunk->lightInboxMutex);
+    chunk->lightInbox.push_back(message);
 }
 
-void VoxelLightEngine::blockSunRay(Chunk* chunk, int xz, int y)
-{
-    //int i = y; //start at the current block
-    //chunk->changeState(ChunkStates::MESH);
-   
-    //while (true){ //do the light removal iteration
-    //    if (i == -1){ //bottom chunk
-    //        if (chunk->bottom && chunk->bottom->isAccessible){
-    //            vvox::swapLockedChunk(chunk->bottom, _lockedChunk);
-    //            VoxelLightEngine::blockSunRay(chunk->bottom, xz, 31); //continue the algorithm
-    //            vvox::swapLockedChunk(chunk, _lockedChunk);
-    //        }
-    //        return;
-    //    } else{
-    //        if (chunk->getSunlight(xz + i*CHUNK_LAYER) == MAXLIGHT){
-    //            chunk->setSunlight(xz + i*CHUNK_LAYER, 0);
-    //            VoxelLightEngine::removeSunlightBFS(chunk, xz + i*CHUNK_LAYER, MAXLIGHT);
-    //        } else{
-    //            return;
-    //        }
-    //        i--;
-    //    }
-    //}
-
+void VoxelLightEngine::postMessages(Chunk* chunk, const std::vector<LightMessage>& messages) {
+    std::lock_guard<std::mutex> l(chunk->lightInboxMutex);
+    chunk->lightInbox.insert(chunk->lightInbox.end(), messages.begin(), messages.end());
 }
 
-void VoxelLightEngine::extendSunRay(Chunk* chunk, int xz, int y)
-{
-    //int i = y; //start at the current block, for extension to other chunks
-    //int blockIndex;
-    //chunk->changeState(ChunkStates::MESH);
-    //while (true){
-    //    if (i == -1){
-    //        if (chunk->bottom && chunk->bottom->isAccessible){
-    //            vvox::swapLockedChunk(chunk->bottom, _lockedChunk);
-    //            extendSunRay(chunk->bottom, xz, 31); //continue the algorithm
-    //            vvox::swapLockedChunk(chunk, _lockedChunk);
-    //        }
-    //        return;
-    //    } else{
-    //        blockIndex = xz + i*CHUNK_LAYER;
-    //        if (chunk->getBlock(blockIndex).blockLight == 0){
-
-    //            if (chunk->getSunlight(blockIndex) != MAXLIGHT){
-    //                chunk->sunlightUpdateQueue.emplace(blockIndex, MAXLIGHT);
-    //            }
-    //        
-    //        } else{
-    //            return;
-    //        }
-    //    }
-    //    i--;
-    //}
+void VoxelLightEngine::updateSunHeight(Chunk* chunk, int blockIndex, const BlockPack* blocks) {
+    ChunkGridData* gridData = chunk->gridData;
+    if (!gridData) return;
+    int xz = blockIndex & (CHUNK_LAYER - 1);
+    int y = blockIndex >> 10;
+    i32 voxelY = (i32)chunk->getVoxelPosition().pos.y;
+    if (blocksSun(blocks->operator[](chunk->blocks.get(blockIndex)))) {
+        gridData->raiseSunHeight(xz, voxelY + y);
+        return;
+    }
+    if (gridData->sunHeight[xz] != voxelY + y) return;
+    // The top blocker was removed, find the next one down in this chunk
+    int newY = y - 1;
+    for (; newY >= 0; newY--) {
+        if (blocksSun(blocks->operator[](chunk->blocks.get(newY * CHUNK_LAYER + xz)))) break;
+    }
+    if (newY >= 0) {
+        gridData->lowerSunHeight(xz, voxelY + y, voxelY + newY, false);
+        return;
+    }
+    // The chunk below can't be locked from here, so pin the height to its
+    // top and let its next light update continue the scan
+    gridData->lowerSunHeight(xz, voxelY + y, voxelY - 1, true);
+    ChunkHandle& below = chunk->bottom;
+    if (below.isAquired() && below->genLevel == GEN_DONE) below->DataChange(below);
 }
 
-inline void removeSunlightNeighborUpdate(Chunk* chunk, int blockIndex, ui16 light) {
-   /* ui8 lightVal = chunk->getSunlight(blockIndex);
-    if (lightVal > 0){
-        if (lightVal <= light){
-            chunk->setSunlight(blockIndex, 0);
-            chunk->sunlightRemovalQueue.emplace(blockIndex, light);
+void VoxelLightEngine::calculateLight(ChunkHandle& chunk, ChunkHandle neighbors[], const BlockPack* blocks) {
+    m_blocks = blocks;
+    m_gridData = chunk->gridData;
+    m_voxelY = (i32)chunk->getVoxelPosition().pos.y;
+    { // Take the whole inbox at once so senders are never blocked for long
+        std::lock_guard<std::mutex> l(chunk->lightInboxMutex);
+        m_messages.swap(chunk->lightInbox);
+    }
+    bool rescan = hasSunRescan();
+    // isLit is only ever set, so a lit chunk with no work can skip the lock
+    if (chunk->isLit && m_messages.empty() && !rescan) return;
+
+    bool seeded;
+    bool rescanReachedBottom = false;
+    {
+        ChunkWriteLock l(chunk->dataMutex);
+        // Decided under the lock so two tasks for this chunk can't both seed,
+        // the second seed would wipe the light the first already spread
+        seeded = !chunk->isLit;
+        if (!seeded && m_messages.empty() && !rescan) return;
+        loadContainer(chunk->blocks, m_blockIDs);
+        // Before seeding, which reads the sun heights
+        if (rescan) rescanReachedBottom = rescanSunHeight();
+        m_lightChanged = false;
+        if (seeded) {
+            seedLight(chunk);
         } else {
-            chunk->sunlightUpdateQueue.emplace(blockIndex, 0);
+            loadContainer(chunk->sunlight, m_sunlight);
+            loadContainer(chunk->lamp, m_lamp);
         }
-    }*/
-}
 
-void VoxelLightEngine::removeSunlightBFS(Chunk* chunk, int blockIndex, ui8 oldLightVal)
-{
-    //ui8 nextIntensity;
-    //if (oldLightVal > 0) {
-    //    nextIntensity = oldLightVal - 1;
-    //} else {
-    //    nextIntensity = 0;
-    //}
-
-    //int x = blockIndex % CHUNK_WIDTH;
-    //int y = blockIndex / CHUNK_LAYER;
-    //int z = (blockIndex % CHUNK_LAYER) / CHUNK_WIDTH;
-
-    //Chunk*& left = chunk->left;
-    //Chunk*& right = chunk->right;
-    //Chunk*& back = chunk->back;
-    //Chunk*& front = chunk->front;
-    //Chunk*& top = chunk->top;
-    //Chunk*& bottom = chunk->bottom;
-
-    //if (x > 0){ //left
-    //    removeSunlightNeighborUpdate(chunk, blockIndex - 1, nextIntensity);
-    //} else if (left && left->isAccessible){
-    //    vvox::swapLockedChunk(left, _lockedChunk);
-    //    removeSunlightNeighborUpdate(left, blockIndex + CHUNK_WIDTH - 1, nextIntensity);
-    //    left->changeState(ChunkStates::MESH);
-    //    vvox::swapLockedChunk(chunk, _lockedChunk);
-    //}
-
-    //if (x < CHUNK_WIDTH - 1){ //right
-    //    removeSunlightNeighborUpdate(chunk, blockIndex + 1, nextIntensity);
-    //} else if (right && right->isAccessible){
-    //    vvox::swapLockedChunk(right, _lockedChunk);
-    //    removeSunlightNeighborUpdate(right, blockIndex - CHUNK_WIDTH + 1, nextIntensity);
-    //    right->changeState(ChunkStates::MESH);
-    //    vvox::swapLockedChunk(chunk, _lockedChunk);
-    //}
-
-    //if (z > 0){ //back
-    //    removeSunlightNeighborUpdate(chunk, blockIndex - CHUNK_WIDTH, nextIntensity);
-    //} else if (back && back->isAccessible){
-    //    vvox::swapLockedChunk(back, _lockedChunk);
-    //    removeSunlightNeighborUpdate(back, blockIndex + CHUNK_LAYER - CHUNK_WIDTH, nextIntensity);
-    //    back->changeState(ChunkStates::MESH);
-    //    vvox::swapLockedChunk(chunk, _lockedChunk);
-    //}
-
-    //if (z < CHUNK_WIDTH - 1){ //front
-    //    removeSunlightNeighborUpdate(chunk, blockIndex + CHUNK_WIDTH, nextIntensity);
-    //} else if (front && front->isAccessible){
-    //    vvox::swapLockedChunk(front, _lockedChunk);
-    //    removeSunlightNeighborUpdate(front, blockIndex - CHUNK_LAYER + CHUNK_WIDTH, nextIntensity);
-    //    front->changeState(ChunkStates::MESH);
-    //    vvox::swapLockedChunk(chunk, _lockedChunk);
-    //}
-
-    //if (y > 0){ //bottom
-    //    removeSunlightNeighborUpdate(chunk, blockIndex - CHUNK_LAYER, nextIntensity);
-    //} else if (bottom && bottom->isAccessible){
-    //    vvox::swapLockedChunk(bottom, _lockedChunk);
-    //    removeSunlightNeighborUpdate(bottom, CHUNK_SIZE - CHUNK_LAYER + blockIndex, nextIntensity);
-    //    bottom->changeState(ChunkStates::MESH);
-    //    vvox::swapLockedChunk(chunk, _lockedChunk);
-    //}
-
-    //if (y < CHUNK_WIDTH - 1){ //top
-    //    removeSunlightNeighborUpdate(chunk, blockIndex + CHUNK_LAYER, nextIntensity);
-    //} else if (top && top->isAccessible){
-    //    vvox::swapLockedChunk(top, _lockedChunk);
-    //    removeSunlightNeighborUpdate(top, blockIndex - CHUNK_SIZE + CHUNK_LAYER, nextIntensity);
-    //    top->changeState(ChunkStates::MESH);
-    //    vvox::swapLockedChunk(chunk, _lockedChunk);
-    //}
-    //chunk->changeState(ChunkStates::MESH);
+        for (auto& message : m_messages) {
+            handleMessage(message);
+        }
+        m_messages.clear();
+
+        // Removal first, since it queues the light that has to be spread back in
+        removeSunlightBFS();
+        removeLampLightBFS();
+        placeSunlightBFS();
+        placeLampLightBFS();
 
+        if (m_lightChanged) {
+            storeContainer(chunk->sunlight, m_sunlight);
+            storeContainer(chunk->lamp, m_lamp);
+        }
+        chunk->isLit = true;
+    }
+
+    // The scan continues in the chunk below on its next light update
+    if (rescanReachedBottom) {
+        ChunkHandle& below = neighbors[FACE_NEIGHBOR_HANDLES[FACE_Y_NEG]];
+        if (below.isAquired() && below->genLevel == GEN_DONE) below->DataChange(below);
+    }
+
+    // Hand off light that crossed a face. Only the neighbor's inbox is locked.
+    for (int face = 0; face < 6; face++) {
+        std::vector<LightMessage>& outbox = m_outbox[face];
+        // Newly lit chunks also remesh neighbors, since their faces sample our light
+        if (outbox.empty() && !seeded) continue;
+        ChunkHandle& neighbor = neighbors[FACE_NEIGHBOR_HANDLES[face]];
+        // Empty chunks still carry light through, so only unloaded neighbors drop it.
+        // Ungenerated ones keep it in their inbox until they are first lit.
+        if (!neighbor.isAquired()) {
+            outbox.clear();
+            continue;
+        }
+        bool needsMesh = seeded;
+        if (outbox.size()) {
+            std::lock_guard<std::mutex> l(neighbor->lightInboxMutex);
+            // If the inbox wasn't empty, a remesh is already on its way
+            if (neighbor->lightInbox.empty()) needsMesh = true;
+            neighbor->lightInbox.insert(neighbor->lightInbox.end(), outbox.begin(), outbox.end());
+            outbox.clear();
+        }
+        if (needsMesh && neighbor->genLevel == GEN_DONE) neighbor->DataChange(neighbor);
+    }
 }
 
-inline void placeSunlightNeighborUpdate(Chunk* chunk, int blockIndex, ui16 light) {
-    //if (chunk->getSunlight(blockIndex) < light){
-    //    if (chunk->getBlock(blockIndex).allowLight){
-    //        chunk->setSunlight(blockIndex, (ui8)light); // TODO(Ben) Wrong type?
-    //        chunk->sunlightUpdateQueue.emplace(blockIndex, light);
-    //    }
-    //}
+void VoxelLightEngine::loadContainer(vvox::SmartVoxelContainer<ui16>& container, ui16* dest) {
+    if (container.getState() == vvox::VoxelStorageState::INTERVAL_TREE) {
+        container.uncompressIntoBuffer(dest);
+    } else {
+        memcpy(dest, container.getDataArray(), CHUNK_SIZE * sizeof(ui16));
+    }
 }
 
-void VoxelLightEngine::placeSunlightBFS(Chunk* chunk, int blockIndex, ui8 intensity)
-{
-    //if (intensity > chunk->getSunlight(blockIndex)) {
-    //    //Set the light value
-    //    chunk->setSunlight(blockIndex, intensity);
-    //} else {
-    //    //If intensity is less that the actual light value, use the actual
-    //    intensity = chunk->getSunlight(blockIndex);
-    //}
-
-    //if (intensity <= 1) return;
-    ////Reduce by 1 to prevent a bunch of -1
-    //ui8 newIntensity = (intensity - 1);
-
-    //chunk->dirty = 1;
-
-    //int x = blockIndex % CHUNK_WIDTH;
-    //int y = blockIndex / CHUNK_LAYER;
-    //int z = (blockIndex % CHUNK_LAYER) / CHUNK_WIDTH;
-
-    //Chunk*& left = chunk->left;
-    //Chunk*& right = chunk->right;
-    //Chunk*& back = chunk->back;
-    //Chunk*& front = chunk->front;
-    //Chunk*& top = chunk->top;
-    //Chunk*& bottom = chunk->bottom;
-
-    //if (x > 0){ //left
-    //    placeSunlightNeighborUpdate(chunk, blockIndex - 1, newIntensity);
-    //} else if (left && left->isAccessible){
-    //    vvox::swapLockedChunk(left, _lockedChunk);
-    //    placeSunlightNeighborUpdate(left, blockIndex + CHUNK_WIDTH - 1, newIntensity);
-    //    left->changeState(ChunkStates::MESH);
-    //    vvox::swapLockedChunk(chunk, _lockedChunk);
-    //}
-
-    //if (x < CHUNK_WIDTH - 1){ //right
-    //    placeSunlightNeighborUpdate(chunk, blockIndex + 1, newIntensity);
-    //} else if (right && right->isAccessible){
-    //    vvox::swapLockedChunk(right, _lockedChunk);
-    //    placeSunlightNeighborUpdate(right, blockIndex - CHUNK_WIDTH + 1, newIntensity);
-    //    right->changeState(ChunkStates::MESH); 
-    //    vvox::swapLockedChunk(chunk, _lockedChunk);
-    //}
-
-    //if (z > 0){ //back
-    //    placeSunlightNeighborUpdate(chunk, blockIndex - CHUNK_WIDTH, newIntensity);
-    //} else if (back && back->isAccessible){
-    //    vvox::swapLockedChunk(back, _lockedChunk);
-    //    placeSunlightNeighborUpdate(back, blockIndex + CHUNK_LAYER - CHUNK_WIDTH, newIntensity);
-    //    back->changeState(ChunkStates::MESH);
-    //    vvox::swapLockedChunk(chunk, _lockedChunk);
-    //}
-
-    //if (z < CHUNK_WIDTH - 1){ //front
-    //    placeSunlightNeighborUpdate(chunk, blockIndex + CHUNK_WIDTH, newIntensity);
-    //} else if (front && front->isAccessible){
-    //    vvox::swapLockedChunk(front, _lockedChunk);
-    //    placeSunlightNeighborUpdate(front, blockIndex - CHUNK_LAYER + CHUNK_WIDTH, newIntensity);
-    //    front->changeState(ChunkStates::MESH);
-    //    vvox::swapLockedChunk(chunk, _lockedChunk);
-    //}
-
-    //if (y > 0){ //bottom
-    //    placeSunlightNeighborUpdate(chunk, blockIndex - CHUNK_LAYER, newIntensity);
-    //} else if (bottom && bottom->isAccessible){
-    //    vvox::swapLockedChunk(bottom, _lockedChunk);
-    //    placeSunlightNeighborUpdate(bottom, CHUNK_SIZE - CHUNK_LAYER + blockIndex, newIntensity);
-    //    bottom->changeState(ChunkStates::MESH);
-    //    vvox::swapLockedChunk(chunk, _lockedChunk);
-    //}
-
-    //if (y < CHUNK_WIDTH - 1){ //top
-    //    placeSunlightNeighborUpdate(chunk, blockIndex + CHUNK_LAYER, newIntensity);
-    //} else if (top && top->isAccessible){
-    //    vvox::swapLockedChunk(top, _lockedChunk);
-    //    placeSunlightNeighborUpdate(top, blockIndex - CHUNK_SIZE + CHUNK_LAYER, newIntensity);
-    //    top->changeState(ChunkStates::MESH);
-    //    vvox::swapLockedChunk(chunk, _lockedChunk);
-    //}
-
-    //chunk->changeState(ChunkStates::MESH);
+void VoxelLightEngine::storeContainer(vvox::SmartVoxelContainer<ui16>& container, const ui16* src) {
+    if (container.getState() == vvox::VoxelStorageState::FLAT_ARRAY) {
+        memcpy(container.getDataArray(), src, CHUNK_SIZE * sizeof(ui16));
+        return;
+    }
+    // Light is mostly long runs, so rebuilding the tree is cheaper than inserting
+    m_nodes.clear();
+    m_nodes.emplace_back();
+    m_nodes.back().set(0, 1, src[0]);
+    for (int i = 1; i < CHUNK_SIZE; i++) {
+        if (src[i] == m_nodes.back().data) {
+            m_nodes.back().length++;
+        } else {
+            m_nodes.emplace_back();
+            m_nodes.back().set(i, 1, src[i]);
+        }
+    }
+    container.initFromSortedArray(vvox::VoxelStorageState::INTERVAL_TREE, m_nodes);
 }
 
-inline ui16 getMaxLampColors(const ui16 redA, const ui16 greenA, const ui16 blueA, const ui16 b) {
-    /*   ui16 redB = b & LAMP_RED_MASK;
-       ui16 greenB = b & LAMP_GREEN_MASK;
-       ui16 blueB = b & LAMP_BLUE_MASK;
-       return MAX(redA, redB) | MAX(greenA, greenB) | MAX(blueA, blueB);*/
+bool VoxelLightEngine::hasSunRescan() const {
+    if (!m_gridData) return false;
+    i32 topY = m_voxelY + CHUNK_WIDTH - 1;
+    for (int xz = 0; xz < CHUNK_LAYER; xz++) {
+        if (m_gridData->needsSunRescan(xz, topY)) return true;
+    }
+    return false;
 }
 
-inline void getLampColors(const ui16 l, ui16 &r, ui16 &g, ui16 &b) {
-    /*  r = l & LAMP_RED_MASK;
-      g = l & LAMP_GREEN_MASK;
-      b = l & LAMP_BLUE_MASK;*/
+bool VoxelLightEngine::rescanSunHeight() {
+    i32 topY = m_voxelY + CHUNK_WIDTH - 1;
+    bool reachedBottom = false;
+    for (int xz = 0; xz < CHUNK_LAYER; xz++) {
+        if (!m_gridData->needsSunRescan(xz, topY)) continue;
+        int y = CHUNK_WIDTH - 1;
+        for (; y >= 0; y--) {
+            if (blocksSun(GETBLOCK(m_blockIDs[y * CHUNK_LAYER + xz]))) break;
+        }
+        m_gridData->lowerSunHeight(xz, topY, m_voxelY + y, y < 0);
+        if (y < 0) reachedBottom = true;
+    }
+    return reachedBottom;
 }
 
-inline void removeLampNeighborUpdate(Chunk* chunk, int blockIndex, ui16 intensityRed, ui16 intensityGreen, ui16 intensityBlue, ui16 light) {
-   /* ui16 nextRed, nextGreen, nextBlue;
-    ui16 nextLight = chunk->getLampLight(blockIndex);
-    getLampColors(nextLight, nextRed, nextGreen, nextBlue);
+void VoxelLightEngine::seedLight(const Chunk* chunk) {
+    memset(m_sunlight, 0, sizeof(m_sunlight));
+    memset(m_lamp, 0, sizeof(m_lamp));
+    m_lightChanged = true;
+
+    // Sunlight falls straight down from columns open to the sky until
+    // something scatters it. Light from chunks above arrives as messages.
+    if (m_gridData) {
+        i32 topY = m_voxelY + CHUNK_WIDTH - 1;
+        for (int xz = 0; xz < CHUNK_LAYER; xz++) {
+            bool exposed = m_gridData->isSkyExposed(xz, topY + 1);
+            int y = CHUNK_WIDTH - 1;
+            for (; y >= 0; y--) {
+                int blockIndex = y * CHUNK_LAYER + xz;
+                if (blocksSun(GETBLOCK(m_blockIDs[blockIndex]))) break;
+                if (exposed) m_sunlight[blockIndex] = MAX_LIGHT;
+            }
+            m_sunBottom[xz] = exposed ? (ui8)(y + 1) : CHUNK_WIDTH;
+            // Flora and anything else the heightmap doesn't know about
+            if (y >= 0) m_gridData->raiseSunHeight(xz, m_voxelY + y);
+        }
+
+        // Full sunlight only spreads sideways where a neighboring column is
+        // shadowed, so only the voxels below the neighbors' sun bottoms are
+        // queued. Columns in other chunks are unknown, so edges queue it all.
+        for (int z = 0; z < CHUNK_WIDTH; z++) {
+            for (int x = 0; x < CHUNK_WIDTH; x++) {
+                int xz = z * CHUNK_WIDTH + x;
+                int bottom = m_sunBottom[xz];
+                if (bottom == CHUNK_WIDTH) continue;
+                int seedTop = CHUNK_WIDTH;
+                if (x > 0 && x < CHUNK_WIDTH - 1 && z > 0 && z < CHUNK_WIDTH - 1) {
+                    seedTop = vmath::max(vmath::max(m_sunBottom[xz - 1], m_sunBottom[xz + 1]),
+                                         vmath::max(m_sunBottom[xz - CHUNK_WIDTH], m_sunBottom[xz + CHUNK_WIDTH]));
+                }
+                // The bottom voxel always spreads, down into scattering blocks or the chunk below
+                m_sunAddQueue.push_back((ui16)(bottom * CHUNK_LAYER + xz));
+                for (int y = bottom + 1; y < seedTop; y++) {
+                    m_sunAddQueue.push_back((ui16)(y * CHUNK_LAYER + xz));
+                }
+            }
+        }
+    }
+
+    // Emissive blocks
+    for (int i = 0; i < CHUNK_SIZE; i++) {
+        ui16 color = GETBLOCK(m_blockIDs[i]).lightColorPacked;
+        if (color) {
+            m_lamp[i] = color;
+            m_lampAddQueue.push_back((ui16)i);
+        }
+    }
+}
 
-    if ((nextRed && nextRed <= intensityRed) || (nextGreen && nextGreen <= intensityGreen) || (nextBlue && nextBlue <= intensityBlue)){
-        chunk->setLampLight(blockIndex, 0);
-        chunk->lampLightRemovalQueue.emplace(blockIndex, light);
+void VoxelLightEngine::handleMessage(const LightMessage& message) {
+    int blockIndex = message.blockIndex;
+    bool fromAbove = (message.value & LIGHT_FROM_ABOVE_FLAG) != 0;
+    ui16 value = message.value & ~LIGHT_FROM_ABOVE_FLAG;
+    switch (message.type) {
+        case LightMessageType::SUN_ADD:
+            placeSunlightNeighbor(blockIndex, value, fromAbove);
+            break;
+        case LightMessageType::SUN_REMOVE:
+            removeSunlightNeighbor(blockIndex, value, fromAbove);
+            break;
+        case LightMessageType::LAMP_ADD:
+            placeLampLightNeighbor(blockIndex, message.value);
+            break;
+        case LightMessageType::LAMP_REMOVE:
+            removeLampLightNeighbor(blockIndex, message.value);
+            break;
+        case LightMessageType::REFRESH:
+            if (m_sunlight[blockIndex]) m_sunAddQueue.push_back((ui16)blockIndex);
+            if (m_lamp[blockIndex]) m_lampAddQueue.push_back((ui16)blockIndex);
+            break;
+        case LightMessageType::BLOCK_CHANGE: {
+            const Block& block = GETBLOCK(m_blockIDs[blockIndex]);
+            // Remove whatever light was here, then let the neighbors fill it back in
+            if (m_sunlight[blockIndex]) {
+                m_sunRemovalQueue.emplace_back((ui16)blockIndex, m_sunlight[blockIndex]);
+                m_sunlight[blockIndex] = 0;
+            }
+            if (m_lamp[blockIndex]) {
+                m_lampRemovalQueue.emplace_back((ui16)blockIndex, m_lamp[blockIndex]);
+                m_lamp[blockIndex] = 0;
+            }
+            if (block.lightColorPacked) {
+                m_lamp[blockIndex] = block.lightColorPacked;
+                m_lampAddQueue.push_back((ui16)blockIndex);
+            }
+            if (block.allowLight) {
+                for (int face = 0; face < 6; face++) {
+                    if (isBlockIndexOnFace(blockIndex, face)) {
+                        sendToNeighbor(face, LightMessageType::REFRESH, blockIndex + VOXEL_WRAP_OFFSETS[face], 0);
+                        continue;
+                    }
+                    int n = blockIndex + VOXEL_FACE_OFFSETS[face];
+                    if (m_sunlight[n]) m_sunAddQueue.push_back((ui16)n);
+                    if (m_lamp[n]) m_lampAddQueue.push_back((ui16)n);
+                }
+            }
+            m_lightChanged = true;
+        } break;
+    }
+}
 
-        if (nextRed > intensityRed || nextGreen > intensityGreen || nextBlue > intensityBlue){
-            chunk->lampLightUpdateQueue.emplace(blockIndex, 0);
+void VoxelLightEngine::removeSunlightBFS() {
+    // The queue grows while we walk it
+    for (size_t i = 0; i < m_sunRemovalQueue.size(); i++) {
+        int blockIndex = m_sunRemovalQueue[i].blockIndex;
+        ui16 oldLight = m_sunRemovalQueue[i].oldValue;
+        for (int face = 0; face < 6; face++) {
+            if (isBlockIndexOnFace(blockIndex, face)) {
+                sendToNeighbor(face, LightMessageType::SUN_REMOVE, blockIndex + VOXEL_WRAP_OFFSETS[face],
+                               face == FACE_Y_NEG ? (oldLight | LIGHT_FROM_ABOVE_FLAG) : oldLight);
+            } else {
+                removeSunlightNeighbor(blockIndex + VOXEL_FACE_OFFSETS[face], oldLight, face == FACE_Y_NEG);
+            }
         }
-    } else if (nextLight > 0) {
-        chunk->lampLightUpdateQueue.emplace(blockIndex, 0);
-    }*/
+    }
+    m_sunRemovalQueue.clear();
 }
 
-void VoxelLightEngine::removeLampLightBFS(Chunk* chunk, int blockIndex, ui16 light)
-{
-//#define RED1 0x400
-//#define GREEN1 0x20
-//#define BLUE1 1
-//
-//    ui16 intensityRed = light & LAMP_RED_MASK;
-//    ui16 intensityGreen = light & LAMP_GREEN_MASK;
-//    ui16 intensityBlue = light & LAMP_BLUE_MASK;
-//
-//    //Reduce by 1
-//    if (intensityRed != 0) {
-//        intensityRed -= RED1;
-//        light -= RED1;
-//    }
-//    if (intensityGreen != 0) {
-//        intensityGreen -= GREEN1;
-//        light -= GREEN1;
-//    }
-//    if (intensityBlue != 0) {
-//        intensityBlue -= BLUE1;
-//        light -= BLUE1;
-//    }
-//
-//    int x = blockIndex % CHUNK_WIDTH;
-//    int y = blockIndex / CHUNK_LAYER;
-//    int z = (blockIndex % CHUNK_LAYER) / CHUNK_WIDTH;
-//
-//    Chunk*& left = chunk->left;
-//    Chunk*& right = chunk->right;
-//    Chunk*& back = chunk->back;
-//    Chunk*& front = chunk->front;
-//    Chunk*& top = chunk->top;
-//    Chunk*& bottom = chunk->bottom;
-//
-//    if (x > 0){ //left
-//        removeLampNeighborUpdate(chunk, blockIndex - 1, intensityRed, intensityGreen, intensityBlue, light);    
-//    } else if (left && left->isAccessible){
-//        vvox::swapLockedChunk(left, _lockedChunk);
-//        removeLampNeighborUpdate(left, blockIndex + CHUNK_WIDTH - 1, intensityRed, intensityGreen, intensityBlue, light);
-//        left->changeState(ChunkStates::MESH);
-//        vvox::swapLockedChunk(chunk, _lockedChunk);
-//    }
-//
-//    if (x < CHUNK_WIDTH - 1){ //right
-//        removeLampNeighborUpdate(chunk, blockIndex + 1, intensityRed, intensityGreen, intensityBlue, light);
-//    } else if (right && right->isAccessible){
-//        vvox::swapLockedChunk(right, _lockedChunk);
-//        removeLampNeighborUpdate(right, blockIndex - CHUNK_WIDTH + 1, intensityRed, intensityGreen, intensityBlue, light);
-//        right->changeState(ChunkStates::MESH);
-//        vvox::swapLockedChunk(chunk, _lockedChunk);
-//    }
-//
-//    if (z > 0){ //back
-//        removeLampNeighborUpdate(chunk, blockIndex - CHUNK_WIDTH, intensityRed, intensityGreen, intensityBlue, light);
-//    } else if (back && back->isAccessible){
-//        vvox::swapLockedChunk(back, _lockedChunk);
-//        removeLampNeighborUpdate(back, blockIndex + CHUNK_LAYER - CHUNK_WIDTH, intensityRed, intensityGreen, intensityBlue, light);
-//        back->changeState(ChunkStates::MESH);
-//        vvox::swapLockedChunk(chunk, _lockedChunk);
-//    }
-//
-//    if (z < CHUNK_WIDTH - 1){ //front
-//        removeLampNeighborUpdate(chunk, blockIndex + CHUNK_WIDTH, intensityRed, intensityGreen, intensityBlue, light);
-//    } else if (front && front->isAccessible){
-//        vvox::swapLockedChunk(front, _lockedChunk);
-//        removeLampNeighborUpdate(front, blockIndex - CHUNK_LAYER + CHUNK_WIDTH, intensityRed, intensityGreen, intensityBlue, light);
-//        front->changeState(ChunkStates::MESH);
-//        vvox::swapLockedChunk(chunk, _lockedChunk);
-//    }
-//
-//    if (y > 0){ //bottom
-//        removeLampNeighborUpdate(chunk, blockIndex - CHUNK_LAYER, intensityRed, intensityGreen, intensityBlue, light);
-//    } else if (bottom && bottom->isAccessible){
-//        vvox::swapLockedChunk(bottom, _lockedChunk);
-//        removeLampNeighborUpdate(bottom, CHUNK_SIZE - CHUNK_LAYER + blockIndex, intensityRed, intensityGreen, intensityBlue, light);
-//        bottom->changeState(ChunkStates::MESH);
-//        vvox::swapLockedChunk(chunk, _lockedChunk);
-//    }
-//
-//    if (y < CHUNK_WIDTH - 1){ //top
-//        removeLampNeighborUpdate(chunk, blockIndex + CHUNK_LAYER, intensityRed, intensityGreen, intensityBlue, light);
-//    } else if (top && top->isAccessible){
-//        vvox::swapLockedChunk(top, _lockedChunk);
-//        removeLampNeighborUpdate(top, blockIndex - CHUNK_SIZE + CHUNK_LAYER, intensityRed, intensityGreen, intensityBlue, light);
-//        top->changeState(ChunkStates::MESH);
-//        vvox::swapLockedChunk(chunk, _lockedChunk);
-//    }
-//    chunk->changeState(ChunkStates::MESH);
+void VoxelLightEngine::removeLampLightBFS() {
+    for (size_t i = 0; i < m_lampRemovalQueue.size(); i++) {
+        int blockIndex = m_lampRemovalQueue[i].blockIndex;
+        ui16 oldColor = m_lampRemovalQueue[i].oldValue;
+        for (int face = 0; face < 6; face++) {
+            if (isBlockIndexOnFace(blockIndex, face)) {
+                sendToNeighbor(face, LightMessageType::LAMP_REMOVE, blockIndex + VOXEL_WRAP_OFFSETS[face], oldColor);
+            } else {
+                removeLampLightNeighbor(blockIndex + VOXEL_FACE_OFFSETS[face], oldColor);
+            }
+        }
+    }
+    m_lampRemovalQueue.clear();
+}
 
+void VoxelLightEngine::placeSunlightBFS() {
+    for (size_t i = 0; i < m_sunAddQueue.size(); i++) {
+        int blockIndex = m_sunAddQueue[i];
+        // Read the light now since it may have changed since being queued
+        ui16 light = m_sunlight[blockIndex];
+        if (light <= 1) continue;
+        for (int face = 0; face < 6; face++) {
+            if (isBlockIndexOnFace(blockIndex, face)) {
+                sendToNeighbor(face, LightMessageType::SUN_ADD, blockIndex + VOXEL_WRAP_OFFSETS[face],
+                               face == FACE_Y_NEG ? (light | LIGHT_FROM_ABOVE_FLAG) : light);
+            } else {
+                placeSunlightNeighbor(blockIndex + VOXEL_FACE_OFFSETS[face], light, face == FACE_Y_NEG);
+            }
+        }
+    }
+    m_sunAddQueue.clear();
 }
 
-inline void placeLampNeighborUpdate(Chunk* chunk, int blockIndex, ui16 intensityRed, ui16 intensityGreen, ui16 intensityBlue) {
-  /*  ui16 currentLight = chunk->getLampLight(blockIndex);
-    const Block& block = chunk->getBlock(blockIndex);
+void VoxelLightEngine::placeLampLightBFS() {
+    for (size_t i = 0; i < m_lampAddQueue.size(); i++) {
+        int blockIndex = m_lampAddQueue[i];
+        ui16 color = m_lamp[blockIndex];
+        if (!dimLampColor(color)) continue;
+        for (int face = 0; face < 6; face++) {
+            if (isBlockIndexOnFace(blockIndex, face)) {
+                sendToNeighbor(face, LightMessageType::LAMP_ADD, blockIndex + VOXEL_WRAP_OFFSETS[face], color);
+            } else {
+                placeLampLightNeighbor(blockIndex + VOXEL_FACE_OFFSETS[face], color);
+            }
+        }
+    }
+    m_lampAddQueue.clear();
+}
 
-    intensityRed = (ui16)((intensityRed >> LAMP_RED_SHIFT) * block.colorFilter.r) << LAMP_RED_SHIFT;
-    intensityGreen = (ui16)((intensityGreen >> LAMP_GREEN_SHIFT) * block.colorFilter.g) << LAMP_GREEN_SHIFT;
-    intensityBlue = (ui16)(intensityBlue * block.colorFilter.b);
+void VoxelLightEngine::removeSunlightNeighbor(int blockIndex, ui16 oldLight, bool fromAbove) {
+    ui16 light = m_sunlight[blockIndex];
+    if (light == 0) return;
+    // Full sunlight straight below full sunlight came from the same ray
+    if (light < oldLight || (fromAbove && oldLight == MAX_LIGHT && light == MAX_LIGHT)) {
+        m_sunlight[blockIndex] = 0;
+        m_sunRemovalQueue.emplace_back((ui16)blockIndex, light);
+        m_lightChanged = true;
+    } else {
+        // Lit by something else, so it has to refill the hole
+        m_sunAddQueue.push_back((ui16)blockIndex);
+    }
+}
 
-    ui16 nextLight = getMaxLampColors(intensityRed, intensityGreen, intensityBlue, currentLight);
-    if (nextLight != currentLight){
-        if (chunk->getBlock(blockIndex).allowLight){
-            chunk->setLampLight(blockIndex, nextLight);
-            chunk->lampLightUpdateQueue.emplace(blockIndex, nextLight);
+void VoxelLightEngine::removeLampLightNeighbor(int blockIndex, ui16 oldColor) {
+    ui16 color = m_lamp[blockIndex];
+    if (color == 0) return;
+    if (GETBLOCK(m_blockIDs[blockIndex]).lightColorPacked) {
+        // Emitters keep their own light
+        m_lampAddQueue.push_back((ui16)blockIndex);
+        return;
+    }
+    // Channels are independent, so one voxel can lose red but keep blue
+    ui16 removed = 0;
+    bool refill = false;
+    static const ui16 CHANNEL_MASKS[3] = { LAMP_RED_MASK, LAMP_GREEN_MASK, LAMP_BLUE_MASK };
+    for (int c = 0; c < 3; c++) {
+        ui16 channel = color & CHANNEL_MASKS[c];
+        if (channel == 0) continue;
+        if (channel < (oldColor & CHANNEL_MASKS[c])) {
+            removed |= channel;
+        } else {
+            refill = true;
         }
-    }*/
+    }
+    if (removed) {
+        m_lamp[blockIndex] = color & ~removed;
+        m_lampRemovalQueue.emplace_back((ui16)blockIndex, removed);
+        m_lightChanged = true;
+    }
+    if (refill) m_lampAddQueue.push_back((ui16)blockIndex);
+}
+
+void VoxelLightEngine::placeSunlightNeighbor(int blockIndex, ui16 light, bool fromAbove) {
+    const Block& block = GETBLOCK(m_blockIDs[blockIndex]);
+    if (!block.allowLight) return;
+    // Unscattered sunlight doesn't fade on the way down
+    ui16 newLight = (fromAbove && light == MAX_LIGHT && !block.blockLight) ? MAX_LIGHT : light - 1;
+    if (newLight > m_sunlight[blockIndex]) {
+        m_sunlight[blockIndex] = newLight;
+        m_sunAddQueue.push_back((ui16)blockIndex);
+        m_lightChanged = true;
+    }
 }
 
-void VoxelLightEngine::placeLampLightBFS(Chunk* chunk, int blockIndex, ui16 intensity)
-{
-//#define RED1 0x400
-//#define GREEN1 0x20
-//#define BLUE1 1
-//
-//    ui16 currentLight = chunk->getLampLight(blockIndex);
-//
-//    ui16 currentRed = currentLight & LAMP_RED_MASK;
-//    ui16 currentGreen = currentLight & LAMP_GREEN_MASK;
-//    ui16 currentBlue = currentLight & LAMP_BLUE_MASK;
-//
-//    ui16 intensityRed = intensity & LAMP_RED_MASK;
-//    ui16 intensityGreen = intensity & LAMP_GREEN_MASK;
-//    ui16 intensityBlue = intensity & LAMP_BLUE_MASK;
-//
-//    intensityRed = MAX(currentRed, intensityRed);
-//    intensityGreen = MAX(currentGreen, intensityGreen);
-//    intensityBlue = MAX(currentBlue, intensityBlue);
-//
-//    const Block& currentBlock = chunk->getBlock(blockIndex);
-//
-//    intensityRed = (ui16)((intensityRed >> LAMP_RED_SHIFT) * currentBlock.colorFilter.r) << LAMP_RED_SHIFT;
-//    intensityGreen = (ui16)((intensityGreen >> LAMP_GREEN_SHIFT) * currentBlock.colorFilter.g) << LAMP_GREEN_SHIFT;
-//    intensityBlue = (ui16)(intensityBlue * currentBlock.colorFilter.b);
-//    intensity = intensityRed | intensityGreen | intensityBlue;
-//
-//    if (intensity != currentLight) { 
-//        //Set the light value
-//        chunk->setLampLight(blockIndex, intensity);
-//    }
-//
-//    if (intensityRed <= RED1 && intensityGreen <= GREEN1 && intensityBlue <= BLUE1) return;
-//    //Reduce by 1
-//    if (intensityRed != 0) {
-//        intensityRed -= RED1;
-//        intensity -= RED1;
-//    }
-//    if (intensityGreen != 0) {
-//        intensityGreen -= GREEN1;
-//        intensity -= GREEN1;
-//    }
-//    if (intensityBlue != 0) {
-//        intensityBlue -= BLUE1;
-//        intensity -= BLUE1;
-//    }
-//
-//    chunk->dirty = 1;
-//
-//    int x = blockIndex % CHUNK_WIDTH;
-//    int y = blockIndex / CHUNK_LAYER;
-//    int z = (blockIndex % CHUNK_LAYER) / CHUNK_WIDTH;
-//
-//    Chunk*& left = chunk->left;
-//    Chunk*& right = chunk->right;
-//    Chunk*& back = chunk->back;
-//    Chunk*& front = chunk->front;
-//    Chunk*& top = chunk->top;
-//    Chunk*& bottom = chunk->bottom;
-//
-//    if (x > 0){ //left
-//        placeLampNeighborUpdate(chunk, blockIndex - 1, intensityRed, intensityGreen, intensityBlue);
-//    } else if (left && left->isAccessible){
-//        vvox::swapLockedChunk(left, _lockedChunk);
-//        placeLampNeighborUpdate(left, blockIndex + CHUNK_WIDTH - 1, intensityRed, intensityGreen, intensityBlue);
-//        left->changeState(ChunkStates::MESH);
-//        vvox::swapLockedChunk(chunk, _lockedChunk);
-//    }
-//
-//    if (x < CHUNK_WIDTH - 1){ //right
-//        placeLampNeighborUpdate(chunk, blockIndex + 1, intensityRed, intensityGreen, intensityBlue);
-//    } else if (right && right->isAccessible){
-//        vvox::swapLockedChunk(right, _lockedChunk);
-//        placeLampNeighborUpdate(right, blockIndex - CHUNK_WIDTH + 1, intensityRed, intensityGreen, intensityBlue);
-//        right->changeState(ChunkStates::MESH);
-//        vvox::swapLockedChunk(chunk, _lockedChunk);
-//    }
-//
-//    if (z > 0){ //back
-//        placeLampNeighborUpdate(chunk, blockIndex - CHUNK_WIDTH, intensityRed, intensityGreen, intensityBlue);
-//    } else if (back && back->isAccessible){
-//        vvox::swapLockedChunk(back, _lockedChunk);
-//        placeLampNeighborUpdate(back, blockIndex + CHUNK_LAYER - CHUNK_WIDTH, intensityRed, intensityGreen, intensityBlue);
-//        back->changeState(ChunkStates::MESH);
-//        vvox::swapLockedChunk(chunk, _lockedChunk);
-//    }
-//
-//    if (z < CHUNK_WIDTH - 1){ //front
-//        placeLampNeighborUpdate(chunk, blockIndex + CHUNK_WIDTH, intensityRed, intensityGreen, intensityBlue);
-//    } else if (front && front->isAccessible){
-//        vvox::swapLockedChunk(front, _lockedChunk);
-//        placeLampNeighborUpdate(front, blockIndex - CHUNK_LAYER + CHUNK_WIDTH, intensityRed, intensityGreen, intensityBlue);
-//        front->changeState(ChunkStates::MESH);
-//        vvox::swapLockedChunk(chunk, _lockedChunk);
-//    }
-//
-//    if (y > 0){ //bottom
-//        placeLampNeighborUpdate(chunk, blockIndex - CHUNK_LAYER, intensityRed, intensityGreen, intensityBlue);
-//    } else if (bottom && bottom->isAccessible){
-//        vvox::swapLockedChunk(bottom, _lockedChunk);
-//        placeLampNeighborUpdate(bottom, CHUNK_SIZE - CHUNK_LAYER + blockIndex, intensityRed, intensityGreen, intensityBlue);
-//        bottom->changeState(ChunkStates::MESH);
-//        vvox::swapLockedChunk(chunk, _lockedChunk);
-//    }
-//    if (y < CHUNK_WIDTH - 1){ //top
-//        placeLampNeighborUpdate(chunk, blockIndex + CHUNK_LAYER, intensityRed, intensityGreen, intensityBlue);
-//    } else if (top && top->isAccessible){
-//        vvox::swapLockedChunk(top, _lockedChunk);
-//        placeLampNeighborUpdate(top, blockIndex - CHUNK_SIZE + CHUNK_LAYER, intensityRed, intensityGreen, intensityBlue);
-//        top->changeState(ChunkStates::MESH);
-//        vvox::swapLockedChunk(chunk, _lockedChunk);
-//    }
-//
-//    chunk->changeState(ChunkStates::MESH);
-}
\ No newline at end of file
+void VoxelLightEngine::placeLampLightNeighbor(int blockIndex, ui16 color) {
+    if (!GETBLOCK(m_blockIDs[blockIndex]).allowLight) return;
+    ui16 oldColor = m_lamp[blockIndex];
+    ui16 newColor = maxLampColor(oldColor, dimLampColor(color));
+    if (newColor != oldColor) {
+        m_lamp[blockIndex] = newColor;
+        m_lampAddQueue.push_back((ui16)blockIndex);
+        m_lightChanged = true;
+    }
+}
+
+void VoxelLightEngine::sendToNeighbor(int face, LightMessageType type, ui16 blockIndex, ui16 value) {
+    m_outbox[face].emplace_back(type, blockIndex, value);
+}
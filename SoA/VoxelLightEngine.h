@@ -1,63 +1,120 @@
+///
+/// VoxelLightEngine.h
+/// Seed of Andromeda
+///
+/// Copyright 2014 Regrowth Studios
+/// All Rights Reserved
+///
+/// Summary:
+/// Propagates sunlight and RGB lamp light through chunks with
+/// batched BFS queues. Chunks talk to each other through
+/// LightMessage inboxes so only one chunk is ever locked.
+///
+
 #pragma once
 
-//Used to tell neighbors to update light
-//class LightMessage {
-//    LightMessage() {};
-//    LightMessage(ui16 BlockIndex, ui8 LightType, i8 LightValue) : blockIndex(BlockIndex), lightType(LightType), lightValue(LightValue) {}
-//    ui16 blockIndex;
-//    ui8 lightType;
-//    i8 lightValue;
-//};
-
-class SunlightRemovalNode
-{
-public:
-    SunlightRemovalNode(ui16 BlockIndex, ui8 OldLightVal) : blockIndex(BlockIndex), oldLightVal(OldLightVal){}
-    ui16 blockIndex;
-    ui8 oldLightVal;
-};
+#ifndef VoxelLightEngine_h__
+#define VoxelLightEngine_h__
 
-class SunlightUpdateNode
-{
-public:
-    SunlightUpdateNode(ui16 BlockIndex, ui8 LightVal) : blockIndex(BlockIndex), lightVal(LightVal){}
-    ui16 blockIndex;
-    ui8 lightVal;
+#include "ChunkHandle.h"
+#include "Constants.h"
+#include "SmartVoxelContainer.hpp"
+
+class BlockPack;
+class Chunk;
+class ChunkGridData;
+
+// Sunlight and each lamp channel are 5 bits
+const ui16 MAX_LIGHT = 31;
+
+// Set on sunlight message values when the sending voxel is directly above
+#define LIGHT_FROM_ABOVE_FLAG 0x8000
+
+enum class LightMessageType : ui8 {
+    SUN_ADD, ///< A neighbor voxel gained sunlight, value is its light
+    SUN_REMOVE, ///< A neighbor voxel lost sunlight, value is what it used to have
+    LAMP_ADD, ///< A neighbor voxel gained lamp light, value is its packed color
+    LAMP_REMOVE, ///< A neighbor voxel lost lamp light, value is what it used to have
+    REFRESH, ///< A neighbor voxel opened up, spread the light at blockIndex again
+    BLOCK_CHANGE ///< The block at blockIndex was changed
 };
 
-class LampLightRemovalNode
-{
-public:
-    LampLightRemovalNode(ui16 BlockIndex, ui16 OldLightColor) : blockIndex(BlockIndex), oldLightColor(OldLightColor){}
+struct LightMessage {
+    LightMessage() {};
+    LightMessage(LightMessageType Type, ui16 BlockIndex, ui16 Value) : type(Type), blockIndex(BlockIndex), value(Value) {}
+    LightMessageType type;
     ui16 blockIndex;
-    ui16 oldLightColor;
+    ui16 value;
 };
 
-class LampLightUpdateNode
-{
-public:
-    LampLightUpdateNode(ui16 BlockIndex, ui16 LightColor) : blockIndex(BlockIndex), lightColor(LightColor){}
+struct LightRemovalNode {
+    LightRemovalNode(ui16 BlockIndex, ui16 OldValue) : blockIndex(BlockIndex), oldValue(OldValue) {}
     ui16 blockIndex;
-    ui16 lightColor;
+    ui16 oldValue; ///< Sunlight or packed lamp color
 };
 
-class Chunk;
-
+/// One per worker thread. Chunks are processed independently, so any
+/// number of engines can run on different chunks at once.
 class VoxelLightEngine {
 public:
-    void calculateLight(Chunk* chunk);
-    void calculateSunlightExtend(Chunk* chunk);
-    void calculateSunlightRemoval(Chunk* chunk);
+    /// Sends a message to a chunk. Thread safe, and safe to call while
+    /// holding the chunk's dataMutex.
+    static void postMessage(Chunk* chunk, const LightMessage& message);
+    /// Sends many messages with one inbox lock
+    static void postMessages(Chunk* chunk, const std::vector<LightMessage>& messages);
+    /// Keeps the column sun height in sync after the block at blockIndex
+    /// changed. Call with the chunk's dataMutex held for writing.
+    static void updateSunHeight(Chunk* chunk, int blockIndex, const BlockPack* blocks);
 
-    void checkTopForSunlight(Chunk* chunk);
+    /// Seeds light for chunks that have never been lit, then processes the
+    /// chunk's inbox. Light that crosses a face is posted to that neighbor,
+    /// which is then flagged for a remesh.
+    /// @param neighbors: Acquired neighbor handles, ordered like MeshNeighborHandles
+    void calculateLight(ChunkHandle& chunk, ChunkHandle neighbors[], const BlockPack* blocks);
 private:
-   
-    void blockSunRay(Chunk* chunk, int xz, int y);
-    void extendSunRay(Chunk* chunk, int xz, int y);
-    void removeSunlightBFS(Chunk* chunk, int blockIndex, ui8 oldLightVal);
-    void placeSunlightBFS(Chunk* chunk, int blockIndex, ui8 intensity);
-    void removeLampLightBFS(Chunk* chunk, int blockIndex, ui16 light);
-    void placeLampLightBFS(Chunk* chunk, int blockIndex, ui16 intensity);
-
-    Chunk* _lockedChunk = nullptr;
-};
\ No newline at end of file
+    void loadContainer(vvox::SmartVoxelContainer<ui16>& container, ui16* dest);
+    void storeContainer(vvox::SmartVoxelContainer<ui16>& container, const ui16* src);
+    /// @return true if a column of the chunk being processed has its sun height pinned to its top
+    bool hasSunRescan() const;
+    /// Continues the sun height scan of pinned columns through this chunk
+    /// @return true if a column was clear all the way to the bottom
+    bool rescanSunHeight();
+    void seedLight(const Chunk* chunk);
+    void handleMessage(const LightMessage& message);
+
+    void removeSunlightBFS();
+    void removeLampLightBFS();
+    void placeSunlightBFS();
+    void placeLampLightBFS();
+
+    // Updates one neighbor of a voxel that was removed or spread from
+    void removeSunlightNeighbor(int blockIndex, ui16 oldLight, bool fromAbove);
+    void removeLampLightNeighbor(int blockIndex, ui16 oldColor);
+    void placeSunlightNeighbor(int blockIndex, ui16 light, bool fromAbove);
+    void placeLampLightNeighbor(int blockIndex, ui16 color);
+
+    // Queues a message for the neighbor across face
+    void sendToNeighbor(int face, LightMessageType type, ui16 blockIndex, ui16 value);
+
+    const BlockPack* m_blocks = nullptr;
+    ChunkGridData* m_gridData = nullptr;
+    i32 m_voxelY; ///< World Y of the bottom of the chunk being processed
+
+    // Flat copies of the chunk being processed
+    ui16 m_blockIDs[CHUNK_SIZE];
+    ui16 m_sunlight[CHUNK_SIZE];
+    ui16 m_lamp[CHUNK_SIZE];
+    ui8 m_sunBottom[CHUNK_LAYER]; ///< Lowest sunlit y of each column while seeding
+    bool m_lightChanged;
+
+    std::vector<LightMessage> m_messages;
+    std::vector<LightRemovalNode> m_sunRemovalQueue;
+    std::vector<LightRemovalNode> m_lampRemovalQueue;
+    // Add nodes only store the index, the light is read when processed
+    std::vector<ui16> m_sunAddQueue;
+    std::vector<ui16> m_lampAddQueue;
+    std::vector<LightMessage> m_outbox[6]; ///< Per face, ordered -x, +x, -y, +y, -z, +z
+    std::vector<IntervalTree<ui16>::LNode> m_nodes; ///< Scratch for storeContainer
+};
+
+#endif // VoxelLightEngine_h__
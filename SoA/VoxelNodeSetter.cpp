@@ -1,75 +1,68 @@
 #include "stdafx.h"
 #include "VoxelNodeSetter.h"
 
+#include "Chunk.h"
 #include "ChunkGrid.h"
+#include "ChunkUpdater.h"
 
-void VoxelNodeSetter::setNodes(ChunkHandle& h, ChunkGenLevel requiredGenLevel, std::vector<VoxelToPlace>& forcedNodes, std::vector<VoxelToPlace>& condNodes) {
-    {
-        std::lock_guard<std::mutex> l(m_lckVoxelsToAdd);
-        auto& it = m_handleLookup.find(h);
-        if (it != m_handleLookup.end()) {
-            VoxelNodeSetterLookupData& ld = it->second;
-            // Copy new voxels to add
-            size_t oldSize = ld.forcedNodes.size();
-            ld.forcedNodes.resize(oldSize + forcedNodes.size());
-            memcpy(&ld.forcedNodes[oldSize], forcedNodes.data(), forcedNodes.size() * sizeof(VoxelToPlace));
-            oldSize = ld.condNodes.size();
-            ld.condNodes.resize(oldSize + condNodes.size());
-            memcpy(&ld.condNodes[oldSize], condNodes.data(), condNodes.size() * sizeof(VoxelToPlace));
-            // Update required gen level if needed
-            if (m_waitingChunks[ld.waitingChunksIndex].requiredGenLevel < requiredGenLevel) {
-                m_waitingChunks[ld.waitingChunksIndex].requiredGenLevel = requiredGenLevel;
-            }
-        } else {
-            VoxelNodeSetterLookupData& ld = m_handleLookup[h];
-            ld.forcedNodes.swap(forcedNodes);
-            ld.condNodes.swap(condNodes);
-            ld.h = h.acquire();
-            ld.waitingChunksIndex = m_waitingChunks.size();
+bool VoxelNodeSetter::setNodes(ChunkHandle& h, std::vector<VoxelToPlace>& forcedNodes, std::vector<VoxelToPlace>& condNodes) {
+    VoxelNodeBatch* batch = new VoxelNodeBatch;
+    batch->forcedNodes.swap(forcedNodes);
+    batch->condNodes.swap(condNodes);
 
-            VoxelNodeSetterWaitingChunk wc;
-            wc.ch = h;
-            wc.requiredGenLevel = requiredGenLevel;
-            m_waitingChunks.push_back(std::move(wc));
-        }
-    }
-    // TODO(Ben): Faster overload?
-    grid->submitQuery(h->getChunkPosition(), requiredGenLevel, true);
-}
+    VoxelNodeBatch* head = h->nodeInbox.load();
+    do {
+        batch->next = head;
+    } while (!h->nodeInbox.compare_exchange_weak(head, batch));
 
-void VoxelNodeSetter::update() {
-    if (m_waitingChunks.size()) {
-        std::cout << m_waitingChunks.size() << std::endl;
-    }
-    std::lock_guard<std::mutex> l(m_lckVoxelsToAdd);
-    for (int i = (int)m_waitingChunks.size() - 1; i >= 0; i--) {
-        VoxelNodeSetterWaitingChunk& v = m_waitingChunks[i];
+    // GenerateTask raises the gen level before it empties the inbox, so if
+    // the level is still too low here the batch is sure to be found
+    if (h->genLevel >= GEN_TERRAIN) return true;
 
-        if (v.ch->genLevel >= v.requiredGenLevel) {
-            auto& it = m_handleLookup.find(v.ch);
+    // The first batch gets the chunk generated. Its query also keeps the
+    // chunk alive until the inbox is emptied.
+    if (!head) grid->submitQuery(h->getChunkPosition(), GEN_TERRAIN, true);
+    return false;
+}
 
-            {
-                // Send task
-                // TODO(Ben): MEMORY MANAGEMENT PROBLEM
-                VoxelNodeSetterTask* newTask = new VoxelNodeSetterTask;
-                newTask->h = it->second.h.acquire();
-                newTask->forcedNodes.swap(it->second.forcedNodes);
-                newTask->condNodes.swap(it->second.condNodes);
-                threadPool->addTask(newTask);
-            }
-           
-            it->second.h.release();
-            m_handleLookup.erase(it);
-            
-            // Copy back node for fast removal from vector
-            VoxelNodeSetterWaitingChunk& bn = m_waitingChunks.back();
-            v.ch = bn.ch;
-            v.requiredGenLevel = bn.requiredGenLevel;
+bool VoxelNodeSetter::placeInbox(Chunk* chunk) {
+    VoxelNodeBatch* batch = chunk->nodeInbox.exchange(nullptr);
+    if (!batch) return false;
 
-            // Update lookup index
-            m_handleLookup[v.ch].waitingChunksIndex = i;
+    // Batches come out newest first, flip them so later forced nodes still win
+    VoxelNodeBatch* ordered = nullptr;
+    while (batch) {
+        VoxelNodeBatch* next = batch->next;
+        batch->next = ordered;
+        ordered = batch;
+        batch = next;
+    }
 
-            m_waitingChunks.pop_back();
+    while (ordered) {
+        for (auto& node : ordered->forcedNodes) {
+            chunk->setBlock(node.blockIndex, node.blockID);
+            ChunkUpdater::addTickVoxel(chunk, node.blockIndex, node.blockID);
+            ChunkUpdater::setCollidable(chunk, node.blockIndex, node.blockID);
+        }
+        for (auto& node : ordered->condNodes) {
+            if (chunk->blocks.get(node.blockIndex) == 0) {
+                chunk->setBlock(node.blockIndex, node.blockID);
+                ChunkUpdater::addTickVoxel(chunk, node.blockIndex, node.blockID);
+                ChunkUpdater::setCollidable(chunk, node.blockIndex, node.blockID);
+            }
         }
+        VoxelNodeBatch* next = ordered->next;
+        delete ordered;
+        ordered = next;
+    }
+    return true;
+}
+
+void VoxelNodeSetter::clearInbox(Chunk* chunk) {
+    VoxelNodeBatch* batch = chunk->nodeInbox.exchange(nullptr);
+    while (batch) {
+        VoxelNodeBatch* next = batch->next;
+        delete batch;
+        batch = next;
     }
 }
@@ -7,7 +7,8 @@
 // All Rights Reserved
 //
 // Summary:
-// Waits on chunk generation queries and then sets voxels.
+// Holds voxels for chunks that aren't generated yet, and sets them
+// once the chunk has its terrain.
 //
 
 #pragma once
@@ -17,38 +18,44 @@
 
 #include <vector>
 #include "ChunkQuery.h"
-#include "VoxelNodeSetterTask.h"
 
+class Chunk;
 class ChunkHandle;
 
-struct VoxelNodeSetterWaitingChunk {
-    Chunk* ch;
-    ChunkGenLevel requiredGenLevel;
+struct VoxelToPlace {
+    VoxelToPlace() {};
+    VoxelToPlace(ui16 blockID, ui16 blockIndex) : blockID(blockID), blockIndex(blockIndex) {};
+    ui16 blockID;
+    ui16 blockIndex;
 };
 
-struct VoxelNodeSetterLookupData {
-    ui32 waitingChunksIndex;
-    ChunkHandle h;
+/// Nodes waiting in a chunk's inbox
+struct VoxelNodeBatch {
+    VoxelNodeBatch* next;
     std::vector<VoxelToPlace> forcedNodes; ///< Always added
     std::vector<VoxelToPlace> condNodes; ///< Conditionally added
 };
 
+/// Nodes can't go into a chunk before its terrain, or the terrain would
+/// overwrite them. Until then they wait in a lock free inbox on the chunk,
+/// which GenerateTask empties as soon as the terrain is done.
 class VoxelNodeSetter {
 public:
-    // Contents of vectors may be cleared
-    void setNodes(ChunkHandle& h,
-                  ChunkGenLevel requiredGenLevel,
+    /// Queues nodes for a chunk that has no terrain yet, and makes sure it gets
+    /// generated. Thread safe. Contents of vectors may be cleared.
+    /// @return true if the chunk got its terrain in the meantime, in which case
+    /// the caller has to call placeInbox
+    bool setNodes(ChunkHandle& h,
                   std::vector<VoxelToPlace>& forcedNodes,
                   std::vector<VoxelToPlace>& condNodes);
 
-    void update();
+    /// Sets everything in the chunk's inbox. Chunk must be write locked.
+    /// @return true if anything was set
+    static bool placeInbox(Chunk* chunk);
+    /// Frees anything left in the chunk's inbox
+    static void clearInbox(Chunk* chunk);
 
     ChunkGrid* grid = nullptr;
-    vcore::ThreadPool<WorkerData>* threadPool;
-private:
-    std::mutex m_lckVoxelsToAdd;
-    std::vector<VoxelNodeSetterWaitingChunk> m_waitingChunks;
-    std::map<Chunk*, VoxelNodeSetterLookupData> m_handleLookup; ///< Stores handles since they fk up in vector.
 };
 
 #endif // VoxelNodeSetter_h__
@@ -91,3 +91,49 @@ i32v3 VoxelRay::getNextVoxelPosition() {
 
     return _currentVoxelPos;
 }
+
+i32v3 VoxelRay::skipCell(i32 cellWidth) {
+    // Cell bounds, masking floors negative positions too
+    i32v3 lo(_currentVoxelPos.x & ~(cellWidth - 1),
+             _currentVoxelPos.y & ~(cellWidth - 1),
+             _currentVoxelPos.z & ~(cellWidth - 1));
+
+    // Distance To The Exit Plane On Each Axis
+    f64v3 r;
+    for (int i = 0; i < 3; i++) {
+        if (_direction[i] > 0) {
+            r[i] = ((f64)(lo[i] + cellWidth) - _currentPos[i]) / _direction[i];
+        } else if (_direction[i] < 0) {
+            r[i] = ((f64)lo[i] - _currentPos[i]) / _direction[i];
+        } else {
+            r[i] = FLT_MAX;
+        }
+    }
+    int axis;
+    if (r.x < r.y && r.x < r.z) {
+        axis = 0;
+    } else if (r.y < r.z) {
+        axis = 1;
+    } else {
+        axis = 2;
+    }
+    // Already past the plane, which stepping can leave behind on boundaries
+    bool behind = r[axis] < 0.0;
+    f64 rat = behind ? 0.0 : r[axis];
+    _currentPos += _direction * rat;
+    _currentDist += rat;
+
+    for (int i = 0; i < 3; i++) {
+        if (i == axis) {
+            _currentVoxelPos[i] = (_direction[i] > 0) ? lo[i] + cellWidth : lo[i] - 1;
+            // Land exactly on the plane so stepping carries on from it
+            if (!behind) _currentPos[i] = (f64)((_direction[i] > 0) ? lo[i] + cellWidth : lo[i]);
+        } else {
+            // Entering the lower voxel when sitting on a boundary and moving down
+            i32 v = fastFloor(_currentPos[i]);
+            if (_direction[i] < 0 && (f64)v == _currentPos[i]) v--;
+            _currentVoxelPos[i] = vmath::clamp(v, lo[i], lo[i] + cellWidth - 1);
+        }
+    }
+    return _currentVoxelPos;
+}
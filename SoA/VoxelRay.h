@@ -9,6 +9,10 @@ class VoxelRay {
     // Traverse To The Next Voxel And Return The Local Coordinates (Grid Offset)
     i32v3 getNextVoxelPosition();
 
+    // Traverse Out Of The Aligned Cube Of Width cellWidth (A Power Of 2) Holding The Current Voxel
+    // And Return The First Voxel Outside It
+    i32v3 skipCell(i32 cellWidth);
+
     // Access The Origin Values
     const f64v3& getStartPosition() const {
         return _startPos;
@@ -0,0 +1,151 @@
+#include "stdafx.h"
+#include "VoxelRayBatch.h"
+
+#include "BlockPack.h"
+#include "ChunkGrid.h"
+#include "VoxelSpaceConversions.h"
+
+void VoxelRayTask::execute(WorkerData* workerData) {
+    batch->castRange(begin, end);
+}
+
+void VoxelRayTask::cleanup() {
+    batch->onTaskFinished();
+}
+
+VoxelRayBatch::~VoxelRayBatch() {
+    // Tasks still point at us
+    block();
+    for (auto& task : m_tasks) {
+        delete task;
+    }
+}
+
+void VoxelRayBatch::addRay(const f64v3& pos, const f32v3& dir, f64 maxDistance) {
+    m_rays.emplace_back(pos, dir, maxDistance);
+}
+
+void VoxelRayBatch::clear() {
+    m_rays.clear();
+    m_results.clear();
+}
+
+void VoxelRayBatch::cast(ChunkGrid& grid, PredBlock f /*= &solidVoxelPredBlock*/) {
+    m_grid = &grid;
+    m_pred = f;
+    initResults();
+    castRange(0, m_rays.size());
+}
+
+void VoxelRayBatch::castAsync(ChunkGrid& grid, vcore::ThreadPool<WorkerData>* threadPool, PredBlock f /*= &solidVoxelPredBlock*/) {
+    m_grid = &grid;
+    m_pred = f;
+    initResults();
+
+    size_t numTasks = (m_rays.size() + VOXEL_RAY_BATCH_TASK_SIZE - 1) / VOXEL_RAY_BATCH_TASK_SIZE;
+    while (m_tasks.size() < numTasks) {
+        m_tasks.push_back(new VoxelRayTask);
+    }
+    m_runningTasks = (ui32)numTasks;
+    for (size_t i = 0; i < numTasks; i++) {
+        VoxelRayTask* task = m_tasks[i];
+        task->batch = this;
+        task->begin = i * VOXEL_RAY_BATCH_TASK_SIZE;
+        task->end = vmath::min(task->begin + VOXEL_RAY_BATCH_TASK_SIZE, m_rays.size());
+        threadPool->addTask(task);
+    }
+}
+
+void VoxelRayBatch::block() {
+    std::unique_lock<std::mutex> lck(m_lock);
+    while (m_runningTasks) {
+        m_cond.wait(lck);
+    }
+}
+
+void VoxelRayBatch::onTaskFinished() {
+    if (--m_runningTasks == 0) {
+        std::lock_guard<std::mutex> l(m_lock);
+        m_cond.notify_all();
+    }
+}
+
+void VoxelRayBatch::initResults() {
+    m_results.resize(m_rays.size());
+    for (size_t i = 0; i < m_rays.size(); i++) {
+        // Restart from the origin, a previous cast left the ray mid traversal
+        RayState& state = m_rays[i];
+        state.ray = VoxelRay(state.pos, f64v3(state.dir));
+        // Same start as VRayHelper::getQuery
+        VoxelRayQuery& query = m_results[i].query;
+        query = {};
+        query.location = state.ray.getNextVoxelPosition();
+        query.distance = state.ray.getDistanceTraversed();
+        query.chunkID = ChunkID(VoxelSpaceConversions::voxelToChunk(query.location));
+        m_results[i].hit = false;
+    }
+}
+
+void VoxelRayBatch::castRange(size_t begin, size_t end) {
+    // Empty chunks and bricks are skipped whole when the test can't match air
+    bool solidTest = (m_pred == &solidVoxelPredBlock);
+    bool airMatches = !solidTest && m_pred(m_grid->blockPack->operator[](0));
+
+    std::vector<ui32> active;
+    active.reserve(end - begin);
+    for (size_t i = begin; i < end; i++) {
+        if (m_results[i].query.distance < m_rays[i].maxDistance) active.push_back((ui32)i);
+    }
+
+    while (active.size()) {
+        // Group the rays by the chunk they are in
+        std::sort(active.begin(), active.end(), [&](ui32 a, ui32 b) {
+            return m_results[a].query.chunkID.id < m_results[b].query.chunkID.id;
+        });
+
+        // Rays that are still going are packed to the front
+        size_t numActive = 0;
+        size_t i = 0;
+        while (i < active.size()) {
+            ChunkID id = m_results[active[i]].query.chunkID;
+            ChunkHandle chunk = m_grid->accessor.acquire(id);
+            bool locked = chunk->isAccessible;
+            if (locked) chunk->dataMutex.lock_shared();
+            for (; i < active.size() && m_results[active[i]].query.chunkID == id; i++) {
+                ui32 r = active[i];
+                if (stepRay(r, chunk, locked, solidTest, airMatches)) active[numActive++] = r;
+            }
+            if (locked) chunk->dataMutex.unlock_shared();
+            chunk.release();
+        }
+        active.resize(numActive);
+    }
+}
+
+bool VoxelRayBatch::stepRay(ui32 r, const Chunk* chunk, bool locked, bool solidTest, bool airMatches) {
+    RayState& state = m_rays[r];
+    VoxelRayQuery& query = m_results[r].query;
+    ChunkID id = query.chunkID;
+    while (query.distance < state.maxDistance) {
+        i32v3 relativeLocation(query.location.x & 0x1f, query.location.y & 0x1f, query.location.z & 0x1f);
+        i32 skipWidth = VRayHelper::getSkipWidth(chunk, locked, solidTest, airMatches, relativeLocation);
+        if (skipWidth == 1) {
+            query.voxelIndex = (ui16)(relativeLocation.x + relativeLocation.y * CHUNK_LAYER + relativeLocation.z * CHUNK_WIDTH);
+            if (VRayHelper::testVoxel(chunk, query.voxelIndex, m_grid->blockPack, m_pred, query.id)) {
+                m_results[r].hit = true;
+                return false;
+            }
+            query.location = state.ray.getNextVoxelPosition();
+        } else {
+            query.location = state.ray.skipCell(skipWidth);
+        }
+        query.distance = state.ray.getDistanceTraversed();
+
+        ChunkID nextID(VoxelSpaceConversions::voxelToChunk(query.location));
+        if (nextID != id) {
+            query.chunkID = nextID;
+            return query.distance < state.maxDistance;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,105 @@
+///
+/// VoxelRayBatch.h
+/// Seed of Andromeda
+///
+/// Copyright 2014 Regrowth Studios
+/// All Rights Reserved
+///
+/// Summary:
+/// Casts many voxel rays at once, sharing chunk locks between them.
+///
+
+#pragma once
+
+#ifndef VoxelRayBatch_h__
+#define VoxelRayBatch_h__
+
+#include <Vorb/IThreadPoolTask.h>
+#include <atomic>
+
+#include "VRayHelper.h"
+#include "VoxelRay.h"
+#include "VoxPool.h"
+
+class ChunkGrid;
+class VoxelRayBatch;
+
+#define VOXEL_RAY_TASK_ID 7
+// Rays handed to each worker task
+#define VOXEL_RAY_BATCH_TASK_SIZE 64
+
+struct VoxelRayResult {
+    VoxelRayQuery query;
+    bool hit;
+};
+
+/// Casts one slice of a batch's rays
+class VoxelRayTask : public vcore::IThreadPoolTask<WorkerData> {
+public:
+    VoxelRayTask() : vcore::IThreadPoolTask<WorkerData>(VOXEL_RAY_TASK_ID) {}
+
+    void execute(WorkerData* workerData) override;
+
+    void cleanup() override;
+
+    VoxelRayBatch* batch = nullptr;
+    size_t begin;
+    size_t end;
+};
+
+/// Rays are stepped in rounds. Each round sorts the unfinished rays by the
+/// chunk they are in, then acquires and read locks each chunk once and
+/// walks every ray in it until the ray hits, runs out or leaves the chunk.
+/// Rays that start near each other share most of their chunks.
+class VoxelRayBatch {
+    friend class VoxelRayTask;
+public:
+    VoxelRayBatch() : m_runningTasks(0) {}
+    ~VoxelRayBatch();
+
+    /// Adds a ray. Rays can be cast again without re-adding them.
+    /// Only call while no cast is running.
+    void addRay(const f64v3& pos, const f32v3& dir, f64 maxDistance);
+    /// Removes all rays and results. Only call while no cast is running.
+    void clear();
+
+    /// Casts all rays on the calling thread
+    void cast(ChunkGrid& grid, PredBlock f = &solidVoxelPredBlock);
+    /// Splits the rays across the thread pool and returns right away.
+    /// Results can be read once isFinished() is true, or after block().
+    void castAsync(ChunkGrid& grid, vcore::ThreadPool<WorkerData>* threadPool, PredBlock f = &solidVoxelPredBlock);
+
+    /// Blocks current thread until the cast is finished
+    void block();
+    bool isFinished() const { return m_runningTasks == 0; }
+
+    size_t size() const { return m_rays.size(); }
+    const VoxelRayResult& getResult(size_t i) const { return m_results[i]; }
+private:
+    struct RayState {
+        RayState(const f64v3& pos, const f32v3& dir, f64 maxDistance) : pos(pos), dir(dir), ray(pos, f64v3(dir)), maxDistance(maxDistance) {}
+        f64v3 pos;
+        f32v3 dir;
+        VoxelRay ray; ///< Rebuilt from pos and dir at the start of each cast
+        f64 maxDistance;
+    };
+
+    void initResults();
+    void castRange(size_t begin, size_t end);
+    /// Walks a ray through the locked chunk it is in
+    /// @return true if the ray left the chunk and is still going
+    bool stepRay(ui32 r, const Chunk* chunk, bool locked, bool solidTest, bool airMatches);
+    void onTaskFinished();
+
+    std::vector<RayState> m_rays;
+    std::vector<VoxelRayResult> m_results;
+    std::vector<VoxelRayTask*> m_tasks; ///< Kept between casts
+    ChunkGrid* m_grid = nullptr;
+    PredBlock m_pred = nullptr;
+
+    std::atomic<ui32> m_runningTasks;
+    std::mutex m_lock;
+    std::condition_variable m_cond;
+};
+
+#endif // VoxelRayBatch_h__
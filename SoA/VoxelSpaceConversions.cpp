@@ -72,6 +72,74 @@ VoxelPosition3D VoxelSpaceConversions::chunkToVoxel(const ChunkPosition3D& gridP
     return vpos;
 }
 
+// Cube surface points are in doubled chunk units so chunk centers are integers
+static i32v3 chunkToCube(WorldCubeFace face, const i32v3& chunkPos, i32 cubeRadius) {
+    const i32v3& axisMapping = VoxelSpaceConversions::VOXEL_TO_WORLD[face];
+    const i32v2& mults = VoxelSpaceConversions::FACE_TO_WORLD_MULTS[face];
+    i32v3 cubePos;
+    cubePos[axisMapping.x] = (chunkPos.x * 2 + 1) * mults.x;
+    cubePos[axisMapping.y] = cubeRadius * VoxelSpaceConversions::FACE_Y_MULTS[face];
+    cubePos[axisMapping.z] = (chunkPos.z * 2 + 1) * mults.y;
+    return cubePos;
+}
+static i32v3 cubeToChunk(WorldCubeFace face, const i32v3& cubePos, i32 height) {
+    const i32v3& axisMapping = VoxelSpaceConversions::VOXEL_TO_WORLD[face];
+    const i32v2& mults = VoxelSpaceConversions::FACE_TO_WORLD_MULTS[face];
+    return i32v3((cubePos[axisMapping.x] * mults.x - 1) / 2,
+                 height,
+                 (cubePos[axisMapping.z] * mults.y - 1) / 2);
+}
+static WorldCubeFace getCubeFace(int axis, int sign) {
+    for (int i = 0; i < 6; i++) {
+        if (VoxelSpaceConversions::VOXEL_TO_WORLD[i].y == axis &&
+            VoxelSpaceConversions::FACE_Y_MULTS[i] == sign) return (WorldCubeFace)i;
+    }
+    return FACE_NONE;
+}
+
+bool VoxelSpaceConversions::wrapChunkPosition(ChunkPosition3D& chunkPosition, i32 faceChunkRadius) {
+    i32 cubeRadius = faceChunkRadius * 2;
+    bool pastX = abs(chunkPosition.pos.x * 2 + 1) > cubeRadius;
+    bool pastZ = abs(chunkPosition.pos.z * 2 + 1) > cubeRadius;
+    if (!pastX && !pastZ) return true;
+    if (pastX && pastZ) return false;
+
+    i32v3 cubePos = chunkToCube(chunkPosition.face, chunkPosition.pos, cubeRadius);
+    int upAxis = VOXEL_TO_WORLD[chunkPosition.face].y;
+    int edgeAxis = pastX ? VOXEL_TO_WORLD[chunkPosition.face].x : VOXEL_TO_WORLD[chunkPosition.face].z;
+    int edgeSign = cubePos[edgeAxis] > 0 ? 1 : -1;
+    // Distance past the edge becomes distance from the edge on the neighbor
+    i32 folded = cubeRadius * 2 - abs(cubePos[edgeAxis]);
+    if (folded < -cubeRadius) return false;
+    cubePos[upAxis] = folded * FACE_Y_MULTS[chunkPosition.face];
+    cubePos[edgeAxis] = cubeRadius * edgeSign;
+
+    chunkPosition.face = getCubeFace(edgeAxis, edgeSign);
+    chunkPosition.pos = cubeToChunk(chunkPosition.face, cubePos, chunkPosition.pos.y);
+    return true;
+}
+
+bool VoxelSpaceConversions::unwrapChunkPosition(const ChunkPosition3D& chunkPosition, WorldCubeFace face,
+                                                i32 faceChunkRadius, OUT i32v3& result) {
+    if (chunkPosition.face == face) {
+        result = chunkPosition.pos;
+        return true;
+    }
+    int upAxis = VOXEL_TO_WORLD[face].y;
+    int otherUpAxis = VOXEL_TO_WORLD[chunkPosition.face].y;
+    if (upAxis == otherUpAxis) return false;
+
+    i32 cubeRadius = faceChunkRadius * 2;
+    i32v3 cubePos = chunkToCube(chunkPosition.face, chunkPosition.pos, cubeRadius);
+    // Unfold the neighbor face so it continues past face's edge
+    i32 unfolded = cubeRadius * 2 - cubePos[upAxis] * FACE_Y_MULTS[face];
+    cubePos[otherUpAxis] = unfolded * FACE_Y_MULTS[chunkPosition.face];
+    cubePos[upAxis] = cubeRadius * FACE_Y_MULTS[face];
+
+    result = cubeToChunk(face, cubePos, chunkPosition.pos.y);
+    return true;
+}
+
 f64v3 VoxelSpaceConversions::voxelToWorld(const VoxelPosition2D& facePosition, f64 voxelWorldRadius) {
     return voxelToWorldNormalized(facePosition, voxelWorldRadius) * voxelWorldRadius;
 }
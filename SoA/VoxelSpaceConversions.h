@@ -76,6 +76,23 @@ namespace VoxelSpaceConversions {
     extern VoxelPosition2D chunkToVoxel(const ChunkPosition2D& gridPosition);
     extern VoxelPosition3D chunkToVoxel(const ChunkPosition3D& gridPosition);
    
+
+    /// Moves a chunk position that lies past an edge of its face onto the
+    /// neighboring face by folding it over the cube edge. Height is kept.
+    /// @param chunkPosition: The chunk grid position, modified in place
+    /// @param faceChunkRadius: Half the width of a face in chunks
+    /// @return false if the position is past two edges, where no chunk exists
+    extern bool wrapChunkPosition(ChunkPosition3D& chunkPosition, i32 faceChunkRadius);
+    /// Inverse of wrapChunkPosition. Expresses a chunk position on face or one
+    /// of its neighbors in face's chunk space, extended past its edges.
+    /// @param chunkPosition: The chunk grid position
+    /// @param face: Face whose chunk space to use
+    /// @param faceChunkRadius: Half the width of a face in chunks
+    /// @param result: The chunk position in face's chunk space
+    /// @return false if chunkPosition is on the opposite face
+    extern bool unwrapChunkPosition(const ChunkPosition3D& chunkPosition, WorldCubeFace face,
+                                    i32 faceChunkRadius, OUT i32v3& result);
+
     /// Converts from face-space to world-space
     /// @param facePosition: The face position
     /// @param voxelWorldRadius: Radius of the world in units of voxels
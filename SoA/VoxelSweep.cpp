@@ -0,0 +1,133 @@
+#include "stdafx.h"
+#include "VoxelSweep.h"
+
+#include "ChunkGrid.h"
+#include "ChunkLock.h"
+#include "VoxelSpaceConversions.h"
+
+// Keeps faces that are exactly touching a voxel from counting as overlap
+#define SWEEP_EPSILON 0.00001
+// Contacts resolved per moveAndSlide, one for each axis
+#define MAX_SLIDE_ITERATIONS 3
+
+VoxelSweepResult VoxelSweep::sweepAABB(ChunkGrid& grid, const f64v3& boxMin, const f64v3& boxSize, const f64v3& motion) {
+    VoxelSweepResult result;
+    f64v3 boxMax = boxMin + boxSize;
+
+    // Read lock every chunk the swept box can touch up front
+    i32v3 minChunk = VoxelSpaceConversions::voxelToChunk(i32v3(vmath::floor(vmath::min(boxMin, boxMin + motion))));
+    i32v3 maxChunk = VoxelSpaceConversions::voxelToChunk(i32v3(vmath::floor(vmath::max(boxMax, boxMax + motion))));
+    i32v3 chunkDims = maxChunk - minChunk + i32v3(1);
+    std::vector<ChunkHandle> handles;
+    std::vector<Chunk*> chunks; ///< Null if not generated
+    handles.reserve(chunkDims.x * chunkDims.y * chunkDims.z);
+    chunks.reserve(handles.capacity());
+    MultiChunkLock lock;
+    for (int y = 0; y < chunkDims.y; y++) {
+        for (int z = 0; z < chunkDims.z; z++) {
+            for (int x = 0; x < chunkDims.x; x++) {
+                handles.push_back(grid.accessor.acquire(ChunkID(minChunk + i32v3(x, y, z))));
+                Chunk* chunk = handles.back();
+                if (chunk->genLevel == GEN_DONE) {
+                    lock.add(chunk, ChunkLockMode::READ);
+                    chunks.push_back(chunk);
+                } else {
+                    chunks.push_back(nullptr);
+                }
+            }
+        }
+    }
+    lock.lock();
+
+    auto collides = [&](const i32v3& p) {
+        i32v3 cpos = VoxelSpaceConversions::voxelToChunk(p);
+        i32v3 offset = cpos - minChunk;
+        if (offset.x < 0 || offset.y < 0 || offset.z < 0 ||
+            offset.x >= chunkDims.x || offset.y >= chunkDims.y || offset.z >= chunkDims.z) return false;
+        Chunk* chunk = chunks[(offset.y * chunkDims.z + offset.z) * chunkDims.x + offset.x];
+        if (!chunk || chunk->collidable.empty()) return false;
+        i32v3 cp = p - cpos * CHUNK_WIDTH;
+        return chunk->collidable.get((ui16)(cp.y * CHUNK_LAYER + cp.z * CHUNK_WIDTH + cp.x));
+    };
+
+    // The box first overlaps a voxel by crossing one of its faces, so each axis
+    // can be marched on its own and the earliest contact wins.
+    for (int a = 0; a < 3; a++) {
+        f64 d = motion[a];
+        if (d == 0.0) continue;
+        int b = (a + 1) % 3;
+        int c = (a + 2) % 3;
+
+        // Plane the leading face crosses next, and the voxel layer behind it
+        f64 lead;
+        i32 plane, layer, step;
+        if (d > 0.0) {
+            lead = boxMax[a];
+            plane = (i32)ceil(lead - SWEEP_EPSILON);
+            layer = plane;
+            step = 1;
+        } else {
+            lead = boxMin[a];
+            plane = (i32)floor(lead + SWEEP_EPSILON);
+            layer = plane - 1;
+            step = -1;
+        }
+
+        for (;; plane += step, layer += step) {
+            f64 t = vmath::max((plane - lead) / d, 0.0);
+            if (t >= result.toi) break;
+
+            // Face extents on the other axes at the time of crossing
+            i32 minB = (i32)floor(boxMin[b] + motion[b] * t + SWEEP_EPSILON);
+            i32 maxB = (i32)floor(boxMax[b] + motion[b] * t - SWEEP_EPSILON);
+            i32 minC = (i32)floor(boxMin[c] + motion[c] * t + SWEEP_EPSILON);
+            i32 maxC = (i32)floor(boxMax[c] + motion[c] * t - SWEEP_EPSILON);
+
+            bool hit = false;
+            i32v3 p;
+            p[a] = layer;
+            for (p[b] = minB; p[b] <= maxB && !hit; p[b]++) {
+                for (p[c] = minC; p[c] <= maxC; p[c]++) {
+                    if (collides(p)) {
+                        hit = true;
+                        break;
+                    }
+                }
+            }
+            if (hit) {
+                result.toi = t;
+                result.normal = i32v3(0);
+                result.normal[a] = -step;
+                result.hit = true;
+                break;
+            }
+        }
+    }
+
+    lock.unlock();
+    for (auto& h : handles) {
+        h.release();
+    }
+    return result;
+}
+
+f64v3 VoxelSweep::moveAndSlide(ChunkGrid& grid, f64v3& boxMin, const f64v3& boxSize, f64v3& velocity, f64v3 motion) {
+    f64v3 moved(0.0);
+    for (int i = 0; i < MAX_SLIDE_ITERATIONS; i++) {
+        if (motion.x == 0.0 && motion.y == 0.0 && motion.z == 0.0) break;
+        VoxelSweepResult result = sweepAABB(grid, boxMin, boxSize, motion);
+        f64v3 delta = motion * result.toi;
+        boxMin += delta;
+        moved += delta;
+        if (!result.hit) break;
+
+        // Slide the rest of the motion along the contact face
+        motion -= delta;
+        for (int a = 0; a < 3; a++) {
+            if (result.normal[a] == 0) continue;
+            motion[a] = 0.0;
+            if (velocity[a] * result.normal[a] < 0.0) velocity[a] = 0.0;
+        }
+    }
+    return moved;
+}
@@ -0,0 +1,44 @@
+///
+/// VoxelSweep.h
+/// Seed of Andromeda
+///
+/// Copyright 2014 Regrowth Studios
+/// All Rights Reserved
+///
+/// Summary:
+/// Continuous collision of moving boxes against collidable voxels.
+///
+
+#pragma once
+
+#ifndef VoxelSweep_h__
+#define VoxelSweep_h__
+
+class ChunkGrid;
+
+struct VoxelSweepResult {
+    f64 toi = 1.0; ///< Fraction of the motion before contact, 1.0 if nothing was hit
+    i32v3 normal = i32v3(0); ///< Contact normal, zero if nothing was hit
+    bool hit = false;
+};
+
+class VoxelSweep {
+public:
+    /// Sweeps a box along motion and finds the first collidable voxel it touches.
+    /// Marches each moving axis one voxel slab at a time and only reads the layer
+    /// the leading face is entering, so fast boxes can't tunnel through walls.
+    /// Voxels in chunks that aren't generated don't collide.
+    /// @param boxMin: Minimum corner of the box in grid space
+    /// @param boxSize: x, y, z widths of the box in blocks
+    /// @param motion: Displacement to sweep through
+    static VoxelSweepResult sweepAABB(ChunkGrid& grid, const f64v3& boxMin, const f64v3& boxSize, const f64v3& motion);
+
+    /// Moves the box by motion, sliding along the faces it hits.
+    /// @param boxMin: Minimum corner of the box, updated to the final position
+    /// @param velocity: Zeroed along each contact normal
+    /// @param motion: Displacement to apply
+    /// @return the total offset that was applied to boxMin
+    static f64v3 moveAndSlide(ChunkGrid& grid, f64v3& boxMin, const f64v3& boxSize, f64v3& velocity, f64v3 motion);
+};
+
+#endif // VoxelSweep_h__
@@ -43,4 +43,26 @@ inline int getBlockIndexFromPos(T x, T y, T z) {
 template <typename T>
 inline int getBlockIndexFromPos(const T& pos) {
     return pos.x | (pos.y << 10) | (pos.z << 5);
-}
\ No newline at end of file
+}
+// Faces are ordered -x, +x, -y, +y, -z, +z like vvox::Cardinal and Chunk::neighbors
+
+// Offset to the neighbor voxel across each face within a chunk
+const int VOXEL_FACE_OFFSETS[6] = { -1, 1, -CHUNK_LAYER, CHUNK_LAYER, -CHUNK_WIDTH, CHUNK_WIDTH };
+// Offset to the neighbor voxel across each face when it is in the adjacent chunk
+const int VOXEL_WRAP_OFFSETS[6] = {
+    CHUNK_WIDTH - 1, -(CHUNK_WIDTH - 1),
+    CHUNK_SIZE - CHUNK_LAYER, -(CHUNK_SIZE - CHUNK_LAYER),
+    CHUNK_LAYER - CHUNK_WIDTH, -(CHUNK_LAYER - CHUNK_WIDTH)
+};
+
+// True if the voxel's neighbor across face is in the adjacent chunk
+inline bool isBlockIndexOnFace(int blockIndex, int face) {
+    switch (face) {
+        case 0: return (blockIndex & 0x1f) == 0;
+        case 1: return (blockIndex & 0x1f) == CHUNK_WIDTH - 1;
+        case 2: return (blockIndex >> 10) == 0;
+        case 3: return (blockIndex >> 10) == CHUNK_WIDTH - 1;
+        case 4: return ((blockIndex >> 5) & 0x1f) == 0;
+        default: return ((blockIndex >> 5) & 0x1f) == CHUNK_WIDTH - 1;
+    }
+}